@@ -0,0 +1,446 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "song.h"
+#include "concurrent_song_lookup.h"
+#include "catalog_importer.h"
+#include "write_ahead_log.h"
+#include "playlist_sorter.h"
+#include "column_kernels.h"
+#include "library.h"
+#include "library_store.h"
+
+using namespace std;
+
+// Benchmarks for the PlayWise engines. Run with no arguments for every suite,
+// or pass suite names (e.g. "lookup") to run a subset.
+
+static vector<Song> makeCatalog(int count) {
+    vector<Song> songs;
+    songs.reserve(count);
+    for (int i = 0; i < count; i++) {
+        songs.emplace_back("Song " + to_string(i), "Artist " + to_string(i % 997), 120 + i % 300);
+    }
+    return songs;
+}
+
+static unsigned int maxThreads() {
+    unsigned int hardware = thread::hardware_concurrency();
+    return hardware == 0 ? 4 : hardware;
+}
+
+// Reader throughput of ConcurrentSongLookup as reader threads are added,
+// with one writer thread replacing songs the whole time.
+static void benchmarkConcurrentLookup() {
+    cout << "\n=== ConcurrentSongLookup reader scaling ===\n";
+    const int catalogSize = 200000;
+    const auto runTime = chrono::milliseconds(500);
+    
+    vector<Song> catalog = makeCatalog(catalogSize);
+    ConcurrentSongLookup lookup;
+    lookup.addSongs(catalog);
+    
+    vector<string> keys;
+    keys.reserve(catalog.size());
+    for (const auto& song : catalog) {
+        keys.push_back(lookup.makeKey(song.title));
+    }
+    
+    double baseline = 0.0;
+    for (unsigned int threads = 1; threads <= maxThreads() * 2; threads *= 2) {
+        atomic<bool> stop{false};
+        atomic<long long> totalOps{0};
+        
+        thread writer([&] {
+            size_t i = 0;
+            while (!stop.load(memory_order_relaxed)) {
+                lookup.addSong(catalog[i++ % catalog.size()]);
+            }
+        });
+        
+        vector<thread> readers;
+        for (unsigned int t = 0; t < threads; t++) {
+            readers.emplace_back([&, t] {
+                long long ops = 0;
+                size_t index = t * 7919;
+                while (!stop.load(memory_order_relaxed)) {
+                    for (int batch = 0; batch < 256; batch++) {
+                        index = (index + 104729) % keys.size();
+                        if (batch & 1) {
+                            lookup.searchByKey(keys[index]);
+                        } else {
+                            lookup.searchById(catalog[index].id);
+                        }
+                    }
+                    ops += 256;
+                }
+                totalOps += ops;
+            });
+        }
+        
+        this_thread::sleep_for(runTime);
+        stop = true;
+        for (auto& reader : readers) reader.join();
+        writer.join();
+        
+        double opsPerSecond = totalOps.load() / (runTime.count() / 1000.0);
+        if (threads == 1) baseline = opsPerSecond;
+        cout << threads << " reader thread(s): " << static_cast<long long>(opsPerSecond)
+             << " lookups/s (speedup " << opsPerSecond / baseline << "x)\n";
+    }
+}
+
+// CSV parse and import throughput on a generated catalog
+static void benchmarkCatalogImport() {
+    cout << "\n=== CatalogImporter throughput ===\n";
+    const int rowCount = 1000000;
+    
+    string csv = "title,artist,duration,rating\n";
+    csv.reserve(rowCount * 40);
+    for (int i = 0; i < rowCount; i++) {
+        csv += "Song " + to_string(i) + ",Artist " + to_string(i % 997) + "," +
+               to_string(120 + i % 300) + "," + to_string(i % 6) + "\n";
+    }
+    
+    CatalogImporter importer;
+    for (unsigned int threads = 1; threads <= maxThreads(); threads *= 2) {
+        ImportOptions options;
+        options.threadCount = threads;
+        auto start = chrono::high_resolution_clock::now();
+        vector<CatalogRow> rows = importer.parse(csv.data(), csv.size(), options);
+        auto end = chrono::high_resolution_clock::now();
+        double seconds = chrono::duration<double>(end - start).count();
+        cout << "Parse only, " << threads << " thread(s): " << rows.size() << " rows in "
+             << seconds * 1000 << " ms (" << static_cast<long long>(rows.size() / seconds) << " rows/s)\n";
+    }
+    
+    PlaylistEngine engine;
+    SongLookup lookup;
+    SongRatingTree ratingTree;
+    ImportResult result = importer.importBuffer(csv.data(), csv.size(), &engine, &lookup, &ratingTree);
+    double totalSeconds = (result.parseMicroseconds + result.loadMicroseconds) / 1e6;
+    cout << "Full import: " << result.rowsImported << " rows (parse " << result.parseMicroseconds / 1000
+         << " ms, load " << result.loadMicroseconds / 1000 << " ms, "
+         << static_cast<long long>(result.rowsImported / totalSeconds) << " rows/s end to end)\n";
+    
+    // Parsing is a small share of the import. Most of the load is the lookup:
+    // one node allocation and one cache-missing bucket insert per song in
+    // each of its two hash maps
+    long long songMicroseconds = result.loadMicroseconds - result.playlistMicroseconds -
+                                 result.lookupMicroseconds - result.ratingsMicroseconds;
+    const pair<const char*, long long> stages[] = {
+        {"songs", songMicroseconds},
+        {"playlist", result.playlistMicroseconds},
+        {"lookup", result.lookupMicroseconds},
+        {"ratings", result.ratingsMicroseconds},
+    };
+    const auto* slowest = &stages[0];
+    cout << "Load breakdown:";
+    for (const auto& stage : stages) {
+        cout << " " << stage.first << " " << stage.second / 1000 << " ms";
+        if (stage.second > slowest->second) slowest = &stage;
+    }
+    cout << " (bottleneck: " << slowest->first << ")\n";
+}
+
+// Cost of logging playlist edits under each sync policy, against no log at all
+static void benchmarkWriteAheadLog() {
+    cout << "\n=== WriteAheadLog append cost ===\n";
+    const int opCount = 200000;
+    vector<Song> songs = makeCatalog(opCount);
+    const string path = "playwise_bench.wal";
+    
+    struct Mode { const char* name; bool logged; WalSyncPolicy policy; };
+    const Mode modes[] = {
+        {"no log", false, WalSyncPolicy::NONE},
+        {"log, no sync", true, WalSyncPolicy::NONE},
+        {"log, group commit", true, WalSyncPolicy::INTERVAL},
+    };
+    
+    for (const Mode& mode : modes) {
+        remove(path.c_str());
+        PlaylistEngine engine;
+        WriteAheadLog wal;
+        if (mode.logged) {
+            WalOptions options;
+            options.syncPolicy = mode.policy;
+            wal.open(path, options);
+            engine.setWriteAheadLog(&wal);
+        }
+        
+        auto start = chrono::high_resolution_clock::now();
+        for (const Song& song : songs) {
+            engine.addSong(song);
+        }
+        if (mode.logged) wal.sync();
+        auto end = chrono::high_resolution_clock::now();
+        double nanos = chrono::duration<double, nano>(end - start).count();
+        cout << mode.name << ": " << static_cast<long long>(nanos / opCount) << " ns/addSong\n";
+        
+        engine.setWriteAheadLog(nullptr);
+    }
+    
+    // One commit per edit: every append waits for its own fsync
+    remove(path.c_str());
+    {
+        const int syncedOps = 200;
+        PlaylistEngine engine;
+        WriteAheadLog wal;
+        WalOptions options;
+        options.syncPolicy = WalSyncPolicy::PER_COMMIT;
+        wal.open(path, options);
+        engine.setWriteAheadLog(&wal);
+        auto start = chrono::high_resolution_clock::now();
+        for (int i = 0; i < syncedOps; i++) {
+            engine.addSong(songs[i]);
+        }
+        auto end = chrono::high_resolution_clock::now();
+        double nanos = chrono::duration<double, nano>(end - start).count();
+        cout << "log, fsync per commit: " << static_cast<long long>(nanos / syncedOps) << " ns/addSong\n";
+        engine.setWriteAheadLog(nullptr);
+    }
+    remove(path.c_str());
+}
+
+// Multi-key sort time as sorter threads are added; every run must match the
+// serial order exactly
+static void benchmarkParallelSort() {
+    cout << "\n=== PlaylistSorter scaling ===\n";
+    const int songCount = 1000000;
+    vector<Song> songs = makeCatalog(songCount);
+    const vector<SortKey> keys = {{SortField::ARTIST, true}, {SortField::DURATION, false}, {SortField::TITLE, true}};
+    
+    PlaylistSorter sorter;
+    vector<Song> serial;
+    double serialSeconds = 0;
+    for (unsigned int threads = 1; threads <= maxThreads(); threads *= 2) {
+        sorter.setThreadCount(threads);
+        auto start = chrono::high_resolution_clock::now();
+        vector<Song> sorted = sorter.sortBy(songs, keys);
+        auto end = chrono::high_resolution_clock::now();
+        double seconds = chrono::duration<double>(end - start).count();
+        
+        bool matches = true;
+        if (threads == 1) {
+            serial = move(sorted);
+            serialSeconds = seconds;
+        } else {
+            for (size_t i = 0; i < serial.size() && matches; i++) {
+                matches = serial[i].id == sorted[i].id;
+            }
+        }
+        cout << threads << " thread(s): " << songCount << " songs in " << seconds * 1000 << " ms (speedup "
+             << serialSeconds / seconds << "x" << (matches ? "" : ", ORDER MISMATCH") << ")\n";
+    }
+}
+
+// Statistics scans over 10M-row columns with each kernel set the CPU
+// supports, against the same statistics computed from Song objects. Every
+// kernel set must reproduce the scalar results.
+static void benchmarkColumnKernels() {
+    cout << "\n=== Column kernels (10M rows) ===\n";
+    const size_t rowCount = 10000000;
+    const int bandCount = 11;
+    vector<int32_t> durations(rowCount);
+    vector<int8_t> ratings(rowCount);
+    mt19937 random(42);
+    for (size_t i = 0; i < rowCount; i++) {
+        durations[i] = static_cast<int32_t>(30 + random() % 900);
+        ratings[i] = static_cast<int8_t>(random() % 6);
+    }
+    vector<uint32_t> rows(rowCount);
+    
+    // Best of several runs; the result feeds a checksum so nothing is optimized away
+    auto timeRuns = [](const function<unsigned long long()>& scan, unsigned long long& checksum) {
+        double best = 1e9;
+        for (int run = 0; run < 5; run++) {
+            auto start = chrono::high_resolution_clock::now();
+            checksum = scan();
+            auto end = chrono::high_resolution_clock::now();
+            best = min(best, chrono::duration<double>(end - start).count());
+        }
+        return best;
+    };
+    
+    struct Scan {
+        const char* name;
+        size_t bytes;
+        function<unsigned long long(const ColumnKernelTable&)> run;
+    };
+    const vector<Scan> scans = {
+        {"sum", rowCount * 4, [&](const ColumnKernelTable& k) {
+            return static_cast<unsigned long long>(k.sumInt32(durations.data(), rowCount));
+        }},
+        {"min/max", rowCount * 4, [&](const ColumnKernelTable& k) {
+            int32_t low = 0;
+            int32_t high = 0;
+            k.minMaxInt32(durations.data(), rowCount, low, high);
+            return static_cast<unsigned long long>(low) * 100000 + high;
+        }},
+        {"rating histogram", rowCount, [&](const ColumnKernelTable& k) {
+            size_t counts[6] = {};
+            k.ratingHistogram(ratings.data(), rowCount, counts);
+            unsigned long long mix = 0;
+            for (size_t c : counts) mix = mix * 31 + c;
+            return mix;
+        }},
+        {"duration bands", rowCount * 4, [&](const ColumnKernelTable& k) {
+            vector<size_t> counts(bandCount, 0);
+            k.bandHistogram(durations.data(), rowCount, 60, counts.data(), bandCount);
+            unsigned long long mix = 0;
+            for (size_t c : counts) mix = mix * 31 + c;
+            return mix;
+        }},
+        {"count 180-300s", rowCount * 4, [&](const ColumnKernelTable& k) {
+            return static_cast<unsigned long long>(k.countInRange(durations.data(), rowCount, 180, 300));
+        }},
+        {"select 600s+", rowCount * 4, [&](const ColumnKernelTable& k) {
+            size_t matches = k.selectInRange(durations.data(), rowCount, 600, INT32_MAX, rows.data());
+            return static_cast<unsigned long long>(matches) + rows[matches / 2];
+        }},
+    };
+    
+    vector<KernelIsa> isas = {KernelIsa::SCALAR};
+    if (ColumnKernels::isSupported(KernelIsa::SSE4_2)) isas.push_back(KernelIsa::SSE4_2);
+    if (ColumnKernels::isSupported(KernelIsa::AVX2)) isas.push_back(KernelIsa::AVX2);
+    cout << "Active kernels: " << ColumnKernels::name(ColumnKernels::active().isa) << "\n";
+    
+    for (const auto& scan : scans) {
+        double scalarSeconds = 0;
+        unsigned long long expected = 0;
+        for (KernelIsa isa : isas) {
+            const ColumnKernelTable& kernels = ColumnKernels::forIsa(isa);
+            unsigned long long checksum = 0;
+            double seconds = timeRuns([&]() { return scan.run(kernels); }, checksum);
+            if (isa == KernelIsa::SCALAR) {
+                scalarSeconds = seconds;
+                expected = checksum;
+            }
+            printf("%-17s %-7s %8.2f ms %7.2f GB/s  speedup %5.2fx%s\n", scan.name, ColumnKernels::name(isa),
+                   seconds * 1000, scan.bytes / seconds / 1e9, scalarSeconds / seconds,
+                   checksum == expected ? "" : "  RESULT MISMATCH");
+        }
+    }
+    
+    // The same sum, extremes and rating histogram from Song objects, as the
+    // snapshot computed them before the column store
+    vector<Song> songs;
+    songs.reserve(rowCount);
+    for (size_t i = 0; i < rowCount; i++) {
+        songs.emplace_back("", "", durations[i]);
+    }
+    unsigned long long checksum = 0;
+    double objectSeconds = timeRuns([&]() {
+        long long total = 0;
+        int shortest = INT32_MAX;
+        int longest = INT32_MIN;
+        for (const Song& song : songs) {
+            total += song.duration;
+            shortest = min(shortest, song.duration);
+            longest = max(longest, song.duration);
+        }
+        return static_cast<unsigned long long>(total + shortest + longest);
+    }, checksum);
+    const ColumnKernelTable& kernels = ColumnKernels::active();
+    double columnSeconds = timeRuns([&]() {
+        int32_t shortest = 0;
+        int32_t longest = 0;
+        kernels.minMaxInt32(durations.data(), rowCount, shortest, longest);
+        return static_cast<unsigned long long>(kernels.sumInt32(durations.data(), rowCount) + shortest + longest);
+    }, checksum);
+    printf("sum+min/max: Song objects %.2f ms, columns (%s) %.2f ms, %.1fx\n", objectSeconds * 1000,
+           ColumnKernels::name(kernels.isa), columnSeconds * 1000, objectSeconds / columnSeconds);
+}
+
+// Recency filters over plays spread across the last two days, live and after
+// a save and load. Plays keep their own time, so both libraries must see
+// exactly half the catalog as played within the last day.
+static void benchmarkFilterRecency() {
+    cout << "\n=== SongFilterIndex recency after load ===\n";
+    const int songCount = 100000;
+    const string path = "playwise_bench.lib";
+    auto now = chrono::system_clock::now();
+    
+    Library live;
+    live.addSongs(makeCatalog(songCount));
+    vector<Song> catalog = live.playlist().getSongs();
+    {
+        EventBatch batch(&live.events());
+        // Oldest first: the play log keeps plays in time order
+        for (int i = 0; i < songCount; i++) {
+            live.history().addPlayedSong(catalog[i], now - chrono::hours(47 - i * 48LL / songCount));
+        }
+    }
+    
+    LibraryStore store;
+    Library loaded;
+    auto start = chrono::high_resolution_clock::now();
+    bool ok = store.save(path, live.playlist(), live.history(), live.ratings(), live.lookup()) &&
+              store.load(path, loaded.playlist(), loaded.history(), loaded.ratings(), loaded.lookup());
+    loaded.rebuildIndexes();
+    auto end = chrono::high_resolution_clock::now();
+    remove(path.c_str());
+    if (!ok) {
+        cout << "Save/load failed: " << store.getLastError() << "\n";
+        return;
+    }
+    cout << "Save, load and rebuild: " << chrono::duration<double, milli>(end - start).count() << " ms\n";
+    
+    SongFilter played;
+    played.playedWithinHours = 24;
+    SongFilter notPlayed;
+    notPlayed.notPlayedWithinHours = 24;
+    const size_t expected = songCount / 2;
+    const pair<const char*, const Library*> libraries[] = {{"live", &live}, {"loaded", &loaded}};
+    for (const auto& library : libraries) {
+        start = chrono::high_resolution_clock::now();
+        size_t playedCount = library.second->countSongs(played);
+        size_t notPlayedCount = library.second->countSongs(notPlayed);
+        end = chrono::high_resolution_clock::now();
+        printf("%-6s played within 24h %zu, not played %zu, %.3f ms%s\n", library.first, playedCount,
+               notPlayedCount, chrono::duration<double, milli>(end - start).count(),
+               playedCount == expected && notPlayedCount == expected ? "" : "  RESULT MISMATCH");
+    }
+}
+
+static bool shouldRun(const vector<string>& suites, const string& name) {
+    if (suites.empty()) return true;
+    for (const auto& suite : suites) {
+        if (suite == name) return true;
+    }
+    return false;
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> suites(argv + 1, argv + argc);
+    
+    if (shouldRun(suites, "lookup")) {
+        benchmarkConcurrentLookup();
+    }
+    if (shouldRun(suites, "import")) {
+        benchmarkCatalogImport();
+    }
+    if (shouldRun(suites, "wal")) {
+        benchmarkWriteAheadLog();
+    }
+    if (shouldRun(suites, "sort")) {
+        benchmarkParallelSort();
+    }
+    if (shouldRun(suites, "columns")) {
+        benchmarkColumnKernels();
+    }
+    if (shouldRun(suites, "filters")) {
+        benchmarkFilterRecency();
+    }
+    
+    return 0;
+}
@@ -0,0 +1,310 @@
+#include "catalog_importer.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+const char* findByte(const char* begin, const char* end, char byte) {
+    const void* found = std::memchr(begin, byte, static_cast<size_t>(end - begin));
+    return found ? static_cast<const char*>(found) : end;
+}
+
+std::string_view trim(std::string_view field) {
+    while (!field.empty() && (field.front() == ' ' || field.front() == '\t')) field.remove_prefix(1);
+    while (!field.empty() && (field.back() == ' ' || field.back() == '\t')) field.remove_suffix(1);
+    return field;
+}
+
+// Appends one decimal digit; false if the value would no longer fit in an int
+bool appendDigit(int& value, char digit) {
+    int next = digit - '0';
+    if (value > (INT_MAX - next) / 10) return false;
+    value = value * 10 + next;
+    return true;
+}
+
+// Parses "354" or "5:54"; returns -1 on malformed input or overflow
+int parseDuration(std::string_view field) {
+    field = trim(field);
+    if (field.empty()) return -1;
+    
+    int total = 0;
+    int current = 0;
+    bool sawDigit = false;
+    for (char c : field) {
+        if (c >= '0' && c <= '9') {
+            if (!appendDigit(current, c)) return -1;
+            sawDigit = true;
+        } else if (c == ':' && sawDigit) {
+            if (total > INT_MAX - current || total + current > INT_MAX / 60) return -1;
+            total = (total + current) * 60;
+            current = 0;
+            sawDigit = false;
+        } else {
+            return -1;
+        }
+    }
+    if (!sawDigit || total > INT_MAX - current) return -1;
+    return total + current;
+}
+
+// Parses an integer rating, ignoring any fractional part ("4.5" -> 4);
+// returns -1 on overflow
+int parseRating(std::string_view field) {
+    field = trim(field);
+    int rating = 0;
+    for (char c : field) {
+        if (c < '0' || c > '9') break;
+        if (!appendDigit(rating, c)) return -1;
+    }
+    return rating;
+}
+
+// Reads one field starting at p and leaves p just past the delimiter.
+// Returns false if the line has no more fields.
+bool nextField(const char*& p, const char* lineEnd, char delimiter,
+               std::string_view& field, bool& escaped) {
+    if (p > lineEnd) return false;
+    escaped = false;
+    
+    if (p < lineEnd && *p == '"') {
+        const char* start = ++p;
+        const char* close = findByte(p, lineEnd, '"');
+        while (close + 1 < lineEnd && close[1] == '"') {
+            escaped = true;
+            close = findByte(close + 2, lineEnd, '"');
+        }
+        field = std::string_view(start, static_cast<size_t>(close - start));
+        p = findByte(std::min(close + 1, lineEnd), lineEnd, delimiter) + 1;
+        return true;
+    }
+    
+    const char* end = findByte(p, lineEnd, delimiter);
+    field = trim(std::string_view(p, static_cast<size_t>(end - p)));
+    p = end + 1;
+    return true;
+}
+
+std::string unescape(std::string_view field) {
+    std::string result;
+    result.reserve(field.size());
+    for (size_t i = 0; i < field.size(); i++) {
+        result += field[i];
+        if (field[i] == '"' && i + 1 < field.size() && field[i + 1] == '"') {
+            i++;
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+char CatalogImporter::detectDelimiter(const char* data, size_t size) {
+    const char* lineEnd = findByte(data, data + size, '\n');
+    size_t tabs = std::count(data, lineEnd, '\t');
+    size_t commas = std::count(data, lineEnd, ',');
+    return tabs > 0 && tabs >= commas ? '\t' : ',';
+}
+
+size_t CatalogImporter::skipHeader(const char* data, size_t size, char delimiter) {
+    const char* lineEnd = findByte(data, data + size, '\n');
+    const char* p = data;
+    std::string_view field;
+    bool escaped = false;
+    
+    // A header is a first line whose duration column is not a number
+    for (int column = 0; column < 3; column++) {
+        if (!nextField(p, lineEnd, delimiter, field, escaped)) {
+            return 0;
+        }
+    }
+    if (!field.empty() && field.back() == '\r') field.remove_suffix(1);
+    if (parseDuration(field) >= 0) {
+        return 0;
+    }
+    return lineEnd < data + size ? static_cast<size_t>(lineEnd - data) + 1 : size;
+}
+
+void CatalogImporter::parseRange(const char* begin, const char* end, char delimiter,
+                                 std::vector<CatalogRow>& rows, size_t& skipped) {
+    const char* lineStart = begin;
+    
+    while (lineStart < end) {
+        const char* newline = findByte(lineStart, end, '\n');
+        const char* lineEnd = newline;
+        if (lineEnd > lineStart && lineEnd[-1] == '\r') lineEnd--;
+        
+        if (lineEnd > lineStart) {
+            CatalogRow row;
+            std::string_view durationField;
+            std::string_view ratingField;
+            bool escaped = false;
+            const char* p = lineStart;
+            
+            bool complete = nextField(p, lineEnd, delimiter, row.title, row.titleEscaped) &&
+                            nextField(p, lineEnd, delimiter, row.artist, row.artistEscaped) &&
+                            nextField(p, lineEnd, delimiter, durationField, escaped);
+            if (complete && nextField(p, lineEnd, delimiter, ratingField, escaped)) {
+                row.rating = parseRating(ratingField);
+            }
+            row.duration = complete ? parseDuration(durationField) : -1;
+            
+            if (row.duration >= 0 && row.rating >= 0 && !row.title.empty()) {
+                rows.push_back(row);
+            } else {
+                skipped++;
+            }
+        }
+        
+        lineStart = newline + 1;
+    }
+}
+
+Song CatalogImporter::materialize(const CatalogRow& row) {
+    Song song;
+    if (row.titleEscaped) {
+        song.title = unescape(row.title);
+    } else {
+        song.title.assign(row.title.data(), row.title.size());
+    }
+    if (row.artistEscaped) {
+        song.artist = unescape(row.artist);
+    } else {
+        song.artist.assign(row.artist.data(), row.artist.size());
+    }
+    song.duration = row.duration;
+    return song;
+}
+
+std::vector<CatalogRow> CatalogImporter::parse(const char* data, size_t size, const ImportOptions& options,
+                                               size_t* skipped) {
+    std::vector<CatalogRow> rows;
+    size_t skippedRows = 0;
+    
+    if (size > 0) {
+        char delimiter = options.delimiter ? options.delimiter : detectDelimiter(data, size);
+        size_t offset = skipHeader(data, size, delimiter);
+        const char* begin = data + offset;
+        const char* end = data + size;
+        
+        // Give each thread at least 1 MiB; smaller chunks are not worth the start-up cost
+        size_t remaining = static_cast<size_t>(end - begin);
+        size_t usefulThreads = std::max<size_t>(1, remaining >> 20);
+        unsigned int threads = static_cast<unsigned int>(
+            std::min<size_t>(std::max(1u, options.threadCount), usefulThreads));
+        
+        if (threads == 1) {
+            rows.reserve(remaining / 32);
+            parseRange(begin, end, delimiter, rows, skippedRows);
+        } else {
+            // Split on line boundaries; each thread parses into its own vector
+            std::vector<const char*> bounds(threads + 1);
+            bounds[0] = begin;
+            bounds[threads] = end;
+            for (unsigned int t = 1; t < threads; t++) {
+                const char* guess = begin + remaining * t / threads;
+                guess = std::max(guess, bounds[t - 1]);
+                const char* newline = findByte(guess, end, '\n');
+                bounds[t] = newline < end ? newline + 1 : end;
+            }
+            
+            std::vector<std::vector<CatalogRow>> chunkRows(threads);
+            std::vector<size_t> chunkSkipped(threads, 0);
+            std::vector<std::thread> workers;
+            for (unsigned int t = 0; t < threads; t++) {
+                workers.emplace_back([&, t] {
+                    chunkRows[t].reserve(static_cast<size_t>(bounds[t + 1] - bounds[t]) / 32);
+                    parseRange(bounds[t], bounds[t + 1], delimiter, chunkRows[t], chunkSkipped[t]);
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            
+            size_t total = 0;
+            for (const auto& chunk : chunkRows) total += chunk.size();
+            rows.reserve(total);
+            for (unsigned int t = 0; t < threads; t++) {
+                rows.insert(rows.end(), chunkRows[t].begin(), chunkRows[t].end());
+                skippedRows += chunkSkipped[t];
+            }
+        }
+    }
+    
+    if (skipped) *skipped = skippedRows;
+    return rows;
+}
+
+ImportResult CatalogImporter::importBuffer(const char* data, size_t size, PlaylistEngine* engine,
+                                           SongLookup* lookup, SongRatingTree* ratingTree,
+                                           const ImportOptions& options) {
+    ImportResult result;
+    result.bytesRead = size;
+    
+    auto parseStart = std::chrono::high_resolution_clock::now();
+    std::vector<CatalogRow> rows = parse(data, size, options, &result.rowsSkipped);
+    auto parseEnd = std::chrono::high_resolution_clock::now();
+    
+    // Songs are created on this thread so ids follow file order
+    size_t batchSize = std::max<size_t>(1, options.batchSize);
+    std::vector<Song> songs;
+    std::vector<std::pair<Song, int>> ratedSongs;
+    songs.reserve(std::min(batchSize, rows.size()));
+    
+    // Growing the lookup's two hash maps batch by batch rehashed every node
+    // several times; size them for the whole file instead
+    if (lookup && options.addToLookup) lookup->reserve(lookup->getSongCount() + rows.size());
+    
+    for (size_t start = 0; start < rows.size(); start += batchSize) {
+        size_t stop = std::min(rows.size(), start + batchSize);
+        songs.clear();
+        ratedSongs.clear();
+        
+        for (size_t i = start; i < stop; i++) {
+            songs.push_back(materialize(rows[i]));
+            if (rows[i].rating >= 1 && rows[i].rating <= 5) {
+                ratedSongs.emplace_back(songs.back(), rows[i].rating);
+            }
+        }
+        
+        auto batchStart = std::chrono::high_resolution_clock::now();
+        if (engine && options.addToPlaylist) engine->addSongs(songs);
+        auto playlistEnd = std::chrono::high_resolution_clock::now();
+        if (lookup && options.addToLookup) lookup->addSongs(songs);
+        auto lookupEnd = std::chrono::high_resolution_clock::now();
+        if (ratingTree && options.addToRatings) ratingTree->insertSongs(ratedSongs);
+        auto ratingsEnd = std::chrono::high_resolution_clock::now();
+        
+        result.playlistMicroseconds +=
+            std::chrono::duration_cast<std::chrono::microseconds>(playlistEnd - batchStart).count();
+        result.lookupMicroseconds +=
+            std::chrono::duration_cast<std::chrono::microseconds>(lookupEnd - playlistEnd).count();
+        result.ratingsMicroseconds +=
+            std::chrono::duration_cast<std::chrono::microseconds>(ratingsEnd - lookupEnd).count();
+    }
+    auto loadEnd = std::chrono::high_resolution_clock::now();
+    
+    result.rowsImported = rows.size();
+    result.parseMicroseconds =
+        std::chrono::duration_cast<std::chrono::microseconds>(parseEnd - parseStart).count();
+    result.loadMicroseconds =
+        std::chrono::duration_cast<std::chrono::microseconds>(loadEnd - parseEnd).count();
+    result.success = true;
+    return result;
+}
+
+ImportResult CatalogImporter::importFile(const std::string& path, PlaylistEngine* engine,
+                                         SongLookup* lookup, SongRatingTree* ratingTree,
+                                         const ImportOptions& options) {
+    MappedFile file;
+    if (!file.open(path)) {
+        ImportResult result;
+        result.error = "Could not open " + path;
+        return result;
+    }
+    return importBuffer(file.data(), file.size(), engine, lookup, ratingTree, options);
+}
@@ -0,0 +1,80 @@
+#ifndef CATALOG_IMPORTER_H
+#define CATALOG_IMPORTER_H
+
+#include "song.h"
+#include "playlist_engine.h"
+#include "song_lookup.h"
+#include "song_rating_tree.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Options for a catalog import
+struct ImportOptions {
+    char delimiter = 0;            // ',' or '\t'; 0 detects it from the first line
+    unsigned int threadCount = 1;  // > 1 parses chunks of the file in parallel
+    size_t batchSize = 65536;      // rows handed to the engines per batch
+    bool addToPlaylist = true;
+    bool addToLookup = true;
+    bool addToRatings = true;
+};
+
+// Outcome of a catalog import
+struct ImportResult {
+    bool success = false;
+    std::string error;
+    size_t rowsImported = 0;
+    size_t rowsSkipped = 0;        // malformed rows (missing fields, bad duration)
+    size_t bytesRead = 0;
+    long long parseMicroseconds = 0;
+    long long loadMicroseconds = 0;
+    long long playlistMicroseconds = 0;  // parts of loadMicroseconds spent in each target;
+    long long lookupMicroseconds = 0;    // the rest builds the Songs
+    long long ratingsMicroseconds = 0;
+};
+
+// One parsed row. Fields point into the input buffer; nothing is copied
+// until the row is turned into a Song.
+struct CatalogRow {
+    std::string_view title;
+    std::string_view artist;
+    int duration = 0;
+    int rating = 0;                // 0 when the rating column is missing or empty
+    bool titleEscaped = false;     // field contains "" escapes that need unescaping
+    bool artistEscaped = false;
+};
+
+// Streaming importer for CSV/TSV catalogs with the columns
+// title, artist, duration, rating. Duration is in seconds or m:ss; rating is
+// optional. A header line is skipped automatically. Quoted CSV fields may
+// contain delimiters and "" escapes but not line breaks. Rows whose duration
+// or rating does not fit in an int are skipped.
+class CatalogImporter {
+private:
+    // Helper methods
+    static char detectDelimiter(const char* data, size_t size);
+    static size_t skipHeader(const char* data, size_t size, char delimiter);
+    static void parseRange(const char* begin, const char* end, char delimiter,
+                           std::vector<CatalogRow>& rows, size_t& skipped);
+    static Song materialize(const CatalogRow& row);
+    
+public:
+    // Constructor
+    CatalogImporter() = default;
+    
+    // Core operations
+    ImportResult importFile(const std::string& path, PlaylistEngine* engine, SongLookup* lookup,
+                            SongRatingTree* ratingTree, const ImportOptions& options = ImportOptions());
+    ImportResult importBuffer(const char* data, size_t size, PlaylistEngine* engine, SongLookup* lookup,
+                              SongRatingTree* ratingTree, const ImportOptions& options = ImportOptions());
+    
+    // Parsing only (no engines touched); rows point into data
+    std::vector<CatalogRow> parse(const char* data, size_t size, const ImportOptions& options,
+                                  size_t* skipped = nullptr);
+    
+    // Time complexity annotations:
+    // parse: O(B / t) - one pass over B bytes split across t threads
+    // importBuffer / importFile: O(B / t + n) - parse plus batched inserts of n rows
+};
+
+#endif // CATALOG_IMPORTER_H
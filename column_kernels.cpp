@@ -0,0 +1,560 @@
+#include "column_kernels.h"
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PLAYWISE_X86_KERNELS 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// ---- Portable kernels ----------------------------------------------------
+
+const size_t kBlockRows = 256;
+
+long long sumInt32Scalar(const int32_t* values, size_t count) {
+    long long total = 0;
+    size_t i = 0;
+    for (; i + kBlockRows <= count; i += kBlockRows) {
+        long long block = 0;
+        for (size_t j = 0; j < kBlockRows; j++) block += values[i + j];
+        total += block;
+    }
+    for (; i < count; i++) total += values[i];
+    return total;
+}
+
+void minMaxInt32Scalar(const int32_t* values, size_t count, int32_t& minimum, int32_t& maximum) {
+    int32_t low = INT32_MAX;
+    int32_t high = INT32_MIN;
+    for (size_t i = 0; i < count; i++) {
+        low = values[i] < low ? values[i] : low;
+        high = values[i] > high ? values[i] : high;
+    }
+    minimum = low;
+    maximum = high;
+}
+
+void ratingHistogramScalar(const int8_t* values, size_t count, size_t* counts) {
+    for (size_t i = 0; i < count; i++) {
+        if (values[i] >= 0 && values[i] <= 5) counts[values[i]]++;
+    }
+}
+
+void bandHistogramScalar(const int32_t* values, size_t count, int32_t bandWidth, size_t* counts, int bandCount) {
+    for (size_t i = 0; i < count; i++) {
+        int32_t band = std::max(values[i], 0) / bandWidth;
+        counts[std::min(band, bandCount - 1)]++;
+    }
+}
+
+size_t countInRangeScalar(const int32_t* values, size_t count, int32_t low, int32_t high) {
+    size_t matches = 0;
+    for (size_t i = 0; i < count; i++) matches += (values[i] >= low) & (values[i] < high);
+    return matches;
+}
+
+size_t selectInRangeScalar(const int32_t* values, size_t count, int32_t low, int32_t high, uint32_t* rows) {
+    // Branch-free: always write, advance only on a match
+    size_t matches = 0;
+    for (size_t i = 0; i < count; i++) {
+        rows[matches] = static_cast<uint32_t>(i);
+        matches += (values[i] >= low) & (values[i] < high);
+    }
+    return matches;
+}
+
+size_t countInRangeInt64Scalar(const int64_t* values, size_t count, int64_t low, int64_t high) {
+    size_t matches = 0;
+    for (size_t i = 0; i < count; i++) matches += (values[i] >= low) & (values[i] < high);
+    return matches;
+}
+
+const ColumnKernelTable kScalarTable = {
+    KernelIsa::SCALAR,
+    sumInt32Scalar,
+    minMaxInt32Scalar,
+    ratingHistogramScalar,
+    bandHistogramScalar,
+    countInRangeScalar,
+    selectInRangeScalar,
+    countInRangeInt64Scalar,
+};
+
+#ifdef PLAYWISE_X86_KERNELS
+
+// Vector paths count matches by subtracting compare masks (-1 per hit) from
+// 32-bit lane counters; they are flushed to size_t at least every
+// kFlushRows rows so no lane can overflow. Band histograms compute each
+// row's band as the number of band starts it reaches (one compare per band)
+// and then bump one of four partial histograms, so consecutive rows in the
+// same band do not serialize on one counter.
+const size_t kFlushRows = size_t(1) << 24;
+
+// Band starts for bandHistogram: rows >= threshold[b] are in band b or later.
+// Bands whose start does not fit in int32 can never be reached.
+int bandThresholds(int32_t bandWidth, int bandCount, int32_t* thresholds) {
+    int reachable = 1;
+    for (int b = 1; b < bandCount; b++) {
+        long long start = static_cast<long long>(b) * bandWidth;
+        if (start > INT32_MAX) break;
+        thresholds[b] = static_cast<int32_t>(start);
+        reachable = b + 1;
+    }
+    return reachable;
+}
+
+// Lane orders for branch-free compaction in selectInRange: entry m lists
+// the lanes whose bit is set in mask m, packed to the front
+struct CompressTables {
+    uint32_t avx2[256][8];   // _mm256_permutevar8x32_epi32 lane indices
+    uint8_t sse[16][16];     // _mm_shuffle_epi8 byte indices (0x80 = zero)
+    uint8_t popcount[256];
+    
+    CompressTables() {
+        for (int mask = 0; mask < 256; mask++) {
+            int packed = 0;
+            for (int lane = 0; lane < 8; lane++) {
+                if (mask & (1 << lane)) avx2[mask][packed++] = static_cast<uint32_t>(lane);
+            }
+            popcount[mask] = static_cast<uint8_t>(packed);
+            for (int lane = packed; lane < 8; lane++) avx2[mask][lane] = 0;
+        }
+        for (int mask = 0; mask < 16; mask++) {
+            int packed = 0;
+            for (int lane = 0; lane < 4; lane++) {
+                if (!(mask & (1 << lane))) continue;
+                for (int byte = 0; byte < 4; byte++) sse[mask][packed * 4 + byte] = static_cast<uint8_t>(lane * 4 + byte);
+                packed++;
+            }
+            for (int byte = packed * 4; byte < 16; byte++) sse[mask][byte] = 0x80;
+        }
+    }
+};
+
+const CompressTables& compressTables() {
+    static const CompressTables tables;
+    return tables;
+}
+
+// ---- SSE4.2 --------------------------------------------------------------
+
+__attribute__((target("sse4.2"))) size_t laneSum128(__m128i counters) {
+    uint32_t lanes[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), counters);
+    return size_t(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+}
+
+__attribute__((target("sse4.2"))) long long sumInt32Sse(const int32_t* values, size_t count) {
+    __m128i evens = _mm_setzero_si128();
+    __m128i odds = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        evens = _mm_add_epi64(evens, _mm_cvtepi32_epi64(x));
+        odds = _mm_add_epi64(odds, _mm_cvtepi32_epi64(_mm_srli_si128(x, 8)));
+    }
+    long long lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), _mm_add_epi64(evens, odds));
+    long long total = lanes[0] + lanes[1];
+    for (; i < count; i++) total += values[i];
+    return total;
+}
+
+__attribute__((target("sse4.2"))) void minMaxInt32Sse(const int32_t* values, size_t count,
+                                                        int32_t& minimum, int32_t& maximum) {
+    __m128i low = _mm_set1_epi32(INT32_MAX);
+    __m128i high = _mm_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        low = _mm_min_epi32(low, x);
+        high = _mm_max_epi32(high, x);
+    }
+    int32_t lows[4];
+    int32_t highs[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lows), low);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(highs), high);
+    minimum = std::min(std::min(lows[0], lows[1]), std::min(lows[2], lows[3]));
+    maximum = std::max(std::max(highs[0], highs[1]), std::max(highs[2], highs[3]));
+    for (; i < count; i++) {
+        minimum = std::min(minimum, values[i]);
+        maximum = std::max(maximum, values[i]);
+    }
+}
+
+__attribute__((target("sse4.2"))) void ratingHistogramSse(const int8_t* values, size_t count, size_t* counts) {
+    // Byte counters hold up to 255 hits; psadbw folds them into 64-bit sums
+    const size_t vectorEnd = count - count % 16;
+    const __m128i zero = _mm_setzero_si128();
+    size_t i = 0;
+    while (i < vectorEnd) {
+        size_t blockEnd = std::min(vectorEnd, i + 255 * 16);
+        __m128i hits[6];
+        for (int v = 0; v < 6; v++) hits[v] = zero;
+        for (; i < blockEnd; i += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+            for (int v = 0; v < 6; v++) {
+                hits[v] = _mm_sub_epi8(hits[v], _mm_cmpeq_epi8(x, _mm_set1_epi8(static_cast<char>(v))));
+            }
+        }
+        for (int v = 0; v < 6; v++) {
+            __m128i sums = _mm_sad_epu8(hits[v], zero);
+            counts[v] += static_cast<size_t>(_mm_cvtsi128_si64(sums)) +
+                         static_cast<size_t>(_mm_extract_epi64(sums, 1));
+        }
+    }
+    ratingHistogramScalar(values + i, count - i, counts);
+}
+
+__attribute__((target("sse4.2"))) void bandHistogramSse(const int32_t* values, size_t count, int32_t bandWidth,
+                                                          size_t* counts, int bandCount) {
+    if (bandCount > ColumnKernels::kMaxVectorBands) {
+        bandHistogramScalar(values, count, bandWidth, counts, bandCount);
+        return;
+    }
+    
+    int32_t thresholds[ColumnKernels::kMaxVectorBands];
+    int reachable = bandThresholds(bandWidth, bandCount, thresholds);
+    __m128i below[ColumnKernels::kMaxVectorBands];  // start - 1, so ">=" becomes ">"
+    for (int b = 1; b < reachable; b++) below[b] = _mm_set1_epi32(thresholds[b] - 1);
+    
+    size_t partial[4][ColumnKernels::kMaxVectorBands] = {};
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        __m128i band = _mm_setzero_si128();
+        for (int b = 1; b < reachable; b++) band = _mm_sub_epi32(band, _mm_cmpgt_epi32(x, below[b]));
+        partial[0][_mm_extract_epi32(band, 0)]++;
+        partial[1][_mm_extract_epi32(band, 1)]++;
+        partial[2][_mm_extract_epi32(band, 2)]++;
+        partial[3][_mm_extract_epi32(band, 3)]++;
+    }
+    for (int b = 0; b < reachable; b++) {
+        counts[b] += partial[0][b] + partial[1][b] + partial[2][b] + partial[3][b];
+    }
+    bandHistogramScalar(values + i, count - i, bandWidth, counts, bandCount);
+}
+
+__attribute__((target("sse4.2"))) inline __m128i inRangeMask128(__m128i x, __m128i low, __m128i high) {
+    // low <= x < high  ==  !(low > x) && (high > x)
+    return _mm_andnot_si128(_mm_cmpgt_epi32(low, x), _mm_cmpgt_epi32(high, x));
+}
+
+__attribute__((target("sse4.2"))) size_t countInRangeSse(const int32_t* values, size_t count,
+                                                           int32_t low, int32_t high) {
+    const __m128i lowVector = _mm_set1_epi32(low);
+    const __m128i highVector = _mm_set1_epi32(high);
+    const size_t vectorEnd = count - count % 4;
+    size_t matches = 0;
+    size_t i = 0;
+    while (i < vectorEnd) {
+        size_t blockEnd = std::min(vectorEnd, i + kFlushRows);
+        __m128i hits = _mm_setzero_si128();
+        for (; i < blockEnd; i += 4) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+            hits = _mm_sub_epi32(hits, inRangeMask128(x, lowVector, highVector));
+        }
+        matches += laneSum128(hits);
+    }
+    return matches + countInRangeScalar(values + i, count - i, low, high);
+}
+
+__attribute__((target("sse4.2"))) size_t selectInRangeSse(const int32_t* values, size_t count,
+                                                            int32_t low, int32_t high, uint32_t* rows) {
+    // Matching row numbers are shuffled to the front and stored as a whole
+    // vector; the output only advances by the number of matches
+    const CompressTables& tables = compressTables();
+    const __m128i lowVector = _mm_set1_epi32(low);
+    const __m128i highVector = _mm_set1_epi32(high);
+    __m128i rowNumbers = _mm_setr_epi32(0, 1, 2, 3);
+    const __m128i step = _mm_set1_epi32(4);
+    size_t matches = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        int bits = _mm_movemask_ps(_mm_castsi128_ps(inRangeMask128(x, lowVector, highVector)));
+        __m128i order = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.sse[bits]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(rows + matches), _mm_shuffle_epi8(rowNumbers, order));
+        matches += tables.popcount[bits];
+        rowNumbers = _mm_add_epi32(rowNumbers, step);
+    }
+    for (; i < count; i++) {
+        rows[matches] = static_cast<uint32_t>(i);
+        matches += (values[i] >= low) & (values[i] < high);
+    }
+    return matches;
+}
+
+__attribute__((target("sse4.2"))) size_t countInRangeInt64Sse(const int64_t* values, size_t count,
+                                                                int64_t low, int64_t high) {
+    const __m128i lowVector = _mm_set1_epi64x(low);
+    const __m128i highVector = _mm_set1_epi64x(high);
+    __m128i hits = _mm_setzero_si128();
+    size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        __m128i mask = _mm_andnot_si128(_mm_cmpgt_epi64(lowVector, x), _mm_cmpgt_epi64(highVector, x));
+        hits = _mm_sub_epi64(hits, mask);
+    }
+    size_t matches = static_cast<size_t>(_mm_cvtsi128_si64(hits)) + static_cast<size_t>(_mm_extract_epi64(hits, 1));
+    return matches + countInRangeInt64Scalar(values + i, count - i, low, high);
+}
+
+const ColumnKernelTable kSseTable = {
+    KernelIsa::SSE4_2,
+    sumInt32Sse,
+    minMaxInt32Sse,
+    ratingHistogramSse,
+    bandHistogramSse,
+    countInRangeSse,
+    selectInRangeSse,
+    countInRangeInt64Sse,
+};
+
+// ---- AVX2 ----------------------------------------------------------------
+
+__attribute__((target("avx2"))) size_t laneSum256(__m256i counters) {
+    uint32_t lanes[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), counters);
+    size_t total = 0;
+    for (uint32_t lane : lanes) total += lane;
+    return total;
+}
+
+__attribute__((target("avx2"))) long long sumInt32Avx2(const int32_t* values, size_t count) {
+    __m256i low = _mm256_setzero_si256();
+    __m256i high = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i first = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i));
+        __m128i second = _mm_loadu_si128(reinterpret_cast<const __m128i*>(values + i + 4));
+        low = _mm256_add_epi64(low, _mm256_cvtepi32_epi64(first));
+        high = _mm256_add_epi64(high, _mm256_cvtepi32_epi64(second));
+    }
+    long long lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(low, high));
+    long long total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    for (; i < count; i++) total += values[i];
+    return total;
+}
+
+__attribute__((target("avx2"))) void minMaxInt32Avx2(const int32_t* values, size_t count,
+                                                       int32_t& minimum, int32_t& maximum) {
+    __m256i low = _mm256_set1_epi32(INT32_MAX);
+    __m256i high = _mm256_set1_epi32(INT32_MIN);
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        low = _mm256_min_epi32(low, x);
+        high = _mm256_max_epi32(high, x);
+    }
+    int32_t lows[8];
+    int32_t highs[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lows), low);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(highs), high);
+    minimum = *std::min_element(lows, lows + 8);
+    maximum = *std::max_element(highs, highs + 8);
+    for (; i < count; i++) {
+        minimum = std::min(minimum, values[i]);
+        maximum = std::max(maximum, values[i]);
+    }
+}
+
+__attribute__((target("avx2"))) void ratingHistogramAvx2(const int8_t* values, size_t count, size_t* counts) {
+    const size_t vectorEnd = count - count % 32;
+    const __m256i zero = _mm256_setzero_si256();
+    size_t i = 0;
+    while (i < vectorEnd) {
+        size_t blockEnd = std::min(vectorEnd, i + 255 * 32);
+        __m256i hits[6];
+        for (int v = 0; v < 6; v++) hits[v] = zero;
+        for (; i < blockEnd; i += 32) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+            for (int v = 0; v < 6; v++) {
+                hits[v] = _mm256_sub_epi8(hits[v], _mm256_cmpeq_epi8(x, _mm256_set1_epi8(static_cast<char>(v))));
+            }
+        }
+        for (int v = 0; v < 6; v++) {
+            uint64_t sums[4];
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(sums), _mm256_sad_epu8(hits[v], zero));
+            counts[v] += static_cast<size_t>(sums[0] + sums[1] + sums[2] + sums[3]);
+        }
+    }
+    ratingHistogramScalar(values + i, count - i, counts);
+}
+
+__attribute__((target("avx2"))) void bandHistogramAvx2(const int32_t* values, size_t count, int32_t bandWidth,
+                                                         size_t* counts, int bandCount) {
+    if (bandCount > ColumnKernels::kMaxVectorBands) {
+        bandHistogramScalar(values, count, bandWidth, counts, bandCount);
+        return;
+    }
+    
+    int32_t thresholds[ColumnKernels::kMaxVectorBands];
+    int reachable = bandThresholds(bandWidth, bandCount, thresholds);
+    __m256i below[ColumnKernels::kMaxVectorBands];
+    for (int b = 1; b < reachable; b++) below[b] = _mm256_set1_epi32(thresholds[b] - 1);
+    
+    size_t partial[4][ColumnKernels::kMaxVectorBands] = {};
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        __m256i band = _mm256_setzero_si256();
+        for (int b = 1; b < reachable; b++) band = _mm256_sub_epi32(band, _mm256_cmpgt_epi32(x, below[b]));
+        uint32_t lanes[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), band);
+        partial[0][lanes[0]]++;
+        partial[1][lanes[1]]++;
+        partial[2][lanes[2]]++;
+        partial[3][lanes[3]]++;
+        partial[0][lanes[4]]++;
+        partial[1][lanes[5]]++;
+        partial[2][lanes[6]]++;
+        partial[3][lanes[7]]++;
+    }
+    for (int b = 0; b < reachable; b++) {
+        counts[b] += partial[0][b] + partial[1][b] + partial[2][b] + partial[3][b];
+    }
+    bandHistogramScalar(values + i, count - i, bandWidth, counts, bandCount);
+}
+
+__attribute__((target("avx2"))) inline __m256i inRangeMask256(__m256i x, __m256i low, __m256i high) {
+    return _mm256_andnot_si256(_mm256_cmpgt_epi32(low, x), _mm256_cmpgt_epi32(high, x));
+}
+
+__attribute__((target("avx2"))) size_t countInRangeAvx2(const int32_t* values, size_t count,
+                                                          int32_t low, int32_t high) {
+    const __m256i lowVector = _mm256_set1_epi32(low);
+    const __m256i highVector = _mm256_set1_epi32(high);
+    const size_t vectorEnd = count - count % 8;
+    size_t matches = 0;
+    size_t i = 0;
+    while (i < vectorEnd) {
+        size_t blockEnd = std::min(vectorEnd, i + kFlushRows);
+        __m256i hits = _mm256_setzero_si256();
+        for (; i < blockEnd; i += 8) {
+            __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+            hits = _mm256_sub_epi32(hits, inRangeMask256(x, lowVector, highVector));
+        }
+        matches += laneSum256(hits);
+    }
+    return matches + countInRangeScalar(values + i, count - i, low, high);
+}
+
+__attribute__((target("avx2"))) size_t selectInRangeAvx2(const int32_t* values, size_t count,
+                                                           int32_t low, int32_t high, uint32_t* rows) {
+    const CompressTables& tables = compressTables();
+    const __m256i lowVector = _mm256_set1_epi32(low);
+    const __m256i highVector = _mm256_set1_epi32(high);
+    __m256i rowNumbers = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const __m256i step = _mm256_set1_epi32(8);
+    size_t matches = 0;
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        int bits = _mm256_movemask_ps(_mm256_castsi256_ps(inRangeMask256(x, lowVector, highVector)));
+        __m256i order = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tables.avx2[bits]));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(rows + matches), _mm256_permutevar8x32_epi32(rowNumbers, order));
+        matches += tables.popcount[bits];
+        rowNumbers = _mm256_add_epi32(rowNumbers, step);
+    }
+    for (; i < count; i++) {
+        rows[matches] = static_cast<uint32_t>(i);
+        matches += (values[i] >= low) & (values[i] < high);
+    }
+    return matches;
+}
+
+__attribute__((target("avx2"))) size_t countInRangeInt64Avx2(const int64_t* values, size_t count,
+                                                               int64_t low, int64_t high) {
+    const __m256i lowVector = _mm256_set1_epi64x(low);
+    const __m256i highVector = _mm256_set1_epi64x(high);
+    __m256i hits = _mm256_setzero_si256();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(values + i));
+        __m256i mask = _mm256_andnot_si256(_mm256_cmpgt_epi64(lowVector, x), _mm256_cmpgt_epi64(highVector, x));
+        hits = _mm256_sub_epi64(hits, mask);
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), hits);
+    size_t matches = static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]);
+    return matches + countInRangeInt64Scalar(values + i, count - i, low, high);
+}
+
+const ColumnKernelTable kAvx2Table = {
+    KernelIsa::AVX2,
+    sumInt32Avx2,
+    minMaxInt32Avx2,
+    ratingHistogramAvx2,
+    bandHistogramAvx2,
+    countInRangeAvx2,
+    selectInRangeAvx2,
+    countInRangeInt64Avx2,
+};
+
+#endif // PLAYWISE_X86_KERNELS
+
+// Strongest set allowed by PLAYWISE_KERNELS and supported by the CPU
+KernelIsa selectIsa() {
+    KernelIsa isa = ColumnKernels::best();
+    const char* setting = std::getenv("PLAYWISE_KERNELS");
+    if (setting) {
+        KernelIsa cap = isa;
+        if (std::strcmp(setting, "scalar") == 0) cap = KernelIsa::SCALAR;
+        else if (std::strcmp(setting, "sse4.2") == 0) cap = KernelIsa::SSE4_2;
+        else if (std::strcmp(setting, "avx2") == 0) cap = KernelIsa::AVX2;
+        isa = std::min(isa, cap);
+    }
+    return isa;
+}
+
+} // namespace
+
+bool ColumnKernels::isSupported(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::SCALAR:
+            return true;
+#ifdef PLAYWISE_X86_KERNELS
+        case KernelIsa::SSE4_2:
+            return __builtin_cpu_supports("sse4.2");
+        case KernelIsa::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+KernelIsa ColumnKernels::best() {
+    if (isSupported(KernelIsa::AVX2)) return KernelIsa::AVX2;
+    if (isSupported(KernelIsa::SSE4_2)) return KernelIsa::SSE4_2;
+    return KernelIsa::SCALAR;
+}
+
+const ColumnKernelTable& ColumnKernels::active() {
+    static const ColumnKernelTable& table = forIsa(selectIsa());
+    return table;
+}
+
+const ColumnKernelTable& ColumnKernels::forIsa(KernelIsa isa) {
+#ifdef PLAYWISE_X86_KERNELS
+    if (isa == KernelIsa::AVX2 && isSupported(KernelIsa::AVX2)) return kAvx2Table;
+    if (isa == KernelIsa::SSE4_2 && isSupported(KernelIsa::SSE4_2)) return kSseTable;
+#else
+    (void)isa;
+#endif
+    return kScalarTable;
+}
+
+const char* ColumnKernels::name(KernelIsa isa) {
+    switch (isa) {
+        case KernelIsa::SSE4_2: return "sse4.2";
+        case KernelIsa::AVX2: return "avx2";
+        default: return "scalar";
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef COLUMN_KERNELS_H
+#define COLUMN_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Instruction sets the column kernels are built for, weakest first
+enum class KernelIsa {
+    SCALAR,   // portable C++; the compiler may still vectorize it for the baseline target
+    SSE4_2,
+    AVX2
+};
+
+// Aggregation kernels over fixed-width columns. Every instruction set fills
+// the same table, and all of them return exactly the same results.
+struct ColumnKernelTable {
+    KernelIsa isa;
+    
+    long long (*sumInt32)(const int32_t* values, size_t count);
+    // INT32_MAX / INT32_MIN for an empty column
+    void (*minMaxInt32)(const int32_t* values, size_t count, int32_t& minimum, int32_t& maximum);
+    // counts[v] += rows equal to v, for v in 0..5 (star ratings); other values are skipped
+    void (*ratingHistogram)(const int8_t* values, size_t count, size_t* counts);
+    // counts[b] += rows in [b * bandWidth, (b + 1) * bandWidth) for bandWidth > 0;
+    // negatives land in band 0, the last band is open-ended
+    void (*bandHistogram)(const int32_t* values, size_t count, int32_t bandWidth, size_t* counts, int bandCount);
+    // Threshold filters on [low, high)
+    size_t (*countInRange)(const int32_t* values, size_t count, int32_t low, int32_t high);
+    size_t (*selectInRange)(const int32_t* values, size_t count, int32_t low, int32_t high,
+                            uint32_t* rows);  // rows needs room for count entries; returns matches
+    size_t (*countInRangeInt64)(const int64_t* values, size_t count, int64_t low, int64_t high);
+};
+
+// Picks the kernel table for the running CPU.
+//
+// The choice is made once, on first use, from CPUID (via the compiler's CPU
+// detection). PLAYWISE_KERNELS=scalar|sse4.2|avx2 caps it, e.g. to compare
+// results or timings. Outside x86-64 GCC/Clang builds every table is the
+// scalar one.
+class ColumnKernels {
+public:
+    static bool isSupported(KernelIsa isa);
+    static KernelIsa best();
+    static const ColumnKernelTable& active();
+    static const ColumnKernelTable& forIsa(KernelIsa isa);  // scalar when the CPU lacks isa
+    static const char* name(KernelIsa isa);
+    
+    // Most bands bandHistogram handles with vector compares; more fall back to scalar
+    static constexpr int kMaxVectorBands = 16;
+    
+    // Time complexity annotations:
+    // every kernel: O(n) - one sequential pass; bandHistogram is O(n * b) compares
+    //   for b <= kMaxVectorBands bands in the vector paths
+    // active / forIsa: O(1) after the first call
+};
+
+#endif // COLUMN_KERNELS_H
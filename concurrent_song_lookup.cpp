@@ -0,0 +1,159 @@
+#include "concurrent_song_lookup.h"
+#include "metrics_registry.h"
+#include <functional>
+#include <mutex>
+
+ConcurrentSongLookup::ConcurrentSongLookup(size_t shardCount, const NormalizationOptions& options)
+    : titleShards(shardCount == 0 ? 1 : shardCount),
+      idShards(shardCount == 0 ? 1 : shardCount),
+      normalizer(options) {
+}
+
+ConcurrentSongLookup::TitleShard& ConcurrentSongLookup::titleShardFor(const std::string& key) {
+    return titleShards[std::hash<std::string>()(key) % titleShards.size()];
+}
+
+const ConcurrentSongLookup::TitleShard& ConcurrentSongLookup::titleShardFor(const std::string& key) const {
+    return titleShards[std::hash<std::string>()(key) % titleShards.size()];
+}
+
+ConcurrentSongLookup::IdShard& ConcurrentSongLookup::idShardFor(int id) {
+    return idShards[static_cast<unsigned int>(id) % idShards.size()];
+}
+
+const ConcurrentSongLookup::IdShard& ConcurrentSongLookup::idShardFor(int id) const {
+    return idShards[static_cast<unsigned int>(id) % idShards.size()];
+}
+
+void ConcurrentSongLookup::addSong(const Song& song) {
+    MetricsTimer timer(MetricId::LOOKUP_ADD);
+    SongHandle handle = std::make_shared<const Song>(song);
+    std::string key = makeKey(song.title);
+    
+    SongHandle replaced;
+    {
+        TitleShard& shard = titleShardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        SongHandle& slot = shard.songs[key];
+        replaced.swap(slot);
+        slot = handle;
+    }
+    SongHandle previous;
+    {
+        IdShard& shard = idShardFor(song.id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        SongHandle& slot = shard.songs[song.id];
+        previous.swap(slot);
+        slot = handle;
+    }
+    
+    // Same semantics as SongLookup: a title collision replaces the old song
+    if (replaced && replaced->id != song.id) {
+        eraseId(replaced->id, replaced);
+    }
+    // Re-adding an id under a new title drops its old title
+    if (previous && previous != replaced) {
+        eraseTitle(makeKey(previous->title), previous);
+    }
+}
+
+void ConcurrentSongLookup::addSongs(const std::vector<Song>& songs) {
+    for (const auto& song : songs) {
+        addSong(song);
+    }
+}
+
+ConcurrentSongLookup::SongHandle ConcurrentSongLookup::searchByTitle(const std::string& title) const {
+    return searchByKey(makeKey(title));
+}
+
+ConcurrentSongLookup::SongHandle ConcurrentSongLookup::searchByKey(const std::string& key) const {
+    MetricsTimer timer(MetricId::LOOKUP_SEARCH);
+    const TitleShard& shard = titleShardFor(key);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.songs.find(key);
+    if (it != shard.songs.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+ConcurrentSongLookup::SongHandle ConcurrentSongLookup::searchById(int id) const {
+    MetricsTimer timer(MetricId::LOOKUP_SEARCH);
+    const IdShard& shard = idShardFor(id);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.songs.find(id);
+    if (it != shard.songs.end()) {
+        return it->second;
+    }
+    return nullptr;
+}
+
+void ConcurrentSongLookup::eraseId(int id, const SongHandle& expected) {
+    IdShard& shard = idShardFor(id);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.songs.find(id);
+    // Only erase if a concurrent writer has not already replaced the entry
+    if (it != shard.songs.end() && it->second == expected) {
+        shard.songs.erase(it);
+    }
+}
+
+void ConcurrentSongLookup::eraseTitle(const std::string& key, const SongHandle& expected) {
+    TitleShard& shard = titleShardFor(key);
+    std::unique_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.songs.find(key);
+    // Only erase if the title has not been given to another song meanwhile
+    if (it != shard.songs.end() && it->second == expected) {
+        shard.songs.erase(it);
+    }
+}
+
+void ConcurrentSongLookup::deleteSong(const std::string& title) {
+    MetricsTimer timer(MetricId::LOOKUP_DELETE);
+    std::string key = makeKey(title);
+    SongHandle removed;
+    {
+        TitleShard& shard = titleShardFor(key);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.songs.find(key);
+        if (it == shard.songs.end()) return;
+        removed = it->second;
+        shard.songs.erase(it);
+    }
+    eraseId(removed->id, removed);
+}
+
+void ConcurrentSongLookup::deleteById(int id) {
+    MetricsTimer timer(MetricId::LOOKUP_DELETE);
+    SongHandle removed;
+    {
+        IdShard& shard = idShardFor(id);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        auto it = shard.songs.find(id);
+        if (it == shard.songs.end()) return;
+        removed = it->second;
+        shard.songs.erase(it);
+    }
+    eraseTitle(makeKey(removed->title), removed);
+}
+
+std::vector<ConcurrentSongLookup::SongHandle> ConcurrentSongLookup::getAllSongs() const {
+    std::vector<SongHandle> songs;
+    for (const auto& shard : idShards) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        for (const auto& pair : shard.songs) {
+            songs.push_back(pair.second);
+        }
+    }
+    return songs;
+}
+
+int ConcurrentSongLookup::getSongCount() const {
+    size_t count = 0;
+    for (const auto& shard : idShards) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        count += shard.songs.size();
+    }
+    return static_cast<int>(count);
+}
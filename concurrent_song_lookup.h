@@ -0,0 +1,80 @@
+#ifndef CONCURRENT_SONG_LOOKUP_H
+#define CONCURRENT_SONG_LOOKUP_H
+
+#include "song.h"
+#include "text_normalizer.h"
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Thread-safe counterpart of SongLookup for serving queries from many threads
+// while the catalog is being updated.
+//
+// Both maps are split into independently locked shards (lock striping), so
+// readers only contend when they hash to the same shard. Results are
+// shared_ptr handles to immutable songs: a handle stays valid after the song
+// is replaced, deleted or the shard rehashes.
+//
+// A write updates the title map and the id map one after the other, holding
+// one shard lock at a time, so the pair is not atomic: a concurrent reader may
+// briefly find a song by id but not yet by title, or the reverse. Stale
+// entries are only erased if they still hold the handle being replaced.
+class ConcurrentSongLookup {
+public:
+    using SongHandle = std::shared_ptr<const Song>;
+    
+private:
+    // Padded to a cache line so neighbouring shard locks do not false-share
+    struct alignas(64) TitleShard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, SongHandle> songs;
+    };
+    
+    struct alignas(64) IdShard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<int, SongHandle> songs;
+    };
+    
+    std::vector<TitleShard> titleShards;
+    std::vector<IdShard> idShards;
+    TextNormalizer normalizer;
+    
+    // Helper methods
+    TitleShard& titleShardFor(const std::string& key);
+    const TitleShard& titleShardFor(const std::string& key) const;
+    IdShard& idShardFor(int id);
+    const IdShard& idShardFor(int id) const;
+    void eraseId(int id, const SongHandle& expected);
+    void eraseTitle(const std::string& key, const SongHandle& expected);
+    
+public:
+    // Constructor
+    explicit ConcurrentSongLookup(size_t shardCount = 64,
+                                  const NormalizationOptions& options = NormalizationOptions());
+    
+    // Core operations
+    void addSong(const Song& song);
+    void addSongs(const std::vector<Song>& songs);
+    SongHandle searchByTitle(const std::string& title) const;
+    SongHandle searchByKey(const std::string& key) const;
+    SongHandle searchById(int id) const;
+    void deleteSong(const std::string& title);
+    void deleteById(int id);
+    
+    // Utility methods
+    std::string makeKey(const std::string& title) const { return normalizer.normalize(title); }
+    std::vector<SongHandle> getAllSongs() const;
+    int getSongCount() const;
+    size_t getShardCount() const { return titleShards.size(); }
+    
+    // Time complexity annotations:
+    // addSong: O(L) - key normalization, then two shard-locked hash insertions (plus the old title's removal)
+    // searchByTitle: O(L) - key normalization, then a shared-locked hash lookup
+    // searchByKey / searchById: O(1) - shared-locked hash lookup
+    // deleteSong / deleteById: O(1) - exclusive lock on the owning shards
+    // getAllSongs / getSongCount: O(n + s) - visits every shard
+};
+
+#endif // CONCURRENT_SONG_LOOKUP_H
@@ -0,0 +1,80 @@
+#include "event_bus.h"
+#include <algorithm>
+
+EventBus::EventBus() : nextId(1), batchDepth(0), delivering(false) {
+}
+
+int EventBus::subscribe(Handler handler) {
+    int id = nextId++;
+    // The vector being delivered from must not grow under a running handler
+    std::vector<Subscriber>& target = delivering ? joining : subscribers;
+    target.push_back(Subscriber{id, std::move(handler), true});
+    return id;
+}
+
+void EventBus::unsubscribe(int subscriptionId) {
+    auto matches = [subscriptionId](const Subscriber& s) { return s.id == subscriptionId; };
+    if (delivering) {
+        // Only marked: the handler may be the one running, and flush() keeps
+        // its position in the vector
+        for (auto& subscriber : subscribers) {
+            if (matches(subscriber)) subscriber.active = false;
+        }
+        joining.erase(std::remove_if(joining.begin(), joining.end(), matches), joining.end());
+        return;
+    }
+    subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(), matches), subscribers.end());
+}
+
+void EventBus::settleSubscribers() {
+    subscribers.erase(std::remove_if(subscribers.begin(), subscribers.end(),
+                                     [](const Subscriber& s) { return !s.active; }),
+                      subscribers.end());
+    for (auto& subscriber : joining) {
+        subscribers.push_back(std::move(subscriber));
+    }
+    joining.clear();
+}
+
+void EventBus::publish(const EngineEvent& event) {
+    if (!hasSubscribers()) return;
+    
+    pending.push_back(event);
+    if (batchDepth == 0) flush();
+}
+
+void EventBus::beginBatch() {
+    batchDepth++;
+}
+
+void EventBus::endBatch() {
+    if (batchDepth > 0 && --batchDepth == 0) flush();
+}
+
+void EventBus::flush() {
+    // Events published by a handler are queued and delivered after the
+    // current batch, so every subscriber sees the same order
+    if (delivering) return;
+    
+    // Resets the flag and applies (un)subscriptions even if a handler throws
+    struct DeliveryScope {
+        EventBus& bus;
+        explicit DeliveryScope(EventBus& owner) : bus(owner) { bus.delivering = true; }
+        ~DeliveryScope() {
+            bus.delivering = false;
+            bus.settleSubscribers();
+        }
+    } scope(*this);
+    
+    std::vector<EngineEvent> batch;
+    while (!pending.empty()) {
+        batch.swap(pending);
+        
+        // Walked in place: the vector does not change size until settled
+        for (size_t i = 0; i < subscribers.size(); i++) {
+            if (subscribers[i].active) subscribers[i].handler(batch);
+        }
+        batch.clear();
+        settleSubscribers();
+    }
+}
@@ -0,0 +1,109 @@
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include <functional>
+#include <vector>
+
+// Changes published by the core engines
+enum class EngineEventType {
+    SONG_ADDED,    // playlist: song inserted at index
+    SONG_REMOVED,  // playlist: song removed from index
+    SONG_MOVED,    // playlist: song moved from index to toIndex
+    REVERSED,      // playlist: order reversed
+    SHUFFLED,      // playlist: order replaced wholesale
+    RATED,         // rating tree: song rated
+    UNRATED,       // rating tree: rating removed
+    PLAYED,        // history: song played
+    PLAY_UNDONE    // history: last play undone
+};
+
+// One change. Only ids, positions and play times are carried; consumers
+// that need the song itself read it from the engine.
+struct EngineEvent {
+    EngineEventType type;
+    int songId = -1;
+    int index = -1;    // playlist position (SONG_ADDED / SONG_REMOVED / SONG_MOVED source)
+    int toIndex = -1;  // SONG_MOVED destination
+    int rating = 0;    // RATED / UNRATED
+    long long micros = 0;  // PLAYED: stored play time, epoch microseconds
+    
+    EngineEvent(EngineEventType t, int id = -1, int i = -1, int to = -1, int r = 0, long long us = 0)
+        : type(t), songId(id), index(i), toIndex(to), rating(r), micros(us) {}
+};
+
+// Synchronous change stream shared by the engines.
+//
+// Subscribers receive events in batches, in the order they happened:
+// outside a batch scope every event is its own batch, inside one (bulk
+// loads, undo of several edits) they are delivered together when the
+// outermost scope ends. Engines check hasSubscribers() before building an
+// event, so an idle bus costs one load and branch per mutation.
+//
+// Like the engines, the bus is not thread-safe; publish and subscribe from
+// the thread that owns the engines.
+class EventBus {
+public:
+    using Handler = std::function<void(const std::vector<EngineEvent>&)>;
+
+private:
+    struct Subscriber {
+        int id;
+        Handler handler;
+        bool active;  // cleared by unsubscribe during delivery; dropped afterwards
+    };
+    
+    std::vector<Subscriber> subscribers;
+    std::vector<Subscriber> joining;  // subscribed during delivery, added after the batch
+    std::vector<EngineEvent> pending;
+    int nextId;
+    int batchDepth;
+    bool delivering;
+    
+    void flush();
+    void settleSubscribers();  // drops inactive entries and adds the joining ones
+
+public:
+    // Constructor
+    EventBus();
+    
+    EventBus(const EventBus&) = delete;
+    EventBus& operator=(const EventBus&) = delete;
+    
+    // Subscription; handlers may subscribe or unsubscribe while handling. A
+    // handler added during delivery gets the next batch; one removed is not
+    // called again, not even for the rest of the current batch.
+    int subscribe(Handler handler);
+    void unsubscribe(int subscriptionId);
+    bool hasSubscribers() const { return !subscribers.empty() || !joining.empty(); }
+    
+    // Publishing
+    void publish(const EngineEvent& event);
+    void beginBatch();
+    void endBatch();
+    
+    // Time complexity annotations:
+    // publish: O(s) - s subscribers, or O(1) amortized inside a batch
+    // endBatch: O(s) - one call per subscriber for the whole batch
+    // subscribe / unsubscribe: O(s)
+};
+
+// Groups the events published in a scope into one batch. Accepts a null
+// bus so engines without one need no special case.
+class EventBatch {
+private:
+    EventBus* bus;
+
+public:
+    explicit EventBatch(EventBus* eventBus) : bus(eventBus) {
+        if (bus) bus->beginBatch();
+    }
+    
+    ~EventBatch() {
+        if (bus) bus->endBatch();
+    }
+    
+    EventBatch(const EventBatch&) = delete;
+    EventBatch& operator=(const EventBatch&) = delete;
+};
+
+#endif // EVENT_BUS_H
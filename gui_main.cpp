@@ -9,6 +9,7 @@
 #include <QLineEdit>
 #include <QPushButton>
 #include <QListWidget>
+#include <QListView>
 #include <QTextEdit>
 #include <QSpinBox>
 #include <QComboBox>
@@ -45,32 +46,57 @@
 #include <QValueAxis>
 
 #include "song.h"
+#include "library.h"
 #include "playlist_engine.h"
+#include "playlist_model.h"
 #include "playback_history.h"
 #include "song_rating_tree.h"
 #include "song_lookup.h"
 #include "playlist_sorter.h"
 #include "system_snapshot.h"
+#include "catalog_importer.h"
+#include "library_store.h"
+#include "write_ahead_log.h"
+#include "metrics_registry.h"
+#include "task_executor.h"
+
+#include <thread>
+#include <random>
+#include <memory>
 
 QT_CHARTS_USE_NAMESPACE
 
+// Rows shown in the sorted playlist view; only these are fully ordered
+static const size_t kSortedPageSize = 500;
+
+// Result of a background sort, delivered to the UI thread
+struct SortedPageResult {
+    std::vector<Song> songs;
+    SortMetrics metrics;
+    size_t totalSongs = 0;
+};
+
 class PlayWiseGUI : public QMainWindow {
     Q_OBJECT
 
 private:
-    // Core system components
+    // Core system components; the four structures below are owned by library
+    Library* library;
     PlaylistEngine* playlistEngine;
     PlaybackHistory* playbackHistory;
     SongRatingTree* ratingTree;
     SongLookup* songLookup;
-    PlaylistSorter* sorter;
+    TaskExecutor* taskExecutor;  // sort, shuffle and snapshot work
     SystemSnapshot* snapshot;
+    LibraryStore* libraryStore;
+    WriteAheadLog* writeAheadLog;
 
     // GUI Components
     QTabWidget* mainTabWidget;
     
     // Playlist Tab
-    QListWidget* playlistWidget;
+    QListView* playlistView;
+    PlaylistModel* playlistModel;
     QLineEdit* titleEdit;
     QLineEdit* artistEdit;
     QSpinBox* durationSpinBox;
@@ -100,6 +126,7 @@ private:
     QPushButton* searchBtn;
     QListWidget* searchResultsWidget;
     QPushButton* addToLookupBtn;
+    QPushButton* importCatalogBtn;
     
     // Sorting Tab
     QComboBox* sortTypeCombo;
@@ -118,6 +145,9 @@ private:
     QPushButton* exportSnapshotBtn;
     QChartView* ratingChartView;
     QChartView* durationChartView;
+    QCheckBox* metricsEnabledCheck;
+    QPushButton* exportMetricsBtn;
+    QTableWidget* metricsTable;
     
     // Status and Info
     QStatusBar* statusBar;
@@ -131,15 +161,33 @@ private:
 public:
     PlayWiseGUI(QWidget* parent = nullptr) : QMainWindow(parent) {
         // Initialize core components
-        playlistEngine = new PlaylistEngine();
-        playbackHistory = new PlaybackHistory();
-        ratingTree = new SongRatingTree();
-        songLookup = new SongLookup();
-        sorter = new PlaylistSorter();
+        library = new Library();
+        playlistEngine = &library->playlist();
+        playbackHistory = &library->history();
+        ratingTree = &library->ratings();
+        songLookup = &library->lookup();
+        // Results are posted back onto the Qt event loop; stale ones are dropped
+        taskExecutor = new TaskExecutor([this](std::function<void()> deliver) {
+            QMetaObject::invokeMethod(this, std::move(deliver), Qt::QueuedConnection);
+        });
         snapshot = new SystemSnapshot();
+        libraryStore = new LibraryStore();
         
-        // Add sample data
-        initializeSampleData();
+        // Restore the saved library, or add sample data on first run
+        if (!libraryStore->load(kDefaultLibraryPath, *playlistEngine, *playbackHistory, *ratingTree, *songLookup)) {
+            initializeSampleData();
+        }
+        
+        // Re-apply edits made after the last save (e.g. before a crash), then log new ones
+        WalReplayResult replayed = WriteAheadLog::replay(kDefaultLogPath, libraryStore->getWalSequence(),
+                                                         *playlistEngine, *playbackHistory, *ratingTree);
+        writeAheadLog = new WriteAheadLog();
+        if (writeAheadLog->open(kDefaultLogPath, WalOptions(), replayed.lastSequence)) {
+            playlistEngine->setWriteAheadLog(writeAheadLog);
+            playbackHistory->setWriteAheadLog(writeAheadLog);
+            ratingTree->setWriteAheadLog(writeAheadLog);
+        }
+        library->rebuildIndexes();
         
         // Setup GUI
         setupUI();
@@ -148,18 +196,29 @@ public:
         
         // Start update timer
         updateTimer = new QTimer(this);
-        connect(updateTimer, &QTimer::timeout, this, &PlayWiseGUI::updateDisplay);
+        // The memory bar is refreshed here, not after each edit; components that
+        // did not change since the last tick are not walked again
+        connect(updateTimer, &QTimer::timeout, this, &PlayWiseGUI::updateMemoryUsage);
         updateTimer->start(1000); // Update every second
         
         updateDisplay();
+        updateMemoryUsage();
     }
 
     ~PlayWiseGUI() {
-        delete playlistEngine;
-        delete playbackHistory;
-        delete ratingTree;
-        delete songLookup;
-        delete sorter;
+        if (libraryStore->save(kDefaultLibraryPath, *playlistEngine, *playbackHistory, *ratingTree, *songLookup,
+                               writeAheadLog->getLastSequence())) {
+            writeAheadLog->checkpoint();
+        }
+        
+        delete taskExecutor;
+        playlistModel->detach();
+        playlistEngine->setWriteAheadLog(nullptr);
+        playbackHistory->setWriteAheadLog(nullptr);
+        ratingTree->setWriteAheadLog(nullptr);
+        delete writeAheadLog;
+        delete libraryStore;
+        delete library;
         delete snapshot;
     }
 
@@ -174,8 +233,7 @@ private slots:
             return;
         }
         
-        playlistEngine->addSong(title.toStdString(), artist.toStdString(), duration);
-        songLookup->addSong(Song(title.toStdString(), artist.toStdString(), duration));
+        library->addSong(Song(title.toStdString(), artist.toStdString(), duration));
         
         titleEdit->clear();
         artistEdit->clear();
@@ -186,9 +244,9 @@ private slots:
     }
     
     void deleteSong() {
-        int currentRow = playlistWidget->currentRow();
+        int currentRow = playlistView->currentIndex().row();
         if (currentRow >= 0) {
-            playlistEngine->deleteSong(currentRow);
+            library->removeSongAt(currentRow);
             updateDisplay();
             statusBar->showMessage("Song deleted successfully!", 3000);
         } else {
@@ -197,21 +255,21 @@ private slots:
     }
     
     void moveSongUp() {
-        int currentRow = playlistWidget->currentRow();
+        int currentRow = playlistView->currentIndex().row();
         if (currentRow > 0) {
             playlistEngine->moveSong(currentRow, currentRow - 1);
             updateDisplay();
-            playlistWidget->setCurrentRow(currentRow - 1);
+            playlistView->setCurrentIndex(playlistModel->index(currentRow - 1));
             statusBar->showMessage("Song moved up!", 2000);
         }
     }
     
     void moveSongDown() {
-        int currentRow = playlistWidget->currentRow();
-        if (currentRow >= 0 && currentRow < playlistWidget->count() - 1) {
+        int currentRow = playlistView->currentIndex().row();
+        if (currentRow >= 0 && currentRow < playlistModel->rowCount() - 1) {
             playlistEngine->moveSong(currentRow, currentRow + 1);
             updateDisplay();
-            playlistWidget->setCurrentRow(currentRow + 1);
+            playlistView->setCurrentIndex(playlistModel->index(currentRow + 1));
             statusBar->showMessage("Song moved down!", 2000);
         }
     }
@@ -223,26 +281,71 @@ private slots:
     }
     
     void shuffleWithConstraints() {
-        playlistEngine->shuffleWithConstraints();
-        updateDisplay();
-        statusBar->showMessage("Playlist shuffled with constraints!", 2000);
+        // The order is computed on a copy in the background and applied only
+        // if the playlist did not change in the meantime
+        std::random_device rd;
+        unsigned int seed = rd();
+        unsigned long long basedOnVersion = playlistEngine->getVersion();
+        auto songs = std::make_shared<std::vector<Song>>(playlistEngine->getSongs());
+        
+        statusBar->showMessage("Shuffling...");
+        taskExecutor->submit("shuffle",
+            [songs, seed](const CancellationToken&) {
+                return PlaylistEngine::shuffledOrder(std::move(*songs), seed);
+            },
+            [this, seed, basedOnVersion](std::vector<Song> order) {
+                if (playlistEngine->applyShuffle(seed, order, basedOnVersion)) {
+                    updateDisplay();
+                    statusBar->showMessage("Playlist shuffled with constraints!", 2000);
+                } else {
+                    statusBar->showMessage("Playlist changed while shuffling; shuffle again", 3000);
+                }
+            });
     }
     
     void playSong() {
-        int currentRow = playlistWidget->currentRow();
-        if (currentRow >= 0) {
-            std::vector<Song> songs = playlistEngine->getSongs();
-            if (currentRow < songs.size()) {
-                Song song = songs[currentRow];
-                playbackHistory->addPlayedSong(song);
-                updateDisplay();
-                statusBar->showMessage("Now playing: " + QString::fromStdString(song.title), 3000);
-            }
+        const Song* selected = playlistEngine->startPlayback(playlistView->currentIndex().row());
+        if (selected) {
+            nowPlaying(*selected);
         } else {
             QMessageBox::information(this, "Selection", "Please select a song to play!");
         }
     }
     
+    // Next and previous move the engine's now-playing cursor, which never
+    // walks the list
+    void playNextSong() {
+        const Song* next = playlistEngine->playNext();
+        if (next) {
+            nowPlaying(*next);
+        } else {
+            statusBar->showMessage("End of playlist", 2000);
+        }
+    }
+    
+    void playPreviousSong() {
+        const Song* previous = playlistEngine->playPrevious();
+        if (previous) {
+            nowPlaying(*previous);
+        } else {
+            statusBar->showMessage("Start of playlist", 2000);
+        }
+    }
+    
+    // A track change touches only the history list and the now-playing
+    // state; nothing here walks the playlist or the other structures
+    void nowPlaying(const Song& playing) {
+        Song song = playing;
+        playbackHistory->addPlayedSong(song);
+        playlistView->setCurrentIndex(playlistModel->index(playlistEngine->getNowPlayingIndex()));
+        updateHistoryDisplay();
+        
+        QString message = "Now playing: " + QString::fromStdString(song.title);
+        std::vector<Song> upNext = playlistEngine->getUpNext();
+        if (!upNext.empty()) message += "  |  Up next: " + QString::fromStdString(upNext.front().title);
+        statusBar->showMessage(message, 3000);
+    }
+    
     void undoPlay() {
         Song undoneSong = playbackHistory->undoLastPlay();
         if (undoneSong.title != "") {
@@ -260,16 +363,13 @@ private slots:
     }
     
     void addRating() {
-        int currentRow = playlistWidget->currentRow();
-        if (currentRow >= 0) {
-            std::vector<Song> songs = playlistEngine->getSongs();
-            if (currentRow < songs.size()) {
-                Song song = songs[currentRow];
-                int rating = ratingSpinBox->value();
-                ratingTree->insertSong(song, rating);
-                updateDisplay();
-                statusBar->showMessage("Rating added: " + QString::fromStdString(song.title) + " - " + QString::number(rating) + " stars", 3000);
-            }
+        const Song* selected = playlistEngine->getSongAt(playlistView->currentIndex().row());
+        if (selected) {
+            Song song = *selected;
+            int rating = ratingSpinBox->value();
+            library->rateSong(song.id, rating);
+            updateDisplay();
+            statusBar->showMessage("Rating added: " + QString::fromStdString(song.title) + " - " + QString::number(rating) + " stars", 3000);
         } else {
             QMessageBox::information(this, "Selection", "Please select a song to rate!");
         }
@@ -318,43 +418,113 @@ private slots:
         }
     }
     
+    void importCatalog() {
+        QString fileName = QFileDialog::getOpenFileName(this, "Import Catalog", "", "Catalog Files (*.csv *.tsv *.txt);;All Files (*)");
+        if (fileName.isEmpty()) {
+            return;
+        }
+        
+        CatalogImporter importer;
+        ImportOptions options;
+        options.threadCount = std::thread::hardware_concurrency();
+        ImportResult result = importer.importFile(fileName.toStdString(), playlistEngine, songLookup, ratingTree, options);
+        
+        if (!result.success) {
+            QMessageBox::critical(this, "Import Error", QString::fromStdString(result.error));
+            return;
+        }
+        
+        library->rebuildIndexes();
+        updateDisplay();
+        statusBar->showMessage(QString("Imported %1 songs (%2 rows skipped) in %3 ms")
+                                   .arg(result.rowsImported)
+                                   .arg(result.rowsSkipped)
+                                   .arg((result.parseMicroseconds + result.loadMicroseconds) / 1000), 5000);
+    }
+    
     void sortPlaylist() {
         QString sortType = sortTypeCombo->currentText();
-        std::vector<Song> songs = playlistEngine->getSongs();
-        std::vector<Song> sortedSongs;
-        
-        auto start = std::chrono::high_resolution_clock::now();
         
+        // Only the first screen of results is ordered and shown
+        auto taskSorter = std::make_shared<PlaylistSorter>();
+        taskSorter->setThreadCount(0);  // large playlists use every core
+        std::vector<SortKey> keys;
         if (sortType == "By Title") {
-            sortedSongs = sorter->sortByTitle(songs);
+            keys = {{SortField::TITLE, true}};
         } else if (sortType == "By Duration") {
-            sortedSongs = sorter->sortByDuration(songs);
+            keys = {{SortField::DURATION, true}};
         } else if (sortType == "Recently Added") {
-            sortedSongs = sorter->sortByRecentlyAdded(songs);
+            keys = {{SortField::ADDED_TIME, false}};
+        } else if (sortType == "By Artist, Rating") {
+            taskSorter->setRatings(*ratingTree);
+            keys = {{SortField::ARTIST, true}, {SortField::RATING, false}, {SortField::TITLE, true}};
         }
         
-        auto end = std::chrono::high_resolution_clock::now();
-        auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
+        // Each request gets its own sorter, so a stale sort still running
+        // never shares state with the new one
+        auto songs = std::make_shared<std::vector<Song>>(playlistEngine->getSongs());
+        statusBar->showMessage("Sorting...");
+        taskExecutor->submit("sort",
+            [taskSorter, songs, keys](const CancellationToken&) {
+                SortedPageResult result;
+                result.songs = taskSorter->sortedPage(*songs, keys, 0, kSortedPageSize);
+                result.metrics = taskSorter->getLastSortMetrics();
+                result.totalSongs = songs->size();
+                return result;
+            },
+            [this, sortType](SortedPageResult result) {
+                showSortedPage(result);
+                statusBar->showMessage("Playlist sorted by " + sortType, 3000);
+            });
+    }
+    
+    void showSortedPage(const SortedPageResult& result) {
+        const SortMetrics& metrics = result.metrics;
         
         sortedPlaylistWidget->clear();
-        for (const auto& song : sortedSongs) {
+        for (const auto& song : result.songs) {
             sortedPlaylistWidget->addItem(QString::fromStdString(song.title) + " - " + QString::fromStdString(song.artist) + " (" + QString::fromStdString(song.getFormattedDuration()) + ")");
         }
         
-        sortStatsText->setText(QString("Sorting completed in %1 microseconds\nSorted %2 songs").arg(duration.count()).arg(sortedSongs.size()));
-        statusBar->showMessage("Playlist sorted by " + sortType, 3000);
+        sortStatsText->setText(QString("Sorting completed in %1 microseconds "
+                                       "(keys %2, sort %3, copy %4)\n"
+                                       "%5 comparisons, %6 KB allocated\n"
+                                       "Showing first %7 of %8 songs")
+                               .arg(metrics.totalMicroseconds())
+                               .arg(metrics.packMicroseconds)
+                               .arg(metrics.sortMicroseconds)
+                               .arg(metrics.copyMicroseconds)
+                               .arg(metrics.comparisons)
+                               .arg(metrics.allocatedBytes / 1024)
+                               .arg(result.songs.size())
+                               .arg(result.totalSongs));
     }
     
     void undoLastNEdits() {
         int count = undoCountSpinBox->value();
-        playlistEngine->undoLastNEdits(count);
+        library->undoLastNEdits(count);
         updateDisplay();
         statusBar->showMessage("Undid " + QString::number(count) + " edits!", 3000);
     }
     
     void generateSnapshot() {
-        SystemStats stats = snapshot->exportSnapshot(*playlistEngine, *playbackHistory, *ratingTree, *songLookup);
-        
+        // Only copies are taken here; the column scans run in the background
+        // and the longest songs' ids are looked up once the result is back
+        auto state = std::make_shared<SnapshotState>(snapshot->captureState(*library));
+        
+        statusBar->showMessage("Generating snapshot...");
+        taskExecutor->submit("snapshot",
+            [state](const CancellationToken&) {
+                SystemSnapshot worker;  // SystemSnapshot keeps a sorter, so one per task
+                return worker.exportSnapshot(*state);
+            },
+            [this](SystemStats stats) {
+                snapshot->resolveTopLongestSongs(*library, stats);
+                showSnapshot(stats);
+            });
+    }
+    
+    void showSnapshot(const SystemStats& stats) {
         QString snapshotInfo = "=== PlayWise System Snapshot ===\n\n";
         snapshotInfo += "Playlist Statistics:\n";
         snapshotInfo += "- Total songs in playlist: " + QString::number(stats.totalSongsInPlaylist) + "\n";
@@ -377,12 +547,78 @@ private slots:
         for (const auto& pair : stats.songCountByRating) {
             snapshotInfo += "- " + QString::number(pair.first) + " stars: " + QString::number(pair.second) + " songs\n";
         }
+        snapshotInfo += "\n";
+        
+        if (!stats.mostPlayedSongs.empty()) {
+            snapshotInfo += "Most Played Songs:\n";
+            for (const auto& song : stats.mostPlayedSongs) {
+                snapshotInfo += "- " + QString::fromStdString(song.first) + " (" + QString::number(song.second) + " plays)\n";
+            }
+            snapshotInfo += "Most Played Artists:\n";
+            for (const auto& artist : stats.mostPlayedArtists) {
+                snapshotInfo += "- " + QString::fromStdString(artist.first) + " (" + QString::number(artist.second) + " plays)\n";
+            }
+            snapshotInfo += "Top Trending:\n";
+            for (const auto& song : stats.topTrending) {
+                snapshotInfo += "- " + QString::fromStdString(song.label) + " (~" + QString::number(song.count) + " plays)\n";
+            }
+            snapshotInfo += "Distinct songs in the last 24 hours: ~" + QString::number(qRound64(stats.distinctSongsLastDay)) +
+                            ", distinct artists in the last 7 days: ~" + QString::number(qRound64(stats.distinctArtistsLastWeek)) + "\n";
+            snapshotInfo += "\n";
+        }
+        
+        snapshotInfo += "Memory by Component:\n";
+        for (const auto& component : stats.memoryByComponent) {
+            snapshotInfo += "- " + QString::fromStdString(component.first) + ": " +
+                            QString::number(component.second.totalBytes() / 1024) + " KB (" +
+                            QString::number(component.second.items) + " items)\n";
+        }
+        snapshotInfo += "- Total: " + QString::number(stats.totalMemoryBytes / 1024) + " KB\n";
         
         snapshotText->setText(snapshotInfo);
         updateCharts(stats);
+        updateMetricsTable();
         statusBar->showMessage("System snapshot generated!", 3000);
     }
     
+    void updateMetricsTable() {
+        // Only operations that have run are listed
+        metricsTable->setRowCount(0);
+        for (const auto& op : MetricsRegistry::instance().collect()) {
+            if (op.count == 0) continue;
+            int row = metricsTable->rowCount();
+            metricsTable->insertRow(row);
+            metricsTable->setItem(row, 0, new QTableWidgetItem(QString::fromStdString(op.component)));
+            metricsTable->setItem(row, 1, new QTableWidgetItem(QString::fromStdString(op.operation)));
+            metricsTable->setItem(row, 2, new QTableWidgetItem(QString::number(op.count)));
+            metricsTable->setItem(row, 3, new QTableWidgetItem(QString::number(op.p50Nanos / 1000.0, 'f', 1)));
+            metricsTable->setItem(row, 4, new QTableWidgetItem(QString::number(op.p99Nanos / 1000.0, 'f', 1)));
+            metricsTable->setItem(row, 5, new QTableWidgetItem(QString::number(op.maxNanos / 1000.0, 'f', 1)));
+        }
+    }
+    
+    void toggleMetrics(bool enabled) {
+        MetricsRegistry::setEnabled(enabled);
+        statusBar->showMessage(enabled ? "Engine metrics enabled" : "Engine metrics disabled", 3000);
+    }
+    
+    void exportMetrics() {
+        QString fileName = QFileDialog::getSaveFileName(this, "Export Metrics", "playwise_metrics.prom",
+                                                        "Prometheus Text (*.prom);;JSON (*.json)");
+        if (!fileName.isEmpty()) {
+            QFile file(fileName);
+            if (file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+                QTextStream out(&file);
+                const MetricsRegistry& registry = MetricsRegistry::instance();
+                out << QString::fromStdString(fileName.endsWith(".json") ? registry.toJson() : registry.toPrometheus());
+                file.close();
+                statusBar->showMessage("Metrics exported to " + fileName, 3000);
+            } else {
+                QMessageBox::critical(this, "Error", "Could not save file!");
+            }
+        }
+    }
+    
     void exportSnapshot() {
         QString fileName = QFileDialog::getSaveFileName(this, "Export Snapshot", "playwise_snapshot.txt", "Text Files (*.txt)");
         if (!fileName.isEmpty()) {
@@ -399,19 +635,8 @@ private slots:
     }
     
     void updateDisplay() {
-        // Update playlist
-        playlistWidget->clear();
-        std::vector<Song> songs = playlistEngine->getSongs();
-        for (const auto& song : songs) {
-            playlistWidget->addItem(QString::fromStdString(song.title) + " - " + QString::fromStdString(song.artist) + " (" + QString::fromStdString(song.getFormattedDuration()) + ")");
-        }
-        
-        // Update history
-        historyWidget->clear();
-        std::vector<Song> history = playbackHistory->getRecentlyPlayed(10);
-        for (const auto& song : history) {
-            historyWidget->addItem(QString::fromStdString(song.title) + " - " + QString::fromStdString(song.artist));
-        }
+        // The playlist view follows engine edits through playlistModel
+        updateHistoryDisplay();
         
         // Update rating tree
         updateRatingTreeDisplay();
@@ -419,15 +644,37 @@ private slots:
         // Update status
         songCountLabel->setText("Songs: " + QString::number(playlistEngine->getSize()));
         
-        int totalDuration = 0;
-        for (const auto& song : songs) {
-            totalDuration += song.duration;
-        }
+        long long totalDuration = playlistEngine->getTotalDuration();
         totalDurationLabel->setText("Duration: " + QString::number(totalDuration / 60) + "m " + QString::number(totalDuration % 60) + "s");
-        
-        // Update memory usage (simulated)
-        int memoryUsage = playlistEngine->getSize() * 100; // Rough estimate
-        memoryUsageBar->setValue(qMin(memoryUsage, 100));
+    }
+    
+    void updateHistoryDisplay() {
+        historyWidget->clear();
+        std::vector<Song> history = playbackHistory->getRecentlyPlayed(10);
+        for (const auto& song : history) {
+            historyWidget->addItem(QString::fromStdString(song.title) + " - " + QString::fromStdString(song.artist));
+        }
+    }
+    
+    void updateMemoryUsage() {
+        // Bar range grows in powers of two so it is never pinned at 100%
+        auto components = snapshot->getMemoryByComponent(*playlistEngine, *playbackHistory, *ratingTree, *songLookup);
+        size_t totalBytes = 0;
+        QString breakdown;
+        for (const auto& component : components) {
+            totalBytes += component.second.totalBytes();
+            breakdown += QString("%1: %2 KB (%3 items)\n")
+                             .arg(QString::fromStdString(component.first))
+                             .arg(component.second.totalBytes() / 1024)
+                             .arg(component.second.items);
+        }
+        int totalKb = static_cast<int>(totalBytes / 1024);
+        int rangeKb = 64;
+        while (rangeKb < totalKb) rangeKb *= 2;
+        memoryUsageBar->setMaximum(rangeKb);
+        memoryUsageBar->setValue(totalKb);
+        memoryUsageBar->setFormat(QString("%1 KB").arg(totalKb));
+        memoryUsageBar->setToolTip(breakdown.trimmed());
     }
     
     void updateRatingTreeDisplay() {
@@ -505,9 +752,7 @@ private:
             std::string artist = std::get<1>(songData);
             int duration = std::get<2>(songData);
             
-            playlistEngine->addSong(title, artist, duration);
-            songLookup->addSong(Song(title, artist, duration));
-            ratingTree->insertSong(Song(title, artist, duration), (rand() % 5) + 1);
+            library->addSong(Song(title, artist, duration), (rand() % 5) + 1);
         }
     }
     
@@ -543,8 +788,9 @@ private:
         songCountLabel = new QLabel("Songs: 0");
         totalDurationLabel = new QLabel("Duration: 0m 0s");
         memoryUsageBar = new QProgressBar();
-        memoryUsageBar->setMaximum(100);
+        memoryUsageBar->setMaximum(64);
         memoryUsageBar->setValue(0);
+        memoryUsageBar->setFormat("0 KB");
         memoryUsageBar->setMaximumWidth(200);
         
         statusBar->addWidget(songCountLabel);
@@ -560,19 +806,26 @@ private:
         QGroupBox* playlistGroup = new QGroupBox("Current Playlist");
         QVBoxLayout* playlistLayout = new QVBoxLayout(playlistGroup);
         
-        playlistWidget = new QListWidget();
-        playlistLayout->addWidget(playlistWidget);
+        playlistModel = new PlaylistModel(playlistEngine, &library->events(), this);
+        playlistView = new QListView();
+        playlistView->setUniformItemSizes(true);  // no per-row size queries on large playlists
+        playlistView->setModel(playlistModel);
+        playlistLayout->addWidget(playlistView);
         
         // Playlist controls
         QHBoxLayout* controlsLayout = new QHBoxLayout();
         
         QPushButton* playBtn = new QPushButton("Play Selected");
+        QPushButton* previousBtn = new QPushButton("Previous");
+        QPushButton* nextBtn = new QPushButton("Next");
         QPushButton* moveUpBtn = new QPushButton("Move Up");
         QPushButton* moveDownBtn = new QPushButton("Move Down");
         QPushButton* reverseBtn = new QPushButton("Reverse");
         QPushButton* shuffleBtn = new QPushButton("Shuffle");
         
+        controlsLayout->addWidget(previousBtn);
         controlsLayout->addWidget(playBtn);
+        controlsLayout->addWidget(nextBtn);
         controlsLayout->addWidget(moveUpBtn);
         controlsLayout->addWidget(moveDownBtn);
         controlsLayout->addWidget(reverseBtn);
@@ -609,6 +862,8 @@ private:
         
         // Connect signals
         connect(playBtn, &QPushButton::clicked, this, &PlayWiseGUI::playSong);
+        connect(previousBtn, &QPushButton::clicked, this, &PlayWiseGUI::playPreviousSong);
+        connect(nextBtn, &QPushButton::clicked, this, &PlayWiseGUI::playNextSong);
         connect(moveUpBtn, &QPushButton::clicked, this, &PlayWiseGUI::moveSongUp);
         connect(moveDownBtn, &QPushButton::clicked, this, &PlayWiseGUI::moveSongDown);
         connect(reverseBtn, &QPushButton::clicked, this, &PlayWiseGUI::reversePlaylist);
@@ -699,7 +954,10 @@ private:
         searchLayout->addWidget(searchTypeCombo, 1, 1);
         
         searchBtn = new QPushButton("Search");
-        searchLayout->addWidget(searchBtn, 2, 0, 1, 2);
+        searchLayout->addWidget(searchBtn, 2, 0);
+        
+        importCatalogBtn = new QPushButton("Import Catalog...");
+        searchLayout->addWidget(importCatalogBtn, 2, 1);
         
         searchResultsWidget = new QListWidget();
         searchLayout->addWidget(new QLabel("Results:"), 3, 0);
@@ -709,6 +967,7 @@ private:
         mainTabWidget->addTab(lookupTab, "Song Lookup");
         
         connect(searchBtn, &QPushButton::clicked, this, &PlayWiseGUI::searchSong);
+        connect(importCatalogBtn, &QPushButton::clicked, this, &PlayWiseGUI::importCatalog);
     }
     
     void createSortingTab() {
@@ -721,7 +980,7 @@ private:
         
         controlsLayout->addWidget(new QLabel("Sort Type:"));
         sortTypeCombo = new QComboBox();
-        sortTypeCombo->addItems({"By Title", "By Duration", "Recently Added"});
+        sortTypeCombo->addItems({"By Title", "By Duration", "Recently Added", "By Artist, Rating"});
         controlsLayout->addWidget(sortTypeCombo);
         
         sortBtn = new QPushButton("Sort Playlist");
@@ -784,6 +1043,11 @@ private:
         exportSnapshotBtn = new QPushButton("Export Snapshot");
         controlsLayout->addWidget(generateSnapshotBtn);
         controlsLayout->addWidget(exportSnapshotBtn);
+        metricsEnabledCheck = new QCheckBox("Collect Engine Metrics");
+        metricsEnabledCheck->setChecked(MetricsRegistry::isEnabled());
+        exportMetricsBtn = new QPushButton("Export Metrics");
+        controlsLayout->addWidget(metricsEnabledCheck);
+        controlsLayout->addWidget(exportMetricsBtn);
         layout->addLayout(controlsLayout);
         
         // Snapshot display
@@ -811,10 +1075,22 @@ private:
         splitter->addWidget(chartsGroup);
         layout->addWidget(splitter);
         
+        // Engine metrics
+        QGroupBox* metricsGroup = new QGroupBox("Engine Metrics");
+        QVBoxLayout* metricsLayout = new QVBoxLayout(metricsGroup);
+        metricsTable = new QTableWidget(0, 6);
+        metricsTable->setHorizontalHeaderLabels({"Component", "Operation", "Count", "p50 (us)", "p99 (us)", "Max (us)"});
+        metricsTable->horizontalHeader()->setStretchLastSection(true);
+        metricsTable->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        metricsLayout->addWidget(metricsTable);
+        layout->addWidget(metricsGroup);
+        
         mainTabWidget->addTab(snapshotTab, "System Snapshot");
         
         connect(generateSnapshotBtn, &QPushButton::clicked, this, &PlayWiseGUI::generateSnapshot);
         connect(exportSnapshotBtn, &QPushButton::clicked, this, &PlayWiseGUI::exportSnapshot);
+        connect(metricsEnabledCheck, &QCheckBox::toggled, this, &PlayWiseGUI::toggleMetrics);
+        connect(exportMetricsBtn, &QPushButton::clicked, this, &PlayWiseGUI::exportMetrics);
     }
     
     void setupConnections() {
@@ -866,16 +1142,16 @@ private:
             QPushButton:pressed {
                 background-color: #005a9e;
             }
-            QListWidget {
+            QListView {
                 border: 1px solid #c0c0c0;
                 border-radius: 4px;
                 background-color: white;
             }
-            QListWidget::item {
+            QListView::item {
                 padding: 4px;
                 border-bottom: 1px solid #f0f0f0;
             }
-            QListWidget::item:selected {
+            QListView::item:selected {
                 background-color: #0078d4;
                 color: white;
             }
@@ -0,0 +1,15 @@
+#ifndef HASH_MIX_H
+#define HASH_MIX_H
+
+#include <cstdint>
+
+// splitmix64 finalizer: every input bit affects every output bit. The
+// sketches (HyperLogLog, CountMinSketch) spread their keys with it.
+inline uint64_t mix64(uint64_t value) {
+    value += 0x9e3779b97f4a7c15ULL;
+    value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+    return value ^ (value >> 31);
+}
+
+#endif // HASH_MIX_H
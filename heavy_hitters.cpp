@@ -0,0 +1,210 @@
+#include "heavy_hitters.h"
+#include "hash_mix.h"
+#include <algorithm>
+
+CountMinSketch::CountMinSketch(size_t width, size_t depth, uint64_t seed)
+    : width(std::max<size_t>(width, 1)), depth(std::max<size_t>(depth, 1)), seed(seed),
+      counters(this->width * this->depth, 0) {}
+
+size_t CountMinSketch::column(int key, size_t row) const {
+    // Rows use independent hashes derived from the seed
+    uint64_t rowSeed = mix64(seed + row);
+    return static_cast<size_t>(mix64(static_cast<uint32_t>(key) ^ rowSeed) % width);
+}
+
+void CountMinSketch::add(int key, unsigned long long count) {
+    for (size_t row = 0; row < depth; row++) {
+        counters[row * width + column(key, row)] += count;
+    }
+}
+
+void CountMinSketch::remove(int key, unsigned long long count) {
+    for (size_t row = 0; row < depth; row++) {
+        unsigned long long& counter = counters[row * width + column(key, row)];
+        counter -= std::min(counter, count);
+    }
+}
+
+bool CountMinSketch::merge(const CountMinSketch& other) {
+    if (!isCompatible(other)) return false;
+    for (size_t i = 0; i < counters.size(); i++) {
+        counters[i] += other.counters[i];
+    }
+    return true;
+}
+
+void CountMinSketch::clear() {
+    std::fill(counters.begin(), counters.end(), 0);
+}
+
+unsigned long long CountMinSketch::estimate(int key) const {
+    unsigned long long lowest = counters[column(key, 0)];
+    for (size_t row = 1; row < depth; row++) {
+        lowest = std::min(lowest, counters[row * width + column(key, row)]);
+    }
+    return lowest;
+}
+
+bool CountMinSketch::isCompatible(const CountMinSketch& other) const {
+    return width == other.width && depth == other.depth && seed == other.seed;
+}
+
+MemoryUsage CountMinSketch::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.items = counters.size();
+    usage.structureBytes = counters.capacity() * sizeof(unsigned long long);
+    return usage;
+}
+
+HeavyHitterTracker::HeavyHitterTracker(const HeavyHitterOptions& options)
+    : options(options), sketch(options.sketchWidth, options.sketchDepth, options.seed) {
+    this->options.trackedSongs = std::max<size_t>(this->options.trackedSongs, 1);
+}
+
+void HeavyHitterTracker::setCount(int songId, Entry& entry, unsigned long long count) {
+    byCount.erase({entry.count, songId});
+    entry.count = count;
+    entry.error = std::min(entry.error, count);
+    byCount.insert({count, songId});
+}
+
+void HeavyHitterTracker::evictLowest() {
+    auto lowest = byCount.begin();
+    tracked.erase(lowest->second);
+    byCount.erase(lowest);
+}
+
+void HeavyHitterTracker::add(const Song& song) {
+    int songId = song.id;
+    sketch.add(songId);
+    totalPlays++;
+    
+    auto it = tracked.find(songId);
+    if (it != tracked.end()) {
+        setCount(songId, it->second, it->second.count + 1);
+        return;
+    }
+    
+    // Space-Saving: the lowest entry makes room. The newcomer starts from the
+    // sketch estimate, which covers any plays it had while untracked
+    if (tracked.size() >= options.trackedSongs) evictLowest();
+    unsigned long long count = sketch.estimate(songId);
+    Entry entry;
+    entry.count = count;
+    entry.error = count - 1;
+    entry.label = song.title + " by " + song.artist;
+    tracked.emplace(songId, std::move(entry));
+    byCount.insert({count, songId});
+}
+
+void HeavyHitterTracker::remove(int songId) {
+    if (totalPlays == 0) return;
+    sketch.remove(songId);
+    totalPlays--;
+    
+    auto it = tracked.find(songId);
+    if (it == tracked.end()) return;
+    if (it->second.count <= 1) {
+        byCount.erase({it->second.count, songId});
+        tracked.erase(it);
+    } else {
+        setCount(songId, it->second, it->second.count - 1);
+    }
+}
+
+bool HeavyHitterTracker::merge(const HeavyHitterTracker& other) {
+    if (!sketch.isCompatible(other.sketch)) return false;
+    
+    // A song missing from one side may still have plays there; that side's
+    // sketch estimate bounds them
+    std::unordered_map<int, Entry> merged;
+    for (const auto& song : tracked) {
+        Entry entry = song.second;
+        auto theirs = other.tracked.find(song.first);
+        if (theirs != other.tracked.end()) {
+            entry.count += theirs->second.count;
+            entry.error += theirs->second.error;
+        } else {
+            unsigned long long bound = other.sketch.estimate(song.first);
+            entry.count += bound;
+            entry.error += bound;
+        }
+        merged.emplace(song.first, std::move(entry));
+    }
+    for (const auto& song : other.tracked) {
+        if (merged.count(song.first)) continue;
+        Entry entry = song.second;
+        unsigned long long bound = sketch.estimate(song.first);
+        entry.count += bound;
+        entry.error += bound;
+        merged.emplace(song.first, std::move(entry));
+    }
+    
+    sketch.merge(other.sketch);
+    totalPlays += other.totalPlays;
+    tracked.clear();
+    byCount.clear();
+    for (auto& song : merged) {
+        Entry& entry = song.second;
+        entry.count = std::min(entry.count, sketch.estimate(song.first));
+        entry.error = std::min(entry.error, entry.count);
+        byCount.insert({entry.count, song.first});
+        tracked.emplace(song.first, std::move(entry));
+    }
+    while (tracked.size() > options.trackedSongs) {
+        evictLowest();
+    }
+    return true;
+}
+
+void HeavyHitterTracker::configure(const HeavyHitterOptions& newOptions) {
+    options = newOptions;
+    options.trackedSongs = std::max<size_t>(options.trackedSongs, 1);
+    sketch = CountMinSketch(options.sketchWidth, options.sketchDepth, options.seed);
+    tracked.clear();
+    byCount.clear();
+    totalPlays = 0;
+}
+
+void HeavyHitterTracker::clear() {
+    sketch.clear();
+    tracked.clear();
+    byCount.clear();
+    totalPlays = 0;
+}
+
+std::vector<HeavyHitter> HeavyHitterTracker::top(size_t count) const {
+    std::vector<HeavyHitter> result;
+    for (const auto& song : tracked) {
+        HeavyHitter hitter;
+        hitter.songId = song.first;
+        hitter.label = song.second.label;
+        hitter.count = song.second.count;
+        hitter.error = song.second.error;
+        result.push_back(std::move(hitter));
+    }
+    auto higher = [](const HeavyHitter& a, const HeavyHitter& b) {
+        return a.count != b.count ? a.count > b.count : a.songId < b.songId;
+    };
+    size_t kept = std::min(count, result.size());
+    std::partial_sort(result.begin(), result.begin() + kept, result.end(), higher);
+    result.resize(kept);
+    return result;
+}
+
+unsigned long long HeavyHitterTracker::estimate(int songId) const {
+    auto it = tracked.find(songId);
+    return it != tracked.end() ? it->second.count : sketch.estimate(songId);
+}
+
+MemoryUsage HeavyHitterTracker::getMemoryUsage() const {
+    MemoryUsage usage = sketch.getMemoryUsage();
+    usage.items = tracked.size();
+    // std::set node: three links and a colour next to the value
+    usage.structureBytes += hashTableBytes(tracked) +
+                            byCount.size() * (4 * sizeof(void*) + sizeof(std::pair<unsigned long long, int>));
+    for (const auto& song : tracked) {
+        usage.stringBytes += stringHeapBytes(song.second.label);
+    }
+    return usage;
+}
@@ -0,0 +1,124 @@
+#ifndef HEAVY_HITTERS_H
+#define HEAVY_HITTERS_H
+
+#include "song.h"
+#include "memory_usage.h"
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Size of a heavy-hitter tracker. Memory is fixed by these numbers, not by
+// how many plays or distinct songs are seen: the sketch takes
+// sketchWidth * sketchDepth counters and the tracker at most trackedSongs
+// entries. A sketch estimate exceeds the true count by more than
+// e/sketchWidth of all plays with probability at most e^-sketchDepth.
+struct HeavyHitterOptions {
+    size_t sketchWidth = 2048;
+    size_t sketchDepth = 4;
+    size_t trackedSongs = 64;
+    uint64_t seed = 0x5eed;  // trackers merge only when width, depth and seed match
+};
+
+// One tracked song: the true play count lies in [count - error, count]
+struct HeavyHitter {
+    int songId = 0;
+    std::string label;
+    unsigned long long count = 0;
+    unsigned long long error = 0;
+};
+
+// Count-Min sketch over integer keys: depth rows of width counters, one
+// hashed counter per row. estimate() never undercounts while every remove()
+// matches an earlier add().
+class CountMinSketch {
+private:
+    size_t width;
+    size_t depth;
+    uint64_t seed;
+    std::vector<unsigned long long> counters;  // row-major, depth x width
+    
+    size_t column(int key, size_t row) const;
+
+public:
+    // Constructor
+    CountMinSketch(size_t width, size_t depth, uint64_t seed);
+    
+    // Core operations
+    void add(int key, unsigned long long count = 1);
+    void remove(int key, unsigned long long count = 1);  // counters never drop below zero
+    bool merge(const CountMinSketch& other);             // false if the shapes or seeds differ
+    void clear();
+    
+    // Queries
+    unsigned long long estimate(int key) const;
+    bool isCompatible(const CountMinSketch& other) const;
+    MemoryUsage getMemoryUsage() const;
+    
+    // Time complexity annotations:
+    // add / remove / estimate: O(d) - one counter per row
+    // merge / clear: O(w * d)
+};
+
+// Approximate top played songs in fixed memory.
+//
+// A Count-Min sketch counts every play; a Space-Saving table keeps the
+// trackedSongs songs with the highest counts. When a new song arrives and
+// the table is full, it replaces the entry with the lowest count and starts
+// from its sketch estimate; everything but the current play counts as
+// error. A tracked count never falls below the song's true plays, and
+// count - error never exceeds them.
+//
+// Trackers built with the same options can be merged, e.g. one per thread
+// or per node. remove() reverses an add() (undo of a play); a song that was
+// evicted in between only loses the play from the sketch.
+class HeavyHitterTracker {
+private:
+    struct Entry {
+        unsigned long long count = 0;
+        unsigned long long error = 0;
+        std::string label;
+    };
+    
+    HeavyHitterOptions options;
+    CountMinSketch sketch;
+    std::unordered_map<int, Entry> tracked;
+    std::set<std::pair<unsigned long long, int>> byCount;  // (count, song id), lowest first
+    unsigned long long totalPlays = 0;
+    
+    void setCount(int songId, Entry& entry, unsigned long long count);
+    void evictLowest();
+
+public:
+    // Constructor
+    explicit HeavyHitterTracker(const HeavyHitterOptions& options = HeavyHitterOptions());
+    
+    HeavyHitterTracker(const HeavyHitterTracker&) = delete;
+    HeavyHitterTracker& operator=(const HeavyHitterTracker&) = delete;
+    
+    // Core operations
+    void add(const Song& song);  // the "title by artist" label is built only when the song starts being tracked
+    void remove(int songId);
+    bool merge(const HeavyHitterTracker& other);  // false if the options are incompatible
+    void configure(const HeavyHitterOptions& newOptions);  // resizes and clears
+    void clear();
+    
+    // Queries
+    std::vector<HeavyHitter> top(size_t count) const;  // highest count first, ties by lower id
+    unsigned long long estimate(int songId) const;      // tracked count, else the sketch estimate
+    unsigned long long getTotalPlays() const { return totalPlays; }
+    const HeavyHitterOptions& getOptions() const { return options; }
+    MemoryUsage getMemoryUsage() const;
+    
+    // Time complexity annotations:
+    // add / remove: O(d + log t) - d sketch rows, t tracked songs
+    // merge: O(w * d + t log t)
+    // configure / clear: O(w * d + t)
+    // top: O(t log t)
+    // estimate: O(d)
+};
+
+#endif // HEAVY_HITTERS_H
@@ -0,0 +1,172 @@
+#include "hyper_log_log.h"
+#include "hash_mix.h"
+#include <algorithm>
+#include <cmath>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace {
+
+// FNV-1a, finished with mix64 so nearby strings spread over all bits
+uint64_t hashString(const std::string& text) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : text) {
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    return mix64(hash);
+}
+
+// Leading zero bits of a non-zero value
+int countLeadingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(value);
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+    unsigned long highest = 0;
+    _BitScanReverse64(&highest, value);
+    return 63 - static_cast<int>(highest);
+#else
+    int zeros = 0;
+    while (!(value & (uint64_t(1) << 63))) {
+        value <<= 1;
+        zeros++;
+    }
+    return zeros;
+#endif
+}
+
+}  // namespace
+
+HyperLogLog::HyperLogLog(int precision)
+    : precision(std::max(kMinPrecision, std::min(precision, kMaxPrecision))),
+      registers(size_t(1) << this->precision, 0) {}
+
+void HyperLogLog::addHash(uint64_t hash) {
+    size_t index = static_cast<size_t>(hash >> (64 - precision));
+    uint64_t rest = hash << precision;
+    // Leading zeros of the remaining 64 - precision bits, plus one
+    int maxRank = 64 - precision + 1;
+    int rank = rest == 0 ? maxRank : std::min(countLeadingZeros(rest) + 1, maxRank);
+    if (registers[index] < rank) registers[index] = static_cast<uint8_t>(rank);
+}
+
+void HyperLogLog::add(int key) {
+    addHash(mix64(static_cast<uint32_t>(key)));
+}
+
+void HyperLogLog::add(const std::string& key) {
+    addHash(hashString(key));
+}
+
+bool HyperLogLog::merge(const HyperLogLog& other) {
+    if (precision != other.precision) return false;
+    for (size_t i = 0; i < registers.size(); i++) {
+        registers[i] = std::max(registers[i], other.registers[i]);
+    }
+    return true;
+}
+
+void HyperLogLog::clear() {
+    std::fill(registers.begin(), registers.end(), 0);
+}
+
+double HyperLogLog::estimate() const {
+    const double m = static_cast<double>(registers.size());
+    double harmonicSum = 0.0;
+    size_t zeroRegisters = 0;
+    for (uint8_t value : registers) {
+        harmonicSum += std::ldexp(1.0, -value);
+        if (value == 0) zeroRegisters++;
+    }
+    
+    double alpha = registers.size() == 16 ? 0.673
+                 : registers.size() == 32 ? 0.697
+                 : registers.size() == 64 ? 0.709
+                 : 0.7213 / (1.0 + 1.079 / m);
+    double raw = alpha * m * m / harmonicSum;
+    
+    // Small cardinalities: linear counting over the empty registers is
+    // far more accurate than the raw estimate
+    if (raw <= 2.5 * m && zeroRegisters > 0) {
+        return m * std::log(m / static_cast<double>(zeroRegisters));
+    }
+    return raw;
+}
+
+bool HyperLogLog::empty() const {
+    return std::all_of(registers.begin(), registers.end(), [](uint8_t value) { return value == 0; });
+}
+
+MemoryUsage HyperLogLog::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.items = registers.size();
+    usage.structureBytes = registers.capacity();
+    return usage;
+}
+
+WindowedHyperLogLog::WindowedHyperLogLog(long long slotSeconds, int slotCount, int precision)
+    : slotSeconds(std::max(slotSeconds, 1LL)) {
+    Slot empty;
+    empty.sketch = HyperLogLog(precision);
+    slots.assign(static_cast<size_t>(std::max(slotCount, 1)), empty);
+}
+
+long long WindowedHyperLogLog::slotIndexOf(std::chrono::system_clock::time_point time) const {
+    long long seconds = std::chrono::duration_cast<std::chrono::seconds>(time.time_since_epoch()).count();
+    // Floor division, so times before the epoch still land in distinct slots
+    return seconds / slotSeconds - (seconds % slotSeconds < 0 ? 1 : 0);
+}
+
+HyperLogLog* WindowedHyperLogLog::sketchAt(std::chrono::system_clock::time_point time) {
+    long long index = slotIndexOf(time);
+    long long count = static_cast<long long>(slots.size());
+    Slot& slot = slots[static_cast<size_t>(((index % count) + count) % count)];
+    if (slot.index > index) return nullptr;  // older than the window
+    if (slot.index < index) {
+        slot.index = index;
+        slot.sketch.clear();
+    }
+    return &slot.sketch;
+}
+
+void WindowedHyperLogLog::add(int key, std::chrono::system_clock::time_point when) {
+    if (HyperLogLog* sketch = sketchAt(when)) sketch->add(key);
+}
+
+void WindowedHyperLogLog::add(const std::string& key, std::chrono::system_clock::time_point when) {
+    if (HyperLogLog* sketch = sketchAt(when)) sketch->add(key);
+}
+
+void WindowedHyperLogLog::clear() {
+    for (auto& slot : slots) {
+        slot.index = -1;
+        slot.sketch.clear();
+    }
+}
+
+HyperLogLog WindowedHyperLogLog::unionOfLast(int slotCount, std::chrono::system_clock::time_point now) const {
+    HyperLogLog result(slots.front().sketch.getPrecision());
+    long long current = slotIndexOf(now);
+    long long count = static_cast<long long>(slots.size());
+    slotCount = std::max(0, std::min(slotCount, static_cast<int>(count)));
+    for (long long index = current - slotCount + 1; index <= current; index++) {
+        const Slot& slot = slots[static_cast<size_t>(((index % count) + count) % count)];
+        if (slot.index == index) result.merge(slot.sketch);
+    }
+    return result;
+}
+
+double WindowedHyperLogLog::estimateLast(int slotCount, std::chrono::system_clock::time_point now) const {
+    return unionOfLast(slotCount, now).estimate();
+}
+
+MemoryUsage WindowedHyperLogLog::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.structureBytes = slots.capacity() * sizeof(Slot);
+    for (const auto& slot : slots) {
+        MemoryUsage sketch = slot.sketch.getMemoryUsage();
+        usage.items += sketch.items;
+        usage.structureBytes += sketch.structureBytes;
+    }
+    return usage;
+}
@@ -0,0 +1,90 @@
+#ifndef HYPER_LOG_LOG_H
+#define HYPER_LOG_LOG_H
+
+#include "memory_usage.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Distinct-count estimate in 2^precision one-byte registers.
+//
+// Each key is hashed to 64 bits; the top precision bits pick a register,
+// which keeps the longest run of leading zeros seen in the rest. The
+// standard error is about 1.04 / sqrt(2^precision), e.g. 1.6% at the
+// default precision of 12 (4 KB). Sketches of the same precision merge by
+// taking the larger register, which is exactly the sketch of the union.
+// Keys cannot be removed.
+class HyperLogLog {
+public:
+    static constexpr int kMinPrecision = 4;
+    static constexpr int kMaxPrecision = 16;
+
+private:
+    int precision;
+    std::vector<uint8_t> registers;
+
+public:
+    // Constructor
+    explicit HyperLogLog(int precision = 12);  // clamped to [kMinPrecision, kMaxPrecision]
+    
+    // Core operations
+    void addHash(uint64_t hash);
+    void add(int key);
+    void add(const std::string& key);
+    bool merge(const HyperLogLog& other);  // false if the precisions differ
+    void clear();
+    
+    // Queries
+    double estimate() const;
+    bool empty() const;
+    int getPrecision() const { return precision; }
+    MemoryUsage getMemoryUsage() const;
+    
+    // Time complexity annotations:
+    // addHash / add: O(1) (O(L) to hash a string key)
+    // merge / estimate / clear / empty: O(m) - m = 2^precision registers
+};
+
+// Distinct-count estimates over a sliding time window.
+//
+// Time is cut into slots of slotSeconds; the last slotCount slots each
+// have their own HyperLogLog, reused in a ring as time moves on. The count
+// for the last n slots is the estimate of the union of their sketches, so
+// the window always ends at the current slot and covers whole slots.
+class WindowedHyperLogLog {
+private:
+    struct Slot {
+        long long index = -1;  // slots since the epoch, -1 = unused
+        HyperLogLog sketch;
+    };
+    
+    long long slotSeconds;
+    std::vector<Slot> slots;  // slot i holds every index with index % slotCount == i
+    
+    long long slotIndexOf(std::chrono::system_clock::time_point time) const;
+    HyperLogLog* sketchAt(std::chrono::system_clock::time_point time);  // recycles a stale slot; null if too old
+
+public:
+    // Constructor
+    WindowedHyperLogLog(long long slotSeconds, int slotCount, int precision = 12);
+    
+    // Core operations
+    void add(int key, std::chrono::system_clock::time_point when);
+    void add(const std::string& key, std::chrono::system_clock::time_point when);
+    void clear();
+    
+    // Queries
+    HyperLogLog unionOfLast(int slotCount, std::chrono::system_clock::time_point now) const;
+    double estimateLast(int slotCount, std::chrono::system_clock::time_point now) const;
+    long long getSlotSeconds() const { return slotSeconds; }
+    int getSlotCount() const { return static_cast<int>(slots.size()); }
+    MemoryUsage getMemoryUsage() const;
+    
+    // Time complexity annotations:
+    // add: O(1) (O(m) when a slot is recycled)
+    // unionOfLast / estimateLast: O(n * m) - n slots merged
+};
+
+#endif // HYPER_LOG_LOG_H
@@ -0,0 +1,199 @@
+#include "library.h"
+
+Library::Library() {
+    playlistEngine.setEventBus(&eventBus);
+    playbackHistory.setEventBus(&eventBus);
+    ratingTree.setEventBus(&eventBus);
+    indexSubscription = eventBus.subscribe([this](const std::vector<EngineEvent>& events) {
+        filterIndex.apply(events);
+        catalogColumns.apply(events);
+        for (const auto& event : events) {
+            if (event.type == EngineEventType::SONG_ADDED) {
+                playlistEntries[event.songId]++;
+            } else if (event.type == EngineEventType::SONG_REMOVED) {
+                auto entry = playlistEntries.find(event.songId);
+                if (entry != playlistEntries.end() && --entry->second <= 0) playlistEntries.erase(entry);
+            }
+        }
+    });
+}
+
+Library::~Library() {
+    eventBus.unsubscribe(indexSubscription);
+    playlistEngine.setEventBus(nullptr);
+    playbackHistory.setEventBus(nullptr);
+    ratingTree.setEventBus(nullptr);
+}
+
+int Library::addSong(const Song& song, int rating) {
+    EventBatch batch(&eventBus);
+    playlistEngine.addSong(song);
+    songLookup.addSong(song);
+    filterIndex.addSong(song);
+    catalogColumns.addSong(song);
+    if (rating >= 1 && rating <= 5) {
+        ratingTree.insertSong(song, rating);
+        userRatingStore.rate(kLocalUserId, song.id, rating);
+    }
+    return song.id;
+}
+
+void Library::addSongs(const std::vector<Song>& songs, const std::vector<int>& ratings) {
+    EventBatch batch(&eventBus);
+    playlistEngine.addSongs(songs);
+    songLookup.addSongs(songs);
+    for (const auto& song : songs) {
+        filterIndex.addSong(song);
+        catalogColumns.addSong(song);
+    }
+    
+    std::vector<std::pair<Song, int>> ratedSongs;
+    for (size_t i = 0; i < songs.size() && i < ratings.size(); i++) {
+        if (ratings[i] >= 1 && ratings[i] <= 5) {
+            ratedSongs.push_back({songs[i], ratings[i]});
+        }
+    }
+    if (!ratedSongs.empty()) {
+        ratingTree.insertSongs(ratedSongs);
+    }
+    for (const auto& ratedSong : ratedSongs) {
+        userRatingStore.rate(kLocalUserId, ratedSong.first.id, ratedSong.second);
+    }
+}
+
+bool Library::removeSong(int songId) {
+    return removeSongs({songId}) > 0;
+}
+
+bool Library::removeSongAt(int index) {
+    const Song* song = playlistEngine.getSongAt(index);
+    return song && removeSong(song->id);
+}
+
+size_t Library::removeSongs(const std::unordered_set<int>& songIds) {
+    // History keeps its entries: it records what was played, not the catalog
+    std::unordered_set<int> removedIds;
+    for (int songId : songIds) {
+        if (playlistEntries.count(songId)) removedIds.insert(songId);
+    }
+    
+    EventBatch batch(&eventBus);
+    playlistEngine.deleteSongsById(songIds);
+    for (int songId : songIds) {
+        if (songLookup.deleteById(songId)) removedIds.insert(songId);
+        if (userRatingStore.removeSong(songId)) removedIds.insert(songId);
+        filterIndex.removeSong(songId);
+        catalogColumns.removeSong(songId);
+    }
+    
+    // Ratings can outlive the catalog entry in files from older versions
+    std::vector<int> unratedIds;
+    ratingTree.deleteSongsById(songIds, &unratedIds);
+    removedIds.insert(unratedIds.begin(), unratedIds.end());
+    return removedIds.size();
+}
+
+bool Library::rateSong(int songId, int rating) {
+    if (rating < 1 || rating > 5) return false;
+    
+    const Song* song = songLookup.searchById(songId);
+    if (!song) return false;
+    
+    EventBatch batch(&eventBus);
+    ratingTree.deleteSongById(songId);
+    ratingTree.insertSong(*song, rating);
+    userRatingStore.rate(kLocalUserId, songId, rating);
+    return true;
+}
+
+bool Library::rateSongAsUser(int userId, int songId, double rating) {
+    if (!songLookup.searchById(songId)) return false;
+    return userRatingStore.rate(userId, songId, rating);
+}
+
+bool Library::playSong(int songId) {
+    const Song* song = songLookup.searchById(songId);
+    if (!song) return false;
+    
+    playbackHistory.addPlayedSong(*song);
+    return true;
+}
+
+void Library::undoLastNEdits(int n) {
+    // Undo restores or drops playlist entries; mirror that in the lookup.
+    // Ratings removed with a song are not part of the playlist undo log, so a
+    // restored song comes back unrated.
+    std::unordered_map<int, Song> undoneSongs;
+    for (const auto& action : playlistEngine.getLastActions(n)) {
+        undoneSongs.emplace(action.song.id, action.song);
+    }
+    
+    std::unordered_set<int> changedIds;
+    int subscription = eventBus.subscribe([&changedIds](const std::vector<EngineEvent>& events) {
+        for (const auto& event : events) {
+            if (event.type == EngineEventType::SONG_ADDED || event.type == EngineEventType::SONG_REMOVED) {
+                changedIds.insert(event.songId);
+            }
+        }
+    });
+    playlistEngine.undoLastNEdits(n);
+    eventBus.unsubscribe(subscription);
+    
+    // playlistEntries already reflects the undo: the index subscriber ran first
+    for (int songId : changedIds) {
+        if (!playlistEntries.count(songId)) {
+            songLookup.deleteById(songId);
+            filterIndex.removeSong(songId);
+            catalogColumns.removeSong(songId);
+        } else if (!songLookup.searchById(songId)) {
+            auto undone = undoneSongs.find(songId);
+            if (undone == undoneSongs.end()) continue;
+            songLookup.addSong(undone->second);
+            filterIndex.addSong(undone->second);
+            catalogColumns.addSong(undone->second);
+        }
+    }
+}
+
+std::vector<Song> Library::findSongs(const SongFilter& filter, size_t limit) const {
+    std::vector<Song> songs;
+    for (int songId : filterIndex.query(filter, limit)) {
+        const Song* song = songLookup.searchById(songId);
+        if (song) songs.push_back(*song);
+    }
+    return songs;
+}
+
+void Library::rebuildIndexes() {
+    filterIndex.clearCatalog();
+    catalogColumns.clear();
+    playlistEntries.clear();
+    for (const auto& song : playlistEngine.getSongs()) {
+        // Files from older versions may hold playlist songs the lookup lacks
+        if (!songLookup.searchById(song.id)) songLookup.addSong(song);
+        filterIndex.addSong(song);
+        catalogColumns.addSong(song);
+        playlistEntries[song.id]++;
+    }
+    for (const auto& song : songLookup.getAllSongs()) {
+        filterIndex.addSong(song);
+        catalogColumns.addSong(song);
+    }
+    for (const auto& bucket : ratingTree.getAllRatings()) {
+        for (const auto& song : bucket.second) {
+            filterIndex.addRating(song.id, bucket.first);
+            catalogColumns.setRating(song.id, bucket.first);
+            userRatingStore.rate(kLocalUserId, song.id, bucket.first);
+        }
+    }
+    
+    // A load may have replaced the history, so the play windows are refilled
+    // from the stored play times rather than kept from before
+    filterIndex.clearPlays();
+    auto now = std::chrono::system_clock::now();
+    auto recent = playbackHistory.playLog().playsBetween(now - std::chrono::hours(SongFilterIndex::kRecencyHours),
+                                                         std::chrono::system_clock::time_point::max());
+    for (const auto& play : recent) {
+        filterIndex.recordPlay(play.second.songId, fromEpochMicros(play.second.playedMicros));
+    }
+}
@@ -0,0 +1,100 @@
+#ifndef LIBRARY_H
+#define LIBRARY_H
+
+#include "song.h"
+#include "playlist_engine.h"
+#include "playback_history.h"
+#include "song_rating_tree.h"
+#include "song_lookup.h"
+#include "rating_store.h"
+#include "song_filter_index.h"
+#include "song_columns.h"
+#include "event_bus.h"
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+// Owns the playlist, playback history, rating tree and lookup tables and
+// keeps them consistent: adding a song puts it in the playlist, the lookup
+// and (when rated) the rating tree; removing it takes it out of all three,
+// keyed by song id. Per-user fractional ratings live in a RatingStore next
+// to the star-bucket tree and are removed with the song. Undoing playlist
+// edits through the library re-syncs the lookup as well.
+//
+// Reads and order-only playlist edits (move, reverse, shuffle) go straight
+// to the components. Every component publishes on the library's event bus.
+// The filter index and the columnar catalog follow ratings and plays through
+// that bus; loaders and importers that write to the components directly
+// call rebuildIndexes() afterwards. The RatingStore is not saved: a rebuild
+// fills it with the local user's star ratings from the tree, and ratings
+// of other users last only until the program exits.
+class Library {
+private:
+    PlaylistEngine playlistEngine;
+    PlaybackHistory playbackHistory;
+    SongRatingTree ratingTree;
+    SongLookup songLookup;
+    RatingStore userRatingStore;
+    EventBus eventBus;
+    SongFilterIndex filterIndex;
+    SongColumns catalogColumns;
+    int indexSubscription;
+    std::unordered_map<int, int> playlistEntries;  // song id -> entries in the playlist, kept from the bus
+
+public:
+    // User id that console and GUI ratings are recorded under
+    static const int kLocalUserId = 0;
+    
+    // Constructor and destructor
+    Library();
+    ~Library();
+    
+    Library(const Library&) = delete;
+    Library& operator=(const Library&) = delete;
+    
+    // Catalog mutations, applied to every index. Ratings outside 1-5 mean unrated.
+    int addSong(const Song& song, int rating = 0);  // returns the song id
+    void addSongs(const std::vector<Song>& songs, const std::vector<int>& ratings = std::vector<int>());
+    bool removeSong(int songId);
+    bool removeSongAt(int index);
+    size_t removeSongs(const std::unordered_set<int>& songIds);  // returns distinct ids removed
+    bool rateSong(int songId, int rating);  // replaces any earlier rating
+    bool rateSongAsUser(int userId, int songId, double rating);  // catalog songs only
+    bool playSong(int songId);
+    void undoLastNEdits(int n);  // restored songs come back unrated
+    
+    // Filtered queries over the catalog; counting reads no Song
+    size_t countSongs(const SongFilter& filter) const { return filterIndex.count(filter); }
+    std::vector<Song> findSongs(const SongFilter& filter, size_t limit = static_cast<size_t>(-1)) const;
+    void rebuildIndexes();  // after loading or importing straight into the components
+    
+    // Components
+    PlaylistEngine& playlist() { return playlistEngine; }
+    PlaybackHistory& history() { return playbackHistory; }
+    SongRatingTree& ratings() { return ratingTree; }
+    SongLookup& lookup() { return songLookup; }
+    RatingStore& userRatings() { return userRatingStore; }
+    EventBus& events() { return eventBus; }
+    const SongFilterIndex& filters() const { return filterIndex; }
+    const SongColumns& columns() const { return catalogColumns; }
+    const PlaylistEngine& playlist() const { return playlistEngine; }
+    const PlaybackHistory& history() const { return playbackHistory; }
+    const SongRatingTree& ratings() const { return ratingTree; }
+    const SongLookup& lookup() const { return songLookup; }
+    const RatingStore& userRatings() const { return userRatingStore; }
+    
+    // Time complexity annotations:
+    // addSong: O(L + log r) - lookup insertion and rating bucket search
+    // addSongs: O(k * L) - one batched insert per index
+    // removeSong / removeSongs: O(n) - one pass over the playlist and the rating buckets
+    // removeSongAt: O(n) - index walk, then removeSong
+    // rateSong: O(n) - drops earlier ratings, then O(log r) insertion
+    // rateSongAsUser: O(log s) - id lookup and RatingStore::rate
+    // playSong: O(1) - id lookup and history push
+    // undoLastNEdits: as PlaylistEngine, plus O(L) per restored or removed song (presence is an O(1) count)
+    // countSongs: see SongFilterIndex::count
+    // findSongs: SongFilterIndex::evaluate plus O(m) id lookups
+    // rebuildIndexes: O(n * L + r log s + p) - every catalog, playlist and rated song, p plays of the last week
+};
+
+#endif // LIBRARY_H
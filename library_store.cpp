@@ -0,0 +1,477 @@
+#include "library_store.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <io.h>
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+const char* const kDefaultLibraryPath = "playwise.lib";
+
+namespace {
+
+const char kMagic[8] = {'P', 'W', 'L', 'I', 'B', 0, 0, 0};
+const uint32_t kFormatVersion = 2;
+const uint32_t kOldestReadableVersion = 1;
+
+// Version 1 headers end before walSequence
+const size_t kVersion1HeaderSize = offsetof(LibraryFileHeader, walSequence);
+const uint32_t kByteOrderMark = 0x01020304;
+
+const size_t kSectionCount = static_cast<size_t>(LibrarySection::COUNT);
+
+size_t alignUp(size_t value) {
+    return (value + 7) & ~static_cast<size_t>(7);
+}
+
+// Encodes one section: fixed-width records followed by the section's string heap
+template <typename Record>
+class SectionWriter {
+private:
+    std::vector<Record> records;
+    std::string heap;
+    
+public:
+    explicit SectionWriter(size_t expected) {
+        records.reserve(expected);
+    }
+    
+    Record& add(const Song& song) {
+        Record record;
+        std::memset(&record, 0, sizeof(record));
+        SongRecord& songRecord = reinterpret_cast<SongRecord&>(record);
+        songRecord.id = song.id;
+        songRecord.duration = song.duration;
+        songRecord.addedTimeMicros = toEpochMicros(song.addedTime);
+        songRecord.titleOffset = static_cast<uint32_t>(heap.size());
+        songRecord.titleLength = static_cast<uint32_t>(song.title.size());
+        heap += song.title;
+        songRecord.artistOffset = static_cast<uint32_t>(heap.size());
+        songRecord.artistLength = static_cast<uint32_t>(song.artist.size());
+        heap += song.artist;
+        records.push_back(record);
+        return records.back();
+    }
+    
+    std::string finish() const {
+        std::string bytes(records.size() * sizeof(Record), '\0');
+        if (!records.empty()) {
+            std::memcpy(&bytes[0], records.data(), bytes.size());
+        }
+        bytes += heap;
+        return bytes;
+    }
+    
+    size_t count() const { return records.size(); }
+};
+
+static_assert(offsetof(PlayedSongRecord, song) == 0, "song record must come first");
+static_assert(offsetof(RatedSongRecord, song) == 0, "song record must come first");
+static_assert(offsetof(ActionRecord, song) == 0, "song record must come first");
+
+bool writeAll(FILE* file, const char* data, size_t size) {
+    return size == 0 || std::fwrite(data, 1, size, file) == size;
+}
+
+bool flushToDisk(FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#if defined(_WIN32)
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+bool replaceFile(const std::string& from, const std::string& to) {
+#if defined(_WIN32)
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+// LibraryView
+
+LibraryView::LibraryView() : header(nullptr) {
+}
+
+bool LibraryView::open(const std::string& path) {
+    close();
+    if (!file.open(path)) {
+        return false;
+    }
+    
+    if (file.size() < kVersion1HeaderSize) {
+        close();
+        return false;
+    }
+    
+    const LibraryFileHeader* candidate = reinterpret_cast<const LibraryFileHeader*>(file.data());
+    if (std::memcmp(candidate->magic, kMagic, sizeof(kMagic)) != 0 ||
+        candidate->version < kOldestReadableVersion || candidate->version > kFormatVersion ||
+        candidate->byteOrder != kByteOrderMark || candidate->sectionCount != kSectionCount ||
+        (candidate->version >= 2 && file.size() < sizeof(LibraryFileHeader))) {
+        close();
+        return false;
+    }
+    
+    for (size_t i = 0; i < kSectionCount; i++) {
+        // Records are read through their structs, so they must be at least that large
+        size_t minRecordSize = i == static_cast<size_t>(LibrarySection::RATINGS)  ? sizeof(RatedSongRecord)
+                             : i == static_cast<size_t>(LibrarySection::UNDO_LOG) ? sizeof(ActionRecord)
+                                                                                  : sizeof(SongRecord);
+        const LibrarySectionEntry& entry = candidate->sections[i];
+        bool valid = entry.type == i && entry.offset % 8 == 0 &&
+                     entry.offset <= file.size() && entry.size <= file.size() - entry.offset &&
+                     entry.recordSize >= minRecordSize && entry.recordCount <= entry.size / entry.recordSize;
+        if (!valid) {
+            close();
+            return false;
+        }
+    }
+    
+    header = candidate;
+    return true;
+}
+
+uint64_t LibraryView::walSequence() const {
+    return header && header->version >= 2 ? header->walSequence : 0;
+}
+
+void LibraryView::close() {
+    header = nullptr;
+    file.close();
+}
+
+const char* LibraryView::sectionBase(LibrarySection section) const {
+    return file.data() + header->sections[static_cast<size_t>(section)].offset;
+}
+
+size_t LibraryView::recordCount(LibrarySection section) const {
+    return header ? header->sections[static_cast<size_t>(section)].recordCount : 0;
+}
+
+const SongRecord& LibraryView::songRecord(LibrarySection section, size_t index) const {
+    const LibrarySectionEntry& entry = header->sections[static_cast<size_t>(section)];
+    return *reinterpret_cast<const SongRecord*>(sectionBase(section) + index * entry.recordSize);
+}
+
+const RatedSongRecord& LibraryView::ratedSongRecord(size_t index) const {
+    return reinterpret_cast<const RatedSongRecord&>(songRecord(LibrarySection::RATINGS, index));
+}
+
+bool LibraryView::playedAt(size_t index, int64_t& playedAtMicros) const {
+    if (recordSize(LibrarySection::HISTORY) < sizeof(PlayedSongRecord)) return false;
+    playedAtMicros = reinterpret_cast<const PlayedSongRecord&>(songRecord(LibrarySection::HISTORY, index)).playedAtMicros;
+    return true;
+}
+
+const ActionRecord& LibraryView::actionRecord(size_t index) const {
+    return reinterpret_cast<const ActionRecord&>(songRecord(LibrarySection::UNDO_LOG, index));
+}
+
+std::string_view LibraryView::heapString(LibrarySection section, uint32_t offset, uint32_t length) const {
+    const LibrarySectionEntry& entry = header->sections[static_cast<size_t>(section)];
+    uint64_t heapStart = entry.recordCount * entry.recordSize;
+    uint64_t heapSize = entry.size - heapStart;
+    if (static_cast<uint64_t>(offset) + length > heapSize) {
+        return std::string_view(); // corrupt reference; never read past the section
+    }
+    return std::string_view(sectionBase(section) + heapStart + offset, length);
+}
+
+std::string_view LibraryView::title(LibrarySection section, const SongRecord& record) const {
+    return heapString(section, record.titleOffset, record.titleLength);
+}
+
+std::string_view LibraryView::artist(LibrarySection section, const SongRecord& record) const {
+    return heapString(section, record.artistOffset, record.artistLength);
+}
+
+Song LibraryView::toSong(LibrarySection section, const SongRecord& record) const {
+    Song song;
+    std::string_view titleView = title(section, record);
+    std::string_view artistView = artist(section, record);
+    song.title.assign(titleView.data(), titleView.size());
+    song.artist.assign(artistView.data(), artistView.size());
+    song.duration = record.duration;
+    song.id = record.id;
+    song.addedTime = fromEpochMicros(record.addedTimeMicros);
+    return song;
+}
+
+const char* LibraryView::sectionData(LibrarySection section) const {
+    return header ? sectionBase(section) : nullptr;
+}
+
+size_t LibraryView::sectionSize(LibrarySection section) const {
+    return header ? header->sections[static_cast<size_t>(section)].size : 0;
+}
+
+uint32_t LibraryView::recordSize(LibrarySection section) const {
+    return header ? header->sections[static_cast<size_t>(section)].recordSize : 0;
+}
+
+// ---------------------------------------------------------------------------
+// LibraryStore
+
+LibraryStore::LibraryStore() {
+}
+
+bool LibraryStore::isUnchanged(LibrarySection section, const void* source, unsigned long long version,
+                               const std::string& path) const {
+    const SectionState& state = sectionStates[static_cast<size_t>(section)];
+    return previous.isOpen() && path == previousPath && state.source == source && state.version == version;
+}
+
+void LibraryStore::remember(LibrarySection section, const void* source, unsigned long long version) {
+    SectionState& state = sectionStates[static_cast<size_t>(section)];
+    state.source = source;
+    state.version = version;
+}
+
+bool LibraryStore::save(const std::string& path, const PlaylistEngine& engine, const PlaybackHistory& history,
+                        const SongRatingTree& ratingTree, const SongLookup& lookup,
+                        unsigned long long walSequence) {
+    lastSaveStats = LibrarySaveStats();
+    
+    struct SectionSource {
+        const void* source;
+        unsigned long long version;
+        uint32_t recordSize;
+    };
+    const SectionSource sources[kSectionCount] = {
+        {&lookup, lookup.getVersion(), sizeof(SongRecord)},
+        {&engine, engine.getVersion(), sizeof(SongRecord)},
+        {&ratingTree, ratingTree.getVersion(), sizeof(RatedSongRecord)},
+        {&history, history.getVersion(), sizeof(PlayedSongRecord)},
+        {&engine, engine.getVersion(), sizeof(ActionRecord)},
+    };
+    
+    // Encode changed sections; unchanged ones are copied from the old file
+    std::string encoded[kSectionCount];
+    uint64_t recordCounts[kSectionCount] = {0, 0, 0, 0, 0};
+    bool reuse[kSectionCount];
+    
+    for (size_t i = 0; i < kSectionCount; i++) {
+        LibrarySection section = static_cast<LibrarySection>(i);
+        reuse[i] = isUnchanged(section, sources[i].source, sources[i].version, path);
+        if (reuse[i]) {
+            recordCounts[i] = previous.recordCount(section);
+            lastSaveStats.sectionsReused++;
+            continue;
+        }
+        
+        switch (section) {
+            case LibrarySection::CATALOG: {
+                std::vector<Song> songs = lookup.getAllSongs();
+                SectionWriter<SongRecord> writer(songs.size());
+                for (const auto& song : songs) writer.add(song);
+                encoded[i] = writer.finish();
+                recordCounts[i] = writer.count();
+                break;
+            }
+            case LibrarySection::PLAYLIST: {
+                std::vector<Song> songs = engine.getSongs();
+                SectionWriter<SongRecord> writer(songs.size());
+                for (const auto& song : songs) writer.add(song);
+                encoded[i] = writer.finish();
+                recordCounts[i] = writer.count();
+                break;
+            }
+            case LibrarySection::RATINGS: {
+                SectionWriter<RatedSongRecord> writer(0);
+                for (const auto& bucket : ratingTree.getAllRatings()) {
+                    for (const auto& song : bucket.second) {
+                        writer.add(song).rating = bucket.first;
+                    }
+                }
+                encoded[i] = writer.finish();
+                recordCounts[i] = writer.count();
+                break;
+            }
+            case LibrarySection::HISTORY: {
+                const std::vector<Song>& played = history.getAllPlayed();
+                SectionWriter<PlayedSongRecord> writer(played.size());
+                for (size_t index = 0; index < played.size(); index++) {
+                    // Compacted plays are saved with their segment's start time
+                    std::chrono::system_clock::time_point playedAt;
+                    history.getPlayTime(index, playedAt);
+                    writer.add(played[index]).playedAtMicros = toEpochMicros(playedAt);
+                }
+                encoded[i] = writer.finish();
+                recordCounts[i] = writer.count();
+                break;
+            }
+            case LibrarySection::UNDO_LOG: {
+                std::vector<PlaylistAction> actions = engine.getUndoLog();
+                SectionWriter<ActionRecord> writer(actions.size());
+                for (const auto& action : actions) {
+                    ActionRecord& record = writer.add(action.song);
+                    record.type = static_cast<int32_t>(action.type);
+                    record.index1 = action.index1;
+                    record.index2 = action.index2;
+                }
+                encoded[i] = writer.finish();
+                recordCounts[i] = writer.count();
+                break;
+            }
+            case LibrarySection::COUNT:
+                break;
+        }
+        lastSaveStats.sectionsWritten++;
+    }
+    
+    // Lay out the header and sections
+    LibraryFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.byteOrder = kByteOrderMark;
+    header.sectionCount = kSectionCount;
+    header.walSequence = walSequence;
+    
+    uint64_t offset = alignUp(sizeof(LibraryFileHeader));
+    for (size_t i = 0; i < kSectionCount; i++) {
+        LibrarySection section = static_cast<LibrarySection>(i);
+        LibrarySectionEntry& entry = header.sections[i];
+        entry.type = static_cast<uint32_t>(i);
+        entry.recordSize = reuse[i] ? previous.recordSize(section) : sources[i].recordSize;
+        entry.recordCount = recordCounts[i];
+        entry.offset = offset;
+        entry.size = reuse[i] ? previous.sectionSize(section) : encoded[i].size();
+        offset = alignUp(offset + entry.size);
+    }
+    
+    // Write everything to a temporary file, then atomically replace the old one
+    std::string tempPath = path + ".tmp";
+    FILE* file = std::fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        lastError = "Could not create " + tempPath;
+        return false;
+    }
+    
+    static const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    bool ok = writeAll(file, reinterpret_cast<const char*>(&header), sizeof(header));
+    uint64_t written = sizeof(header);
+    for (size_t i = 0; ok && i < kSectionCount; i++) {
+        LibrarySection section = static_cast<LibrarySection>(i);
+        ok = writeAll(file, padding, header.sections[i].offset - written);
+        const char* data = reuse[i] ? previous.sectionData(section) : encoded[i].data();
+        ok = ok && writeAll(file, data, header.sections[i].size);
+        written = header.sections[i].offset + header.sections[i].size;
+    }
+    ok = ok && flushToDisk(file);
+    ok = (std::fclose(file) == 0) && ok;
+    
+    if (!ok) {
+        std::remove(tempPath.c_str());
+        lastError = "Could not write " + tempPath;
+        return false;
+    }
+    
+    // The old mapping must be released before the file can be replaced on Windows
+    previous.close();
+    if (!replaceFile(tempPath, path)) {
+        std::remove(tempPath.c_str());
+        lastError = "Could not replace " + path;
+        return false;
+    }
+    
+    lastSaveStats.bytesWritten = written;
+    previousPath = path;
+    if (previous.open(path)) {
+        for (size_t i = 0; i < kSectionCount; i++) {
+            remember(static_cast<LibrarySection>(i), sources[i].source, sources[i].version);
+        }
+    }
+    return true;
+}
+
+bool LibraryStore::load(const std::string& path, PlaylistEngine& engine, PlaybackHistory& history,
+                        SongRatingTree& ratingTree, SongLookup& lookup) {
+    if (!previous.open(path)) {
+        lastError = "Could not open library " + path + " (missing, corrupt or wrong version)";
+        return false;
+    }
+    previousPath = path;
+    int maxId = 0;
+    
+    std::vector<Song> songs;
+    auto readSongs = [&](LibrarySection section) {
+        songs.clear();
+        songs.reserve(previous.recordCount(section));
+        for (size_t i = 0; i < previous.recordCount(section); i++) {
+            songs.push_back(previous.toSong(section, previous.songRecord(section, i)));
+            maxId = std::max(maxId, songs.back().id);
+        }
+    };
+    
+    readSongs(LibrarySection::CATALOG);
+    lookup.addSongs(songs);
+    
+    readSongs(LibrarySection::PLAYLIST);
+    engine.addSongs(songs);
+    
+    std::vector<std::pair<Song, int>> ratedSongs;
+    ratedSongs.reserve(previous.recordCount(LibrarySection::RATINGS));
+    for (size_t i = 0; i < previous.recordCount(LibrarySection::RATINGS); i++) {
+        const RatedSongRecord& record = previous.ratedSongRecord(i);
+        ratedSongs.emplace_back(previous.toSong(LibrarySection::RATINGS, record.song), record.rating);
+        maxId = std::max(maxId, record.song.id);
+    }
+    ratingTree.insertSongs(ratedSongs);
+    
+    readSongs(LibrarySection::HISTORY);
+    for (size_t i = 0; i < songs.size(); i++) {
+        int64_t playedAtMicros = 0;
+        if (previous.playedAt(i, playedAtMicros)) {
+            history.addPlayedSong(songs[i], fromEpochMicros(playedAtMicros));
+        } else {
+            history.addPlayedSong(songs[i]);
+        }
+    }
+    
+    // Undo entries replay against each other, so one with an unknown action
+    // type makes the whole log unusable; it is dropped and the load goes on
+    std::vector<PlaylistAction> actions;
+    bool undoLogValid = true;
+    actions.reserve(previous.recordCount(LibrarySection::UNDO_LOG));
+    for (size_t i = 0; i < previous.recordCount(LibrarySection::UNDO_LOG); i++) {
+        const ActionRecord& record = previous.actionRecord(i);
+        if (record.type < static_cast<int32_t>(ActionType::ADD) ||
+            record.type > static_cast<int32_t>(ActionType::MOVE)) {
+            actions.clear();
+            undoLogValid = false;
+            lastError = "Dropped the corrupt undo log in " + path;
+            break;
+        }
+        actions.emplace_back(static_cast<ActionType>(record.type),
+                             previous.toSong(LibrarySection::UNDO_LOG, record.song),
+                             record.index1, record.index2);
+        maxId = std::max(maxId, record.song.id);
+    }
+    engine.restoreUndoLog(actions);
+    
+    Song::reserveIdsThrough(maxId);
+    
+    // The engines now match the file, so an immediate save can reuse every
+    // section (except a dropped undo log, which must be rewritten)
+    remember(LibrarySection::CATALOG, &lookup, lookup.getVersion());
+    remember(LibrarySection::PLAYLIST, &engine, engine.getVersion());
+    remember(LibrarySection::RATINGS, &ratingTree, ratingTree.getVersion());
+    remember(LibrarySection::HISTORY, &history, history.getVersion());
+    remember(LibrarySection::UNDO_LOG, undoLogValid ? &engine : nullptr, engine.getVersion());
+    return true;
+}
@@ -0,0 +1,177 @@
+#ifndef LIBRARY_STORE_H
+#define LIBRARY_STORE_H
+
+#include "song.h"
+#include "playlist_engine.h"
+#include "playback_history.h"
+#include "song_rating_tree.h"
+#include "song_lookup.h"
+#include "mapped_file.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Default location of the saved library, relative to the working directory
+extern const char* const kDefaultLibraryPath;
+
+// Sections of a library file, in file order
+enum class LibrarySection : uint32_t {
+    CATALOG = 0,
+    PLAYLIST,
+    RATINGS,
+    HISTORY,
+    UNDO_LOG,
+    COUNT
+};
+
+// On-disk records. All fields are fixed width and stored in native byte
+// order (the header records which); strings live in a heap that follows
+// each section's records, addressed by section-relative offsets.
+struct SongRecord {
+    int32_t id;
+    int32_t duration;
+    int64_t addedTimeMicros;   // microseconds since the Unix epoch
+    uint32_t titleOffset;
+    uint32_t titleLength;
+    uint32_t artistOffset;
+    uint32_t artistLength;
+};
+
+// History records. Files written before play times were kept have plain
+// SongRecords in the history section (see its recordSize).
+struct PlayedSongRecord {
+    SongRecord song;
+    int64_t playedAtMicros;    // microseconds since the Unix epoch
+};
+
+struct RatedSongRecord {
+    SongRecord song;
+    int32_t rating;
+    int32_t reserved;
+};
+
+struct ActionRecord {
+    SongRecord song;
+    int32_t type;              // ActionType
+    int32_t index1;
+    int32_t index2;
+    int32_t reserved;
+};
+
+struct LibrarySectionEntry {
+    uint32_t type;
+    uint32_t recordSize;
+    uint64_t recordCount;
+    uint64_t offset;           // from the start of the file, 8-byte aligned
+    uint64_t size;             // records plus string heap
+};
+
+struct LibraryFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t sectionCount;
+    uint32_t reserved;
+    LibrarySectionEntry sections[static_cast<size_t>(LibrarySection::COUNT)];
+    uint64_t walSequence;      // version 2+: last write-ahead log record included
+};
+
+// Zero-copy, read-only view of a library file. Opening only validates the
+// header; songs are decoded on access straight from the mapping, so a large
+// library is usable immediately at startup.
+class LibraryView {
+private:
+    MappedFile file;
+    const LibraryFileHeader* header;
+    
+    const char* sectionBase(LibrarySection section) const;
+    std::string_view heapString(LibrarySection section, uint32_t offset, uint32_t length) const;
+    
+public:
+    // Constructor
+    LibraryView();
+    
+    // Core operations
+    bool open(const std::string& path);
+    void close();
+    
+    // Section access
+    size_t recordCount(LibrarySection section) const;
+    const SongRecord& songRecord(LibrarySection section, size_t index) const;
+    const RatedSongRecord& ratedSongRecord(size_t index) const;
+    bool playedAt(size_t index, int64_t& playedAtMicros) const;  // false for files without play times
+    const ActionRecord& actionRecord(size_t index) const;
+    std::string_view title(LibrarySection section, const SongRecord& record) const;
+    std::string_view artist(LibrarySection section, const SongRecord& record) const;
+    Song toSong(LibrarySection section, const SongRecord& record) const;
+    
+    // Raw bytes of a whole section, used to carry unchanged sections forward
+    const char* sectionData(LibrarySection section) const;
+    size_t sectionSize(LibrarySection section) const;
+    uint32_t recordSize(LibrarySection section) const;
+    
+    // Utility methods
+    bool isOpen() const { return header != nullptr; }
+    uint64_t walSequence() const;
+    
+    // Time complexity annotations:
+    // open: O(1) - maps the file and validates the header
+    // recordCount / songRecord / title / artist: O(1) - pointer arithmetic
+    // toSong: O(L) - copies the two strings
+};
+
+// Statistics for the most recent save
+struct LibrarySaveStats {
+    int sectionsWritten = 0;   // re-encoded from the engines
+    int sectionsReused = 0;    // copied verbatim from the previous file
+    size_t bytesWritten = 0;
+};
+
+// Saves and restores the whole engine state (catalog, playlist order,
+// ratings, history and undo log) as a versioned binary file.
+//
+// Saves are atomic: the file is written to "<path>.tmp", flushed to disk and
+// renamed over the old one. Sections whose engine has not changed since the
+// last save or load (per the engines' version counters) are copied from the
+// previous file instead of being re-encoded.
+class LibraryStore {
+private:
+    struct SectionState {
+        const void* source = nullptr;
+        unsigned long long version = 0;
+    };
+    
+    LibraryView previous;
+    std::string previousPath;
+    SectionState sectionStates[static_cast<size_t>(LibrarySection::COUNT)];
+    std::string lastError;
+    LibrarySaveStats lastSaveStats;
+    
+    // Helper methods
+    bool isUnchanged(LibrarySection section, const void* source, unsigned long long version,
+                     const std::string& path) const;
+    void remember(LibrarySection section, const void* source, unsigned long long version);
+    
+public:
+    // Constructor
+    LibraryStore();
+    
+    // Core operations
+    bool save(const std::string& path, const PlaylistEngine& engine, const PlaybackHistory& history,
+              const SongRatingTree& ratingTree, const SongLookup& lookup,
+              unsigned long long walSequence = 0);
+    bool load(const std::string& path, PlaylistEngine& engine, PlaybackHistory& history,
+              SongRatingTree& ratingTree, SongLookup& lookup);
+    
+    // Utility methods
+    const std::string& getLastError() const { return lastError; }
+    const LibrarySaveStats& getLastSaveStats() const { return lastSaveStats; }
+    unsigned long long getWalSequence() const { return previous.walSequence(); }
+    
+    // Time complexity annotations:
+    // save: O(changed) encoding plus O(file) sequential I/O for the atomic rewrite
+    // load: O(n) - materializes every song into the engines
+};
+
+#endif // LIBRARY_STORE_H
@@ -0,0 +1,69 @@
+#include "listening_sessions.h"
+#include "song.h"
+#include <algorithm>
+
+ListeningSessions::ListeningSessions(long long idleGapSeconds)
+    : idleGapMicros(std::max(idleGapSeconds, 0LL) * 1000000) {}
+
+void ListeningSessions::recordPlay(long long playedMicros, int durationSeconds) {
+    long long endMicros = playedMicros + static_cast<long long>(durationSeconds) * 1000000;
+    if (sessions.empty() || playedMicros - sessions.back().endMicros > idleGapMicros) {
+        ListeningSession session;
+        session.firstPlay = playCount;
+        session.startMicros = playedMicros;
+        sessions.push_back(session);
+    }
+    ListeningSession& session = sessions.back();
+    session.plays++;
+    session.endMicros = endMicros;
+    session.listenedSeconds += durationSeconds;
+    playCount++;
+}
+
+bool ListeningSessions::removeLast(int durationSeconds, long long previousEndMicros) {
+    if (sessions.empty()) return false;
+    
+    ListeningSession& session = sessions.back();
+    session.plays--;
+    session.listenedSeconds -= durationSeconds;
+    session.endMicros = previousEndMicros;
+    playCount--;
+    if (session.plays == 0) sessions.pop_back();
+    return true;
+}
+
+void ListeningSessions::clear() {
+    sessions.clear();
+    playCount = 0;
+}
+
+std::vector<ListeningSession> ListeningSessions::getRecent(size_t count) const {
+    count = std::min(count, sessions.size());
+    return std::vector<ListeningSession>(sessions.rbegin(), sessions.rbegin() + count);
+}
+
+std::vector<ListeningSession> ListeningSessions::sessionsBetween(std::chrono::system_clock::time_point from,
+                                                                 std::chrono::system_clock::time_point to) const {
+    long long fromMicros = toEpochMicros(from);
+    long long toMicros = toEpochMicros(to);
+    // Each session ends before the next one starts, so of the sessions
+    // starting at or before from only the last can reach into the range
+    auto it = std::upper_bound(sessions.begin(), sessions.end(), fromMicros,
+                               [](long long time, const ListeningSession& session) {
+                                   return time < session.startMicros;
+                               });
+    if (it != sessions.begin()) --it;
+    
+    std::vector<ListeningSession> result;
+    for (; it != sessions.end() && it->startMicros < toMicros; ++it) {
+        if (it->endMicros > fromMicros) result.push_back(*it);
+    }
+    return result;
+}
+
+MemoryUsage ListeningSessions::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.items = sessions.size();
+    usage.structureBytes = sessions.capacity() * sizeof(ListeningSession);
+    return usage;
+}
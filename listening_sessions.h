@@ -0,0 +1,58 @@
+#ifndef LISTENING_SESSIONS_H
+#define LISTENING_SESSIONS_H
+
+#include "memory_usage.h"
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+// A run of plays with no idle gap longer than the session gap
+struct ListeningSession {
+    size_t firstPlay = 0;  // index of its first play in the history
+    size_t plays = 0;
+    long long startMicros = 0;  // first play started
+    long long endMicros = 0;    // last play started plus its duration
+    long long listenedSeconds = 0;
+};
+
+// Splits the plays into sessions as they arrive.
+//
+// A play opens a new session when it starts more than idleGapSeconds after
+// the previous play ended (start plus duration). A play that starts before
+// the previous one ended (a skip) continues the session and becomes its
+// end. Plays must be recorded in history order; removeLast() takes back
+// the newest one and needs the end of the play before it.
+class ListeningSessions {
+public:
+    static constexpr long long kDefaultIdleGapSeconds = 30 * 60;
+
+private:
+    long long idleGapMicros;
+    size_t playCount = 0;
+    std::vector<ListeningSession> sessions;  // oldest first
+
+public:
+    // Constructor
+    explicit ListeningSessions(long long idleGapSeconds = kDefaultIdleGapSeconds);
+    
+    // Core operations
+    void recordPlay(long long playedMicros, int durationSeconds);
+    bool removeLast(int durationSeconds, long long previousEndMicros);
+    void clear();
+    
+    // Queries
+    const std::vector<ListeningSession>& getSessions() const { return sessions; }
+    std::vector<ListeningSession> getRecent(size_t count) const;  // newest first
+    std::vector<ListeningSession> sessionsBetween(std::chrono::system_clock::time_point from,
+                                                  std::chrono::system_clock::time_point to) const;  // overlapping [from, to)
+    long long getIdleGapSeconds() const { return idleGapMicros / 1000000; }
+    size_t size() const { return sessions.size(); }
+    MemoryUsage getMemoryUsage() const;
+    
+    // Time complexity annotations:
+    // recordPlay / removeLast: O(1) amortized
+    // getRecent: O(k) - k sessions copied
+    // sessionsBetween: O(log s + k) - binary search on session ends, then k overlapping sessions
+};
+
+#endif // LISTENING_SESSIONS_H
@@ -2,12 +2,22 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <thread>
+#include <cstdlib>
+#include <sstream>
+#include <algorithm>
+#include <chrono>
+#include "library.h"
 #include "playlist_engine.h"
 #include "playback_history.h"
 #include "song_rating_tree.h"
 #include "song_lookup.h"
 #include "playlist_sorter.h"
 #include "system_snapshot.h"
+#include "catalog_importer.h"
+#include "library_store.h"
+#include "write_ahead_log.h"
+#include "metrics_registry.h"
 
 using namespace std;
 
@@ -25,14 +35,18 @@ void displayMenu() {
     cout << "Enter your choice: ";
 }
 
-void playlistMenu(PlaylistEngine& engine) {
+void playlistMenu(Library& library) {
+    PlaylistEngine& engine = library.playlist();
     cout << "\n=== Playlist Management ===\n";
     cout << "1. Add Song\n";
     cout << "2. Delete Song\n";
     cout << "3. Move Song\n";
     cout << "4. Reverse Playlist\n";
     cout << "5. Display Playlist\n";
-    cout << "6. Back to Main Menu\n";
+    cout << "6. Play Song\n";
+    cout << "7. Play Next Song\n";
+    cout << "8. Play Previous Song\n";
+    cout << "9. Back to Main Menu\n";
     cout << "Enter your choice: ";
     
     int choice;
@@ -49,7 +63,7 @@ void playlistMenu(PlaylistEngine& engine) {
             getline(cin, artist);
             cout << "Enter duration (seconds): ";
             cin >> duration;
-            engine.addSong(title, artist, duration);
+            library.addSong(Song(title, artist, duration));
             cout << "Song added successfully!\n";
             break;
         }
@@ -57,8 +71,11 @@ void playlistMenu(PlaylistEngine& engine) {
             int index;
             cout << "Enter song index to delete: ";
             cin >> index;
-            engine.deleteSong(index);
-            cout << "Song deleted successfully!\n";
+            if (library.removeSongAt(index)) {
+                cout << "Song deleted successfully!\n";
+            } else {
+                cout << "Invalid index for deletion!\n";
+            }
             break;
         }
         case 3: {
@@ -78,15 +95,43 @@ void playlistMenu(PlaylistEngine& engine) {
         case 5:
             engine.displayPlaylist();
             break;
+        case 6:
+        case 7:
+        case 8: {
+            const Song* song = nullptr;
+            if (choice == 6) {
+                int index;
+                cout << "Enter song index to play: ";
+                cin >> index;
+                song = engine.startPlayback(index);
+            } else {
+                song = choice == 7 ? engine.playNext() : engine.playPrevious();
+            }
+            if (!song) {
+                cout << (choice == 6 ? "Invalid song index!\n" : "No song there to play!\n");
+                break;
+            }
+            library.history().addPlayedSong(*song);
+            cout << "Now playing: " << song->title << " by " << song->artist << "\n";
+            vector<Song> upNext = engine.getUpNext();
+            for (size_t i = 0; i < upNext.size(); i++) {
+                cout << (i == 0 ? "Up next: " : "         ") << upNext[i].title << " by " << upNext[i].artist << "\n";
+            }
+            break;
+        }
     }
 }
 
-void historyMenu(PlaybackHistory& history, PlaylistEngine& engine) {
+void historyMenu(Library& library) {
+    PlaybackHistory& history = library.history();
     cout << "\n=== Playback History ===\n";
     cout << "1. Add played song\n";
     cout << "2. Undo last play\n";
     cout << "3. Display history\n";
-    cout << "4. Back to Main Menu\n";
+    cout << "4. Plays in the last N hours\n";
+    cout << "5. Recent listening sessions\n";
+    cout << "6. Compact plays older than N days\n";
+    cout << "7. Back to Main Menu\n";
     cout << "Enter your choice: ";
     
     int choice;
@@ -111,7 +156,7 @@ void historyMenu(PlaybackHistory& history, PlaylistEngine& engine) {
         case 2: {
             Song lastSong = history.undoLastPlay();
             if (lastSong.title != "") {
-                engine.addSong(lastSong.title, lastSong.artist, lastSong.duration);
+                library.addSong(Song(lastSong.title, lastSong.artist, lastSong.duration));
                 cout << "Last played song re-added to playlist!\n";
             } else {
                 cout << "No songs in history to undo!\n";
@@ -121,16 +166,62 @@ void historyMenu(PlaybackHistory& history, PlaylistEngine& engine) {
         case 3:
             history.displayHistory();
             break;
+        case 4: {
+            int hours;
+            cout << "Enter hours: ";
+            cin >> hours;
+            auto now = chrono::system_clock::now();
+            auto from = now - chrono::hours(max(hours, 0));
+            PlaySummary summary = history.summarizePlaysBetween(from, now + chrono::seconds(1));
+            cout << summary.plays << " plays, " << summary.listenedSeconds / 60 << " min listened"
+                 << (summary.exact ? "" : " (includes compacted plays around the start)") << "\n";
+            for (const auto& play : history.getPlaysBetween(from, now + chrono::seconds(1))) {
+                auto minutesAgo = chrono::duration_cast<chrono::minutes>(now - play.first).count();
+                cout << "- " << play.second.title << " by " << play.second.artist << " (" << minutesAgo
+                     << " min ago)\n";
+            }
+            break;
+        }
+        case 5: {
+            auto sessions = history.getRecentSessions(5);
+            if (sessions.empty()) {
+                cout << "No listening sessions yet.\n";
+                break;
+            }
+            auto now = chrono::system_clock::now();
+            cout << "Sessions (a gap of over " << history.listeningSessions().getIdleGapSeconds() / 60
+                 << " min starts a new one), newest first:\n";
+            for (const auto& session : sessions) {
+                auto startedAgo = chrono::duration_cast<chrono::minutes>(now - fromEpochMicros(session.startMicros)).count();
+                long long lengthMinutes = (session.endMicros - session.startMicros) / 60000000;
+                cout << "- started " << startedAgo << " min ago, " << lengthMinutes << " min long, "
+                     << session.plays << " plays\n";
+            }
+            break;
+        }
+        case 6: {
+            // Only full segments are folded; their plays then show up in totals only
+            int days;
+            cout << "Enter days: ";
+            cin >> days;
+            auto cutoff = chrono::system_clock::now() - chrono::hours(24 * max(days, 0));
+            size_t folded = history.compactPlaysBefore(cutoff);
+            cout << folded << " plays compacted (" << history.playLog().getCompactedPlays() << " in total)\n";
+            break;
+        }
     }
 }
 
-void ratingMenu(SongRatingTree& ratingTree) {
+void ratingMenu(Library& library) {
+    SongRatingTree& ratingTree = library.ratings();
     cout << "\n=== Song Rating Management ===\n";
     cout << "1. Add song with rating\n";
     cout << "2. Search songs by rating\n";
     cout << "3. Delete song\n";
     cout << "4. Display all ratings\n";
-    cout << "5. Back to Main Menu\n";
+    cout << "5. Rate song by ID as user (0.5-5.0)\n";
+    cout << "6. Find songs by average rating\n";
+    cout << "7. Back to Main Menu\n";
     cout << "Enter your choice: ";
     
     int choice;
@@ -149,8 +240,7 @@ void ratingMenu(SongRatingTree& ratingTree) {
             cin >> duration;
             cout << "Enter rating (1-5): ";
             cin >> rating;
-            Song song(title, artist, duration);
-            ratingTree.insertSong(song, rating);
+            library.addSong(Song(title, artist, duration), rating);
             cout << "Song added with rating!\n";
             break;
         }
@@ -170,23 +260,66 @@ void ratingMenu(SongRatingTree& ratingTree) {
             cout << "Enter song title to delete: ";
             cin.ignore();
             getline(cin, title);
-            ratingTree.deleteSong(title);
+            Song* song = library.lookup().searchByTitle(title);
+            if (song) {
+                ratingTree.deleteSongById(song->id);
+            } else {
+                ratingTree.deleteSong(title);
+            }
             cout << "Song deleted from ratings!\n";
             break;
         }
         case 4:
             ratingTree.displayAllRatings();
             break;
+        case 5: {
+            int userId, songId;
+            double rating;
+            cout << "Enter user ID: ";
+            cin >> userId;
+            cout << "Enter song ID: ";
+            cin >> songId;
+            cout << "Enter rating (0.5-5.0): ";
+            cin >> rating;
+            if (library.rateSongAsUser(userId, songId, rating)) {
+                RatingAggregate aggregate = library.userRatings().getAggregate(songId);
+                cout << "Rated! Average is now " << aggregate.average() << " from " << aggregate.count << " ratings\n";
+                size_t rank;
+                double percentile;
+                if (library.userRatings().getRank(songId, rank) && library.userRatings().getPercentile(songId, percentile)) {
+                    cout << "Rank " << rank + 1 << " of " << library.userRatings().getRatedSongCount()
+                         << " (ahead of " << static_cast<int>(percentile * 100) << "% of rated songs)\n";
+                }
+            } else {
+                cout << "Unknown song or rating out of range!\n";
+            }
+            break;
+        }
+        case 6: {
+            double minAverage;
+            cout << "Enter minimum average rating: ";
+            cin >> minAverage;
+            const RatingStore& store = library.userRatings();
+            for (int songId : store.songsWithAverageAtLeast(minAverage)) {
+                Song* song = library.lookup().searchById(songId);
+                RatingAggregate aggregate = store.getAggregate(songId);
+                cout << "- " << (song ? song->title : "#" + to_string(songId)) << " (avg "
+                     << aggregate.average() << " from " << aggregate.count << " ratings)\n";
+            }
+            break;
+        }
     }
 }
 
-void lookupMenu(SongLookup& lookup) {
+void lookupMenu(Library& library) {
+    SongLookup& lookup = library.lookup();
     cout << "\n=== Song Lookup ===\n";
-    cout << "1. Add song to lookup\n";
+    cout << "1. Add song to library\n";
     cout << "2. Search by title\n";
     cout << "3. Search by ID\n";
     cout << "4. Display all songs\n";
-    cout << "5. Back to Main Menu\n";
+    cout << "5. Filter songs\n";
+    cout << "6. Back to Main Menu\n";
     cout << "Enter your choice: ";
     
     int choice;
@@ -203,9 +336,8 @@ void lookupMenu(SongLookup& lookup) {
             getline(cin, artist);
             cout << "Enter duration (seconds): ";
             cin >> duration;
-            Song song(title, artist, duration);
-            lookup.addSong(song);
-            cout << "Song added to lookup!\n";
+            library.addSong(Song(title, artist, duration));
+            cout << "Song added to library!\n";
             break;
         }
         case 2: {
@@ -236,16 +368,41 @@ void lookupMenu(SongLookup& lookup) {
         case 4:
             lookup.displayAllSongs();
             break;
+        case 5: {
+            SongFilter filter;
+            string artists;
+            cout << "Minimum rating (0 = any): ";
+            cin >> filter.minRating;
+            cout << "Maximum duration in seconds (-1 = any): ";
+            cin >> filter.maxDuration;
+            cout << "Artists, comma separated (empty = any): ";
+            cin.ignore();
+            getline(cin, artists);
+            stringstream artistList(artists);
+            string artist;
+            while (getline(artistList, artist, ',')) {
+                if (!artist.empty()) filter.artists.push_back(artist);
+            }
+            cout << "Exclude songs played in the last N hours (0 = none): ";
+            cin >> filter.notPlayedWithinHours;
+            
+            cout << library.countSongs(filter) << " matching songs\n";
+            for (const auto& song : library.findSongs(filter, 20)) {
+                cout << "- " << song.title << " by " << song.artist << " (" << song.duration << "s)\n";
+            }
+            break;
+        }
     }
 }
 
-void sortMenu(PlaylistSorter& sorter, PlaylistEngine& engine) {
+void sortMenu(PlaylistSorter& sorter, PlaylistEngine& engine, SongRatingTree& ratingTree) {
     cout << "\n=== Playlist Sorting ===\n";
     cout << "1. Sort by title (alphabetical)\n";
     cout << "2. Sort by duration (ascending)\n";
     cout << "3. Sort by duration (descending)\n";
     cout << "4. Sort by recently added\n";
-    cout << "5. Back to Main Menu\n";
+    cout << "5. Sort by artist, then rating, then title\n";
+    cout << "6. Back to Main Menu\n";
     cout << "Enter your choice: ";
     
     int choice;
@@ -267,9 +424,17 @@ void sortMenu(PlaylistSorter& sorter, PlaylistEngine& engine) {
         case 4:
             sortedSongs = sorter.sortByRecentlyAdded(songs);
             break;
+        case 5:
+            sorter.setRatings(ratingTree);
+            sortedSongs = sorter.sortByArtistThenRating(songs);
+            break;
     }
     
-    if (choice >= 1 && choice <= 4) {
+    if (choice >= 1 && choice <= 5) {
+        const SortMetrics& metrics = sorter.getLastSortMetrics();
+        cout << "Sorted " << metrics.songCount << " songs in " << metrics.totalMicroseconds()
+             << " microseconds (keys " << metrics.packMicroseconds << ", sort " << metrics.sortMicroseconds
+             << ", copy " << metrics.copyMicroseconds << "; " << metrics.comparisons << " comparisons)\n";
         cout << "Sorted playlist:\n";
         for (size_t i = 0; i < sortedSongs.size(); i++) {
             cout << i + 1 << ". " << sortedSongs[i].title << " by " << sortedSongs[i].artist 
@@ -278,12 +443,12 @@ void sortMenu(PlaylistSorter& sorter, PlaylistEngine& engine) {
     }
 }
 
-void undoMenu(PlaylistEngine& engine) {
+void undoMenu(Library& library) {
     cout << "\n=== Undo Last N Edits ===\n";
     int n;
     cout << "Enter number of edits to undo: ";
     cin >> n;
-    engine.undoLastNEdits(n);
+    library.undoLastNEdits(n);
     cout << "Undid last " << n << " edits!\n";
 }
 
@@ -294,53 +459,91 @@ void shuffleMenu(PlaylistEngine& engine) {
     engine.displayPlaylist();
 }
 
-int main() {
-    PlaylistEngine engine;
-    PlaybackHistory history;
-    SongRatingTree ratingTree;
-    SongLookup lookup;
+int main(int argc, char* argv[]) {
+    Library library;
+    PlaylistEngine& engine = library.playlist();
+    PlaybackHistory& history = library.history();
+    SongRatingTree& ratingTree = library.ratings();
+    SongLookup& lookup = library.lookup();
     PlaylistSorter sorter;
+    sorter.setThreadCount(0);  // large playlists use every core
     SystemSnapshot snapshot;
+    LibraryStore store;
+    
+    // PLAYWISE_METRICS=1 turns on per-operation counters and latency histograms
+    const char* metricsSetting = getenv("PLAYWISE_METRICS");
+    MetricsRegistry::setEnabled(metricsSetting && string(metricsSetting) != "0");
     
-    // Add some sample data
-    engine.addSong("Bohemian Rhapsody", "Queen", 354);
-    engine.addSong("Hotel California", "Eagles", 391);
-    engine.addSong("Stairway to Heaven", "Led Zeppelin", 482);
-    engine.addSong("Imagine", "John Lennon", 183);
-    engine.addSong("Hey Jude", "The Beatles", 431);
+    // Restore the saved library, or start from sample data on first run
+    if (store.load(kDefaultLibraryPath, engine, history, ratingTree, lookup)) {
+        cout << "Loaded library from " << kDefaultLibraryPath << " (" << engine.getSize() << " songs)\n";
+    } else {
+        library.addSong(Song("Bohemian Rhapsody", "Queen", 354), 5);
+        library.addSong(Song("Hotel California", "Eagles", 391), 4);
+        library.addSong(Song("Stairway to Heaven", "Led Zeppelin", 482), 5);
+        library.addSong(Song("Imagine", "John Lennon", 183));
+        library.addSong(Song("Hey Jude", "The Beatles", 431));
+    }
     
-    lookup.addSong(Song("Bohemian Rhapsody", "Queen", 354));
-    lookup.addSong(Song("Hotel California", "Eagles", 391));
-    lookup.addSong(Song("Stairway to Heaven", "Led Zeppelin", 482));
+    // Re-apply edits made after the last save (e.g. before a crash), then log new ones
+    WalReplayResult replayed = WriteAheadLog::replay(kDefaultLogPath, store.getWalSequence(),
+                                                     engine, history, ratingTree);
+    if (replayed.recordsApplied > 0) {
+        cout << "Recovered " << replayed.recordsApplied << " edits from " << kDefaultLogPath << "\n";
+    }
     
-    ratingTree.insertSong(Song("Bohemian Rhapsody", "Queen", 354), 5);
-    ratingTree.insertSong(Song("Hotel California", "Eagles", 391), 4);
-    ratingTree.insertSong(Song("Stairway to Heaven", "Led Zeppelin", 482), 5);
+    WriteAheadLog wal;
+    if (wal.open(kDefaultLogPath, WalOptions(), replayed.lastSequence)) {
+        engine.setWriteAheadLog(&wal);
+        history.setWriteAheadLog(&wal);
+        ratingTree.setWriteAheadLog(&wal);
+    }
+    
+    // Optional catalog file (CSV/TSV: title, artist, duration, rating)
+    if (argc > 1) {
+        CatalogImporter importer;
+        ImportOptions options;
+        options.threadCount = thread::hardware_concurrency();
+        ImportResult result = importer.importFile(argv[1], &engine, &lookup, &ratingTree, options);
+        if (result.success) {
+            cout << "Imported " << result.rowsImported << " songs from " << argv[1]
+                 << " (" << result.rowsSkipped << " rows skipped) in "
+                 << (result.parseMicroseconds + result.loadMicroseconds) / 1000 << " ms\n";
+        } else {
+            cout << "Import failed: " << result.error << "\n";
+        }
+    }
+    library.rebuildIndexes();
     
     int choice;
+    bool walFailureReported = false;
     do {
+        if (wal.hasFailed() && !walFailureReported) {
+            cout << "Warning: the write-ahead log could not be written; changes are kept only until the next save\n";
+            walFailureReported = true;
+        }
         displayMenu();
         cin >> choice;
         
         switch(choice) {
             case 1:
-                playlistMenu(engine);
+                playlistMenu(library);
                 break;
             case 2:
-                historyMenu(history, engine);
+                historyMenu(library);
                 break;
             case 3:
-                ratingMenu(ratingTree);
+                ratingMenu(library);
                 break;
             case 4:
-                lookupMenu(lookup);
+                lookupMenu(library);
                 break;
             case 5:
-                sortMenu(sorter, engine);
+                sortMenu(sorter, engine, ratingTree);
                 break;
             case 6: {
                 cout << "\n=== System Snapshot ===\n";
-                auto stats = snapshot.exportSnapshot(engine, history, ratingTree, lookup);
+                auto stats = snapshot.exportSnapshot(library);
                 cout << "Top 5 longest songs:\n";
                 for (const auto& song : stats.topLongestSongs) {
                     cout << "- " << song.title << " (" << song.duration << "s)\n";
@@ -353,15 +556,54 @@ int main() {
                 for (const auto& pair : stats.songCountByRating) {
                     cout << "Rating " << pair.first << ": " << pair.second << " songs\n";
                 }
+                if (!stats.mostPlayedSongs.empty()) {
+                    cout << "\nMost played songs:\n";
+                    for (const auto& song : stats.mostPlayedSongs) {
+                        cout << "- " << song.first << " (" << song.second << " plays)\n";
+                    }
+                    cout << "Most played artists:\n";
+                    for (const auto& artist : stats.mostPlayedArtists) {
+                        cout << "- " << artist.first << " (" << artist.second << " plays)\n";
+                    }
+                    cout << "Top trending:\n";
+                    for (const auto& song : stats.topTrending) {
+                        cout << "- " << song.label << " (~" << song.count << " plays)\n";
+                    }
+                    cout << "Distinct songs in the last 24 hours: ~" << static_cast<long long>(stats.distinctSongsLastDay + 0.5)
+                         << ", distinct artists in the last 7 days: ~"
+                         << static_cast<long long>(stats.distinctArtistsLastWeek + 0.5) << "\n";
+                }
+                cout << "\nCatalog: " << stats.catalogDurations.count << " songs, "
+                     << stats.catalogDurations.totalSeconds / 60 << " min total, average "
+                     << static_cast<int>(stats.catalogDurations.average()) << "s\n";
+                cout << "Top artists:\n";
+                for (const auto& artist : stats.topArtists) {
+                    cout << "- " << artist.first << " (" << artist.second << " songs)\n";
+                }
+                cout << "\nMemory by component:\n";
+                for (const auto& component : stats.memoryByComponent) {
+                    cout << "- " << component.first << ": " << component.second.totalBytes() / 1024 << " KB ("
+                         << component.second.items << " items)\n";
+                }
+                cout << "Total: " << stats.totalMemoryBytes / 1024 << " KB\n";
+                if (MetricsRegistry::isEnabled()) {
+                    cout << "\nEngine metrics (Prometheus text format):\n";
+                    cout << MetricsRegistry::instance().toPrometheus();
+                }
                 break;
             }
             case 7:
-                undoMenu(engine);
+                undoMenu(library);
                 break;
             case 8:
                 shuffleMenu(engine);
                 break;
             case 9:
+                if (store.save(kDefaultLibraryPath, engine, history, ratingTree, lookup, wal.getLastSequence())) {
+                    wal.checkpoint();
+                } else {
+                    cout << "Could not save library: " << store.getLastError() << "\n";
+                }
                 cout << "Thank you for using PlayWise!\n";
                 break;
             default:
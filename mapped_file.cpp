@@ -0,0 +1,135 @@
+#include "mapped_file.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static const char emptyFile[1] = {0};
+
+#if defined(_WIN32)
+
+MappedFile::MappedFile()
+    : mappedData(nullptr), mappedSize(0), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr) {
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                             OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(fileHandle, &fileSize)) {
+        close();
+        return false;
+    }
+    
+    mappedSize = static_cast<size_t>(fileSize.QuadPart);
+    if (mappedSize == 0) {
+        mappedData = emptyFile;
+        return true;
+    }
+    
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mappingHandle) {
+        close();
+        return false;
+    }
+    
+    mappedData = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!mappedData) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (mappedData && mappedData != emptyFile) {
+        UnmapViewOfFile(mappedData);
+    }
+    if (mappingHandle) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle);
+    }
+    mappedData = nullptr;
+    mappedSize = 0;
+    mappingHandle = nullptr;
+    fileHandle = INVALID_HANDLE_VALUE;
+}
+
+bool MappedFile::isOpen() const {
+    return fileHandle != INVALID_HANDLE_VALUE;
+}
+
+#else
+
+MappedFile::MappedFile() : mappedData(nullptr), mappedSize(0), fileDescriptor(-1) {
+}
+
+bool MappedFile::open(const std::string& path) {
+    close();
+    
+    fileDescriptor = ::open(path.c_str(), O_RDONLY);
+    if (fileDescriptor < 0) {
+        return false;
+    }
+    
+    struct stat info;
+    if (fstat(fileDescriptor, &info) != 0) {
+        close();
+        return false;
+    }
+    
+    mappedSize = static_cast<size_t>(info.st_size);
+    if (mappedSize == 0) {
+        mappedData = emptyFile;
+        return true;
+    }
+    
+    void* address = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+    if (address == MAP_FAILED) {
+        close();
+        return false;
+    }
+    
+    // Files are read front to back; let the kernel read ahead aggressively
+    madvise(address, mappedSize, MADV_SEQUENTIAL);
+    mappedData = static_cast<const char*>(address);
+    return true;
+}
+
+void MappedFile::close() {
+    if (mappedData && mappedData != emptyFile) {
+        munmap(const_cast<char*>(mappedData), mappedSize);
+    }
+    if (fileDescriptor >= 0) {
+        ::close(fileDescriptor);
+    }
+    mappedData = nullptr;
+    mappedSize = 0;
+    fileDescriptor = -1;
+}
+
+bool MappedFile::isOpen() const {
+    return fileDescriptor >= 0;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
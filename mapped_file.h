@@ -0,0 +1,38 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. Falls back to an empty view for
+// zero-length files, which cannot be mapped on every platform.
+class MappedFile {
+private:
+    const char* mappedData;
+    size_t mappedSize;
+#if defined(_WIN32)
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+    
+public:
+    // Constructor and destructor
+    MappedFile();
+    ~MappedFile();
+    
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    // Core operations
+    bool open(const std::string& path);
+    void close();
+    
+    // Utility methods
+    bool isOpen() const;
+    const char* data() const { return mappedData; }
+    size_t size() const { return mappedSize; }
+};
+
+#endif // MAPPED_FILE_H
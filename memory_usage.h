@@ -0,0 +1,46 @@
+#ifndef MEMORY_USAGE_H
+#define MEMORY_USAGE_H
+
+#include "song.h"
+#include <cstddef>
+#include <string>
+
+// Heap footprint of one component, counted from its own containers.
+// Allocator bookkeeping and padding are not included.
+struct MemoryUsage {
+    size_t items = 0;           // songs or entries held
+    size_t structureBytes = 0;  // nodes, arrays and hash buckets
+    size_t stringBytes = 0;     // string payloads stored outside the string object
+
+    size_t totalBytes() const { return structureBytes + stringBytes; }
+
+    MemoryUsage& operator+=(const MemoryUsage& other) {
+        items += other.items;
+        structureBytes += other.structureBytes;
+        stringBytes += other.stringBytes;
+        return *this;
+    }
+};
+
+// Bytes a string allocated beyond its inline (small-string) buffer
+inline size_t stringHeapBytes(const std::string& text) {
+    static const size_t inlineCapacity = std::string().capacity();
+    return text.capacity() > inlineCapacity ? text.capacity() + 1 : 0;
+}
+
+inline size_t songHeapBytes(const Song& song) {
+    return stringHeapBytes(song.title) + stringHeapBytes(song.artist);
+}
+
+// Bucket array plus one node (next pointer, value, cached hash) per entry
+template <typename HashMap>
+size_t hashTableBytes(const HashMap& map) {
+    return map.bucket_count() * sizeof(void*) +
+           map.size() * (sizeof(void*) + sizeof(typename HashMap::value_type) + sizeof(size_t));
+}
+
+// Time complexity annotations:
+// stringHeapBytes / songHeapBytes: O(1)
+// hashTableBytes: O(1) - entry payloads are added by the caller
+
+#endif // MEMORY_USAGE_H
@@ -0,0 +1,274 @@
+#include "metrics_registry.h"
+#include <algorithm>
+#include <sstream>
+
+std::atomic<bool> MetricsRegistry::enabled(false);
+
+namespace {
+
+struct MetricName {
+    const char* component;
+    const char* operation;
+};
+
+const MetricName kMetricNames[] = {
+    {"playlist", "add"},
+    {"playlist", "delete"},
+    {"playlist", "move"},
+    {"playlist", "reverse"},
+    {"playlist", "shuffle"},
+    {"playlist", "undo"},
+    {"lookup", "add"},
+    {"lookup", "search"},
+    {"lookup", "delete"},
+    {"rating_tree", "insert"},
+    {"rating_tree", "search"},
+    {"rating_tree", "delete"},
+    {"history", "play"},
+    {"history", "undo"},
+    {"sorter", "sort"},
+    {"sorter", "top_k"},
+    {"sorter", "page"},
+    {"snapshot", "export"},
+};
+
+static_assert(sizeof(kMetricNames) / sizeof(kMetricNames[0]) == static_cast<size_t>(MetricId::COUNT),
+              "every MetricId needs a name");
+
+// Prometheus bucket bounds in nanoseconds: powers of four from ~1us to ~4s,
+// which are exact boundaries of the internal histogram
+const int kExportExponents[] = {10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30, 32};
+
+unsigned long long percentile(const std::vector<unsigned long long>& buckets, unsigned long long count,
+                              double fraction, unsigned long long (*upperBound)(int)) {
+    if (count == 0) return 0;
+    unsigned long long rank = static_cast<unsigned long long>(fraction * (count - 1)) + 1;
+    unsigned long long seen = 0;
+    for (size_t b = 0; b < buckets.size(); b++) {
+        seen += buckets[b];
+        if (seen >= rank) {
+            return upperBound(static_cast<int>(b));
+        }
+    }
+    return upperBound(static_cast<int>(buckets.size()) - 1);
+}
+
+} // namespace
+
+// Returns the calling thread's block to the registry when the thread exits
+struct ThreadBlockHolder {
+    MetricsRegistry::ThreadBlock* block = nullptr;
+
+    ~ThreadBlockHolder() {
+        if (block) MetricsRegistry::instance().releaseBlock(block);
+    }
+};
+
+namespace {
+thread_local ThreadBlockHolder threadBlock;
+}
+
+MetricsRegistry::ThreadBlock::ThreadBlock() : next(nullptr) {
+    for (int op = 0; op < kOperationCount; op++) {
+        counts[op].store(0, std::memory_order_relaxed);
+        totalNanos[op].store(0, std::memory_order_relaxed);
+        maxNanos[op].store(0, std::memory_order_relaxed);
+        for (int b = 0; b < kBucketCount; b++) {
+            buckets[op][b].store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+MetricsRegistry::MetricsRegistry() : blocks(nullptr) {
+}
+
+MetricsRegistry& MetricsRegistry::instance() {
+    // Never destroyed: threads may still release their blocks during exit
+    static MetricsRegistry* registry = new MetricsRegistry();
+    return *registry;
+}
+
+MetricsRegistry::ThreadBlock* MetricsRegistry::acquireBlock() {
+    {
+        std::lock_guard<std::mutex> lock(freeMutex);
+        if (!freeBlocks.empty()) {
+            ThreadBlock* block = freeBlocks.back();
+            freeBlocks.pop_back();
+            return block;
+        }
+    }
+
+    ThreadBlock* block = new ThreadBlock();
+    ThreadBlock* head = blocks.load(std::memory_order_relaxed);
+    do {
+        block->next = head;
+    } while (!blocks.compare_exchange_weak(head, block, std::memory_order_release, std::memory_order_relaxed));
+    return block;
+}
+
+void MetricsRegistry::releaseBlock(ThreadBlock* block) {
+    // Its counts stay part of the totals; the next new thread continues it
+    std::lock_guard<std::mutex> lock(freeMutex);
+    freeBlocks.push_back(block);
+}
+
+MetricsRegistry::ThreadBlock& MetricsRegistry::localBlock() {
+    if (!threadBlock.block) {
+        threadBlock.block = acquireBlock();
+    }
+    return *threadBlock.block;
+}
+
+int MetricsRegistry::bucketIndex(unsigned long long nanos) {
+    if (nanos < static_cast<unsigned long long>(kSubBuckets)) {
+        return static_cast<int>(nanos);
+    }
+    int exponent = 63;
+    while (!(nanos >> exponent)) exponent--;
+    if (exponent > kMaxExponent) {
+        return kBucketCount - 1;
+    }
+    int subBucket = static_cast<int>((nanos >> (exponent - kSubBucketBits)) & (kSubBuckets - 1));
+    return (exponent - kSubBucketBits + 1) * kSubBuckets + subBucket;
+}
+
+unsigned long long MetricsRegistry::bucketUpperBound(int bucket) {
+    if (bucket < kSubBuckets) {
+        return static_cast<unsigned long long>(bucket);
+    }
+    int exponent = bucket / kSubBuckets - 1 + kSubBucketBits;
+    unsigned long long subBucket = static_cast<unsigned long long>(bucket % kSubBuckets);
+    return ((kSubBuckets + subBucket + 1) << (exponent - kSubBucketBits)) - 1;
+}
+
+void MetricsRegistry::record(MetricId id, unsigned long long nanos) {
+    ThreadBlock& block = localBlock();
+    int op = static_cast<int>(id);
+
+    // Single writer per block: load + store instead of read-modify-write
+    auto bump = [](std::atomic<unsigned long long>& counter, unsigned long long amount) {
+        counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+    };
+    bump(block.counts[op], 1);
+    bump(block.totalNanos[op], nanos);
+    bump(block.buckets[op][bucketIndex(nanos)], 1);
+    if (nanos > block.maxNanos[op].load(std::memory_order_relaxed)) {
+        block.maxNanos[op].store(nanos, std::memory_order_relaxed);
+    }
+}
+
+std::vector<OperationStats> MetricsRegistry::collect() const {
+    std::vector<OperationStats> result(kOperationCount);
+    std::vector<std::vector<unsigned long long>> buckets(kOperationCount, std::vector<unsigned long long>(kBucketCount, 0));
+
+    for (ThreadBlock* block = blocks.load(std::memory_order_acquire); block; block = block->next) {
+        for (int op = 0; op < kOperationCount; op++) {
+            result[op].count += block->counts[op].load(std::memory_order_relaxed);
+            result[op].totalNanos += block->totalNanos[op].load(std::memory_order_relaxed);
+            result[op].maxNanos = std::max(result[op].maxNanos, block->maxNanos[op].load(std::memory_order_relaxed));
+            for (int b = 0; b < kBucketCount; b++) {
+                buckets[op][b] += block->buckets[op][b].load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    for (int op = 0; op < kOperationCount; op++) {
+        OperationStats& stats = result[op];
+        MetricId id = static_cast<MetricId>(op);
+        stats.component = componentName(id);
+        stats.operation = operationName(id);
+
+        // Counts are read without a lock, so use the bucket total for ranks
+        unsigned long long histogramCount = 0;
+        for (unsigned long long value : buckets[op]) histogramCount += value;
+        stats.p50Nanos = std::min(stats.maxNanos, percentile(buckets[op], histogramCount, 0.50, bucketUpperBound));
+        stats.p90Nanos = std::min(stats.maxNanos, percentile(buckets[op], histogramCount, 0.90, bucketUpperBound));
+        stats.p99Nanos = std::min(stats.maxNanos, percentile(buckets[op], histogramCount, 0.99, bucketUpperBound));
+    }
+    return result;
+}
+
+std::string MetricsRegistry::toPrometheus() const {
+    std::vector<OperationStats> stats = collect();
+
+    // Cumulative counts at the export bounds need the raw buckets again
+    std::vector<std::vector<unsigned long long>> cumulative(kOperationCount);
+    for (int op = 0; op < kOperationCount; op++) {
+        cumulative[op].assign(sizeof(kExportExponents) / sizeof(kExportExponents[0]), 0);
+    }
+    for (ThreadBlock* block = blocks.load(std::memory_order_acquire); block; block = block->next) {
+        for (int op = 0; op < kOperationCount; op++) {
+            for (int b = 0; b < kBucketCount; b++) {
+                unsigned long long value = block->buckets[op][b].load(std::memory_order_relaxed);
+                if (value == 0) continue;
+                unsigned long long upper = bucketUpperBound(b);
+                for (size_t e = 0; e < cumulative[op].size(); e++) {
+                    if (upper < (1ull << kExportExponents[e])) {
+                        cumulative[op][e] += value;
+                    }
+                }
+            }
+        }
+    }
+
+    std::ostringstream out;
+    out << "# HELP playwise_operations_total Engine operations performed.\n";
+    out << "# TYPE playwise_operations_total counter\n";
+    for (const auto& op : stats) {
+        out << "playwise_operations_total{component=\"" << op.component << "\",operation=\"" << op.operation
+            << "\"} " << op.count << "\n";
+    }
+
+    out << "# HELP playwise_operation_duration_seconds Engine operation latency.\n";
+    out << "# TYPE playwise_operation_duration_seconds histogram\n";
+    for (int op = 0; op < kOperationCount; op++) {
+        const OperationStats& s = stats[op];
+        std::string labels = "component=\"" + s.component + "\",operation=\"" + s.operation + "\"";
+        for (size_t e = 0; e < cumulative[op].size(); e++) {
+            out << "playwise_operation_duration_seconds_bucket{" << labels << ",le=\""
+                << static_cast<double>(1ull << kExportExponents[e]) / 1e9 << "\"} " << cumulative[op][e] << "\n";
+        }
+        out << "playwise_operation_duration_seconds_bucket{" << labels << ",le=\"+Inf\"} " << s.count << "\n";
+        out << "playwise_operation_duration_seconds_sum{" << labels << "} " << s.totalNanos / 1e9 << "\n";
+        out << "playwise_operation_duration_seconds_count{" << labels << "} " << s.count << "\n";
+    }
+    return out.str();
+}
+
+std::string MetricsRegistry::toJson() const {
+    std::ostringstream out;
+    out << "{\"enabled\":" << (isEnabled() ? "true" : "false") << ",\"operations\":[";
+    bool first = true;
+    for (const auto& op : collect()) {
+        if (!first) out << ",";
+        first = false;
+        out << "{\"component\":\"" << op.component << "\",\"operation\":\"" << op.operation
+            << "\",\"count\":" << op.count << ",\"total_ns\":" << op.totalNanos
+            << ",\"p50_ns\":" << op.p50Nanos << ",\"p90_ns\":" << op.p90Nanos
+            << ",\"p99_ns\":" << op.p99Nanos << ",\"max_ns\":" << op.maxNanos << "}";
+    }
+    out << "]}";
+    return out.str();
+}
+
+void MetricsRegistry::reset() {
+    // Racing records may survive a reset; that is fine for monitoring
+    for (ThreadBlock* block = blocks.load(std::memory_order_acquire); block; block = block->next) {
+        for (int op = 0; op < kOperationCount; op++) {
+            block->counts[op].store(0, std::memory_order_relaxed);
+            block->totalNanos[op].store(0, std::memory_order_relaxed);
+            block->maxNanos[op].store(0, std::memory_order_relaxed);
+            for (int b = 0; b < kBucketCount; b++) {
+                block->buckets[op][b].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+const char* MetricsRegistry::componentName(MetricId id) {
+    return kMetricNames[static_cast<int>(id)].component;
+}
+
+const char* MetricsRegistry::operationName(MetricId id) {
+    return kMetricNames[static_cast<int>(id)].operation;
+}
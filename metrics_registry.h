@@ -0,0 +1,142 @@
+#ifndef METRICS_REGISTRY_H
+#define METRICS_REGISTRY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Instrumented engine operations
+enum class MetricId {
+    PLAYLIST_ADD,
+    PLAYLIST_DELETE,
+    PLAYLIST_MOVE,
+    PLAYLIST_REVERSE,
+    PLAYLIST_SHUFFLE,
+    PLAYLIST_UNDO,
+    LOOKUP_ADD,
+    LOOKUP_SEARCH,
+    LOOKUP_DELETE,
+    RATING_INSERT,
+    RATING_SEARCH,
+    RATING_DELETE,
+    HISTORY_PLAY,
+    HISTORY_UNDO,
+    SORT_FULL,
+    SORT_TOP_K,
+    SORT_PAGE,
+    SNAPSHOT_EXPORT,
+    COUNT
+};
+
+// Aggregated numbers for one operation
+struct OperationStats {
+    std::string component;
+    std::string operation;
+    unsigned long long count = 0;
+    unsigned long long totalNanos = 0;
+    unsigned long long p50Nanos = 0;
+    unsigned long long p90Nanos = 0;
+    unsigned long long p99Nanos = 0;
+    unsigned long long maxNanos = 0;
+};
+
+// Per-operation call counters and latency histograms for the engines.
+//
+// Each thread records into its own block of counters (single writer,
+// relaxed atomics), so the hot path never contends; readers sum the blocks
+// without locking. Recording is off by default and costs one relaxed load
+// while off. Histograms are HDR-style: 8 linear sub-buckets per power of two
+// nanoseconds, i.e. within 12.5% of the true value.
+class MetricsRegistry {
+public:
+    static const int kSubBucketBits = 3;
+    static const int kSubBuckets = 1 << kSubBucketBits;
+    static const int kMaxExponent = 40;  // ~18 minutes; longer values land in the last bucket
+    static const int kBucketCount = (kMaxExponent - kSubBucketBits + 2) * kSubBuckets;
+
+private:
+    static const int kOperationCount = static_cast<int>(MetricId::COUNT);
+
+    // Counters written by one thread at a time
+    struct ThreadBlock {
+        std::atomic<unsigned long long> counts[kOperationCount];
+        std::atomic<unsigned long long> totalNanos[kOperationCount];
+        std::atomic<unsigned long long> maxNanos[kOperationCount];
+        std::atomic<unsigned long long> buckets[kOperationCount][kBucketCount];
+        ThreadBlock* next;
+
+        ThreadBlock();
+    };
+
+    static std::atomic<bool> enabled;
+
+    // Every block ever created (push-only); blocks of exited threads are reused
+    std::atomic<ThreadBlock*> blocks;
+    std::mutex freeMutex;
+    std::vector<ThreadBlock*> freeBlocks;
+
+    MetricsRegistry();
+
+    ThreadBlock* acquireBlock();
+    void releaseBlock(ThreadBlock* block);
+    ThreadBlock& localBlock();
+    static int bucketIndex(unsigned long long nanos);
+    static unsigned long long bucketUpperBound(int bucket);
+
+    friend struct ThreadBlockHolder;
+
+public:
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+    static MetricsRegistry& instance();
+
+    // Runtime switch
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static void setEnabled(bool on) { enabled.store(on, std::memory_order_relaxed); }
+
+    // Hot path
+    void record(MetricId id, unsigned long long nanos);
+
+    // Aggregation and export
+    std::vector<OperationStats> collect() const;
+    std::string toPrometheus() const;
+    std::string toJson() const;
+    void reset();
+
+    static const char* componentName(MetricId id);
+    static const char* operationName(MetricId id);
+
+    // Time complexity annotations:
+    // record: O(1) - three relaxed stores in the calling thread's block
+    // collect / toPrometheus / toJson: O(T * B) - T thread blocks, B buckets per operation
+};
+
+// Times a scope and records it under id when metrics are enabled
+class MetricsTimer {
+private:
+    MetricId id;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit MetricsTimer(MetricId metric) : id(metric), active(MetricsRegistry::isEnabled()) {
+        if (active) start = std::chrono::steady_clock::now();
+    }
+
+    ~MetricsTimer() {
+        if (active) {
+            auto elapsed = std::chrono::steady_clock::now() - start;
+            MetricsRegistry::instance().record(
+                id, static_cast<unsigned long long>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        }
+    }
+
+    MetricsTimer(const MetricsTimer&) = delete;
+    MetricsTimer& operator=(const MetricsTimer&) = delete;
+};
+
+#endif // METRICS_REGISTRY_H
@@ -0,0 +1,210 @@
+#include "order_statistic_tree.h"
+#include <algorithm>
+#include <climits>
+
+OrderStatisticTree::OrderStatisticTree() : root(nullptr) {
+}
+
+OrderStatisticTree::~OrderStatisticTree() {
+    clearTree(root);
+}
+
+void OrderStatisticTree::clearTree(RankNode* node) {
+    if (node) {
+        clearTree(node->left);
+        clearTree(node->right);
+        delete node;
+    }
+}
+
+void OrderStatisticTree::clear() {
+    clearTree(root);
+    root = nullptr;
+}
+
+void OrderStatisticTree::update(RankNode* node) {
+    node->height = 1 + std::max(height(node->left), height(node->right));
+    node->size = 1 + sizeOf(node->left) + sizeOf(node->right);
+}
+
+RankNode* OrderStatisticTree::rotateLeft(RankNode* node) {
+    RankNode* pivot = node->right;
+    node->right = pivot->left;
+    pivot->left = node;
+    update(node);
+    update(pivot);
+    return pivot;
+}
+
+RankNode* OrderStatisticTree::rotateRight(RankNode* node) {
+    RankNode* pivot = node->left;
+    node->left = pivot->right;
+    pivot->right = node;
+    update(node);
+    update(pivot);
+    return pivot;
+}
+
+RankNode* OrderStatisticTree::rebalance(RankNode* node) {
+    update(node);
+    int balance = height(node->left) - height(node->right);
+    
+    if (balance > 1) {
+        // Left-right case becomes left-left first
+        if (height(node->left->left) < height(node->left->right)) {
+            node->left = rotateLeft(node->left);
+        }
+        return rotateRight(node);
+    }
+    if (balance < -1) {
+        if (height(node->right->right) < height(node->right->left)) {
+            node->right = rotateRight(node->right);
+        }
+        return rotateLeft(node);
+    }
+    return node;
+}
+
+RankNode* OrderStatisticTree::insertNode(RankNode* node, const ScoredSong& entry, bool& inserted) {
+    if (node == nullptr) {
+        inserted = true;
+        return new RankNode(entry);
+    }
+    
+    if (entry < node->entry) {
+        node->left = insertNode(node->left, entry, inserted);
+    } else if (node->entry < entry) {
+        node->right = insertNode(node->right, entry, inserted);
+    } else {
+        return node; // already present
+    }
+    return rebalance(node);
+}
+
+RankNode* OrderStatisticTree::detachMin(RankNode* node, RankNode*& minNode) {
+    if (node->left == nullptr) {
+        minNode = node;
+        return node->right;
+    }
+    node->left = detachMin(node->left, minNode);
+    return rebalance(node);
+}
+
+RankNode* OrderStatisticTree::eraseNode(RankNode* node, const ScoredSong& entry, bool& erased) {
+    if (node == nullptr) {
+        return nullptr;
+    }
+    
+    if (entry < node->entry) {
+        node->left = eraseNode(node->left, entry, erased);
+    } else if (node->entry < entry) {
+        node->right = eraseNode(node->right, entry, erased);
+    } else {
+        erased = true;
+        RankNode* left = node->left;
+        RankNode* right = node->right;
+        delete node;
+        if (right == nullptr) return left;
+        
+        // Successor takes the removed node's place
+        RankNode* successor = nullptr;
+        right = detachMin(right, successor);
+        successor->left = left;
+        successor->right = right;
+        return rebalance(successor);
+    }
+    return rebalance(node);
+}
+
+bool OrderStatisticTree::insert(double score, int songId) {
+    bool inserted = false;
+    root = insertNode(root, ScoredSong{score, songId}, inserted);
+    return inserted;
+}
+
+bool OrderStatisticTree::erase(double score, int songId) {
+    bool erased = false;
+    root = eraseNode(root, ScoredSong{score, songId}, erased);
+    return erased;
+}
+
+size_t OrderStatisticTree::rankOf(double score, int songId) const {
+    ScoredSong key{score, songId};
+    size_t rank = 0;
+    const RankNode* node = root;
+    while (node) {
+        if (node->entry < key) {
+            rank += sizeOf(node->left) + 1;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return rank;
+}
+
+size_t OrderStatisticTree::countScores(double score, bool inclusive) const {
+    size_t count = 0;
+    const RankNode* node = root;
+    while (node) {
+        if (node->entry.score < score || (inclusive && node->entry.score == score)) {
+            count += sizeOf(node->left) + 1;
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return count;
+}
+
+size_t OrderStatisticTree::countBelow(double score) const {
+    return countScores(score, false);
+}
+
+size_t OrderStatisticTree::countBetween(double lowScore, double highScore) const {
+    if (highScore < lowScore) return 0;
+    return countScores(highScore, true) - countScores(lowScore, false);
+}
+
+bool OrderStatisticTree::select(size_t rank, ScoredSong& entry) const {
+    const RankNode* node = root;
+    while (node) {
+        size_t leftSize = sizeOf(node->left);
+        if (rank < leftSize) {
+            node = node->left;
+        } else if (rank == leftSize) {
+            entry = node->entry;
+            return true;
+        } else {
+            rank -= leftSize + 1;
+            node = node->right;
+        }
+    }
+    return false;
+}
+
+bool OrderStatisticTree::selectBest(size_t k, ScoredSong& entry) const {
+    if (k >= size()) return false;
+    return select(size() - 1 - k, entry);
+}
+
+double OrderStatisticTree::percentileOf(double score, int songId) const {
+    if (size() == 0) return 0.0;
+    return static_cast<double>(rankOf(score, songId)) / static_cast<double>(size());
+}
+
+void OrderStatisticTree::collect(const RankNode* node, const ScoredSong& low, const ScoredSong& high,
+                                 std::vector<ScoredSong>& out) const {
+    if (!node) return;
+    // Only descend into subtrees that can overlap [low, high]
+    if (low < node->entry) collect(node->left, low, high, out);
+    if (!(node->entry < low) && !(high < node->entry)) out.push_back(node->entry);
+    if (node->entry < high) collect(node->right, low, high, out);
+}
+
+std::vector<ScoredSong> OrderStatisticTree::range(double lowScore, double highScore) const {
+    std::vector<ScoredSong> result;
+    if (highScore < lowScore) return result;
+    collect(root, ScoredSong{lowScore, INT_MIN}, ScoredSong{highScore, INT_MAX}, result);
+    return result;
+}
@@ -0,0 +1,85 @@
+#ifndef ORDER_STATISTIC_TREE_H
+#define ORDER_STATISTIC_TREE_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// Entry of an OrderStatisticTree: ordered by score, then song id
+struct ScoredSong {
+    double score;
+    int songId;
+    
+    bool operator<(const ScoredSong& other) const {
+        return score < other.score || (score == other.score && songId < other.songId);
+    }
+    bool operator==(const ScoredSong& other) const {
+        return score == other.score && songId == other.songId;
+    }
+};
+
+// Node structure for the size-augmented AVL tree
+struct RankNode {
+    ScoredSong entry;
+    RankNode* left;
+    RankNode* right;
+    int height;
+    size_t size;  // entries in this subtree
+    
+    RankNode(const ScoredSong& e) : entry(e), left(nullptr), right(nullptr), height(1), size(1) {}
+};
+
+// Balanced search tree over (score, song id) where every node also knows
+// its subtree size, so counting, ranking and selecting the k-th entry take
+// O(log n) instead of a walk over the whole tree. Ascending order:
+// rank 0 is the lowest score.
+class OrderStatisticTree {
+private:
+    RankNode* root;
+    
+    // Helper methods
+    static int height(const RankNode* node) { return node ? node->height : 0; }
+    static size_t sizeOf(const RankNode* node) { return node ? node->size : 0; }
+    static void update(RankNode* node);
+    static RankNode* rotateLeft(RankNode* node);
+    static RankNode* rotateRight(RankNode* node);
+    static RankNode* rebalance(RankNode* node);
+    static RankNode* insertNode(RankNode* node, const ScoredSong& entry, bool& inserted);
+    static RankNode* eraseNode(RankNode* node, const ScoredSong& entry, bool& erased);
+    static RankNode* detachMin(RankNode* node, RankNode*& minNode);
+    size_t countScores(double score, bool inclusive) const;  // entries below (or at) score
+    void collect(const RankNode* node, const ScoredSong& low, const ScoredSong& high, std::vector<ScoredSong>& out) const;
+    void clearTree(RankNode* node);
+
+public:
+    // Constructor and destructor
+    OrderStatisticTree();
+    ~OrderStatisticTree();
+    
+    OrderStatisticTree(const OrderStatisticTree&) = delete;
+    OrderStatisticTree& operator=(const OrderStatisticTree&) = delete;
+    
+    // Core operations
+    bool insert(double score, int songId);
+    bool erase(double score, int songId);
+    void clear();
+    
+    // Order statistics
+    size_t size() const { return sizeOf(root); }
+    size_t countBelow(double score) const;                     // entries with a lower score
+    size_t countBetween(double lowScore, double highScore) const;  // inclusive
+    size_t rankOf(double score, int songId) const;             // entries ordered before (score, songId)
+    bool select(size_t rank, ScoredSong& entry) const;         // rank-th lowest entry
+    bool selectBest(size_t k, ScoredSong& entry) const;        // k-th highest, k = 0 is the best
+    double percentileOf(double score, int songId) const;       // share of entries ordered before, in [0, 1)
+    
+    // Range scans, ascending
+    std::vector<ScoredSong> range(double lowScore, double highScore) const;  // inclusive
+    
+    // Time complexity annotations:
+    // insert / erase: O(log n) - AVL rebalancing keeps the height below 1.44 log n
+    // countBelow / countBetween / rankOf / select / selectBest / percentileOf: O(log n)
+    // range: O(log n + k) - k entries returned
+};
+
+#endif // ORDER_STATISTIC_TREE_H
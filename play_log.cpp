@@ -0,0 +1,157 @@
+#include "play_log.h"
+#include "song.h"
+#include <algorithm>
+
+size_t PlayLog::firstSegmentEndingAtOrAfter(long long micros) const {
+    auto it = std::lower_bound(segments.begin(), segments.end(), micros,
+                               [](const Segment& segment, long long time) {
+                                   return segment.summary.lastMicros < time;
+                               });
+    return static_cast<size_t>(it - segments.begin());
+}
+
+size_t PlayLog::segmentOf(size_t sequence) const {
+    auto it = std::upper_bound(segments.begin(), segments.end(), sequence,
+                               [](size_t value, const Segment& segment) {
+                                   return value < segment.firstSequence;
+                               });
+    return static_cast<size_t>(it - segments.begin()) - 1;
+}
+
+long long PlayLog::append(int songId, int durationSeconds, std::chrono::system_clock::time_point playedAt) {
+    long long micros = toEpochMicros(playedAt);
+    if (!segments.empty()) micros = std::max(micros, segments.back().summary.lastMicros);
+    
+    if (segments.empty() || segments.back().compacted || segments.back().summary.plays == kSegmentPlays) {
+        segments.emplace_back();
+        segments.back().firstSequence = playCount;
+        segments.back().entries.reserve(kSegmentPlays);
+        segments.back().summary.firstMicros = micros;
+    }
+    Segment& segment = segments.back();
+    segment.entries.push_back(PlayLogEntry{micros, songId, durationSeconds});
+    segment.summary.plays++;
+    segment.summary.listenedSeconds += durationSeconds;
+    segment.summary.lastMicros = micros;
+    playCount++;
+    return micros;
+}
+
+bool PlayLog::removeLast(int durationSeconds) {
+    if (segments.empty()) return false;
+    
+    Segment& segment = segments.back();
+    if (segment.compacted) {
+        // The time of the play before it is gone with the entries; like every
+        // compacted play it counts from the segment's start, so later plays
+        // are not clamped to the time of the one removed here
+        segment.summary.listenedSeconds -= durationSeconds;
+        segment.summary.lastMicros = segment.summary.firstMicros;
+        compactedPlays--;
+    } else {
+        segment.summary.listenedSeconds -= segment.entries.back().durationSeconds;
+        segment.entries.pop_back();
+        if (!segment.entries.empty()) segment.summary.lastMicros = segment.entries.back().playedMicros;
+    }
+    segment.summary.plays--;
+    playCount--;
+    if (segment.summary.plays == 0) segments.pop_back();
+    return true;
+}
+
+size_t PlayLog::compactBefore(std::chrono::system_clock::time_point cutoff) {
+    long long cutoffMicros = toEpochMicros(cutoff);
+    size_t folded = 0;
+    // Segments are in time order, so the first one ending at or after the cutoff stops the scan
+    for (size_t i = 0; i + 1 < segments.size() && segments[i].summary.lastMicros < cutoffMicros; i++) {
+        Segment& segment = segments[i];
+        if (segment.compacted || segment.summary.plays < kSegmentPlays) continue;
+        folded += segment.entries.size();
+        std::vector<PlayLogEntry>().swap(segment.entries);
+        segment.compacted = true;
+    }
+    compactedPlays += folded;
+    return folded;
+}
+
+void PlayLog::clear() {
+    segments.clear();
+    playCount = 0;
+    compactedPlays = 0;
+}
+
+std::vector<std::pair<size_t, PlayLogEntry>> PlayLog::playsBetween(std::chrono::system_clock::time_point from,
+                                                                   std::chrono::system_clock::time_point to) const {
+    long long fromMicros = toEpochMicros(from);
+    long long toMicros = toEpochMicros(to);
+    std::vector<std::pair<size_t, PlayLogEntry>> result;
+    auto earlier = [](const PlayLogEntry& entry, long long time) { return entry.playedMicros < time; };
+    
+    for (size_t i = firstSegmentEndingAtOrAfter(fromMicros);
+         i < segments.size() && segments[i].summary.firstMicros < toMicros; i++) {
+        const Segment& segment = segments[i];
+        if (segment.compacted) continue;
+        auto entry = std::lower_bound(segment.entries.begin(), segment.entries.end(), fromMicros, earlier);
+        for (; entry != segment.entries.end() && entry->playedMicros < toMicros; ++entry) {
+            size_t sequence = segment.firstSequence + static_cast<size_t>(entry - segment.entries.begin());
+            result.push_back({sequence, *entry});
+        }
+    }
+    return result;
+}
+
+PlaySummary PlayLog::summarizeBetween(std::chrono::system_clock::time_point from,
+                                      std::chrono::system_clock::time_point to) const {
+    long long fromMicros = toEpochMicros(from);
+    long long toMicros = toEpochMicros(to);
+    PlaySummary total;
+    auto earlier = [](const PlayLogEntry& entry, long long time) { return entry.playedMicros < time; };
+    auto include = [&total](long long first, long long last) {
+        if (total.plays == 0) total.firstMicros = first;
+        total.lastMicros = last;
+    };
+    
+    for (size_t i = firstSegmentEndingAtOrAfter(fromMicros);
+         i < segments.size() && segments[i].summary.firstMicros < toMicros; i++) {
+        const Segment& segment = segments[i];
+        bool inside = segment.summary.firstMicros >= fromMicros && segment.summary.lastMicros < toMicros;
+        if (inside || segment.compacted) {
+            // A compacted segment on the edge of the range counts in full
+            if (!inside) total.exact = false;
+            include(segment.summary.firstMicros, segment.summary.lastMicros);
+            total.plays += segment.summary.plays;
+            total.listenedSeconds += segment.summary.listenedSeconds;
+            continue;
+        }
+        auto first = std::lower_bound(segment.entries.begin(), segment.entries.end(), fromMicros, earlier);
+        auto last = std::lower_bound(first, segment.entries.end(), toMicros, earlier);
+        if (first == last) continue;
+        include(first->playedMicros, std::prev(last)->playedMicros);
+        total.plays += static_cast<size_t>(last - first);
+        for (auto entry = first; entry != last; ++entry) {
+            total.listenedSeconds += entry->durationSeconds;
+        }
+    }
+    return total;
+}
+
+bool PlayLog::getPlayTime(size_t sequence, long long& playedMicros) const {
+    if (sequence >= playCount) return false;
+    const Segment& segment = segments[segmentOf(sequence)];
+    if (segment.compacted) {
+        playedMicros = segment.summary.firstMicros;
+        return false;
+    }
+    playedMicros = segment.entries[sequence - segment.firstSequence].playedMicros;
+    return true;
+}
+
+MemoryUsage PlayLog::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.items = playCount;
+    usage.structureBytes = segments.capacity() * sizeof(Segment);
+    for (const auto& segment : segments) {
+        usage.structureBytes += segment.entries.capacity() * sizeof(PlayLogEntry);
+    }
+    return usage;
+}
@@ -0,0 +1,95 @@
+#ifndef PLAY_LOG_H
+#define PLAY_LOG_H
+
+#include "memory_usage.h"
+#include <chrono>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// One play in the log
+struct PlayLogEntry {
+    long long playedMicros = 0;  // microseconds since the Unix epoch
+    int songId = 0;
+    int durationSeconds = 0;
+};
+
+// Aggregate of a run of plays; all that is left of a compacted segment
+struct PlaySummary {
+    size_t plays = 0;
+    long long listenedSeconds = 0;
+    long long firstMicros = 0;
+    long long lastMicros = 0;
+    bool exact = true;  // false if a compacted segment only partly overlapped the range
+};
+
+// Append-only, time-indexed log of plays, split into fixed-size segments.
+//
+// Plays are numbered in play order (their sequence) and stored up to
+// kSegmentPlays per segment. Times never decrease along the log: a play
+// stamped earlier than the one before it (e.g. after a clock change) is
+// stored with the previous time. A range query binary-searches the segments by
+// time, then the entries of the first segment, and reads on from there.
+//
+// Old segments can be compacted: their entries are dropped and only a
+// PlaySummary remains. Range queries then skip their plays and
+// summarizeBetween() counts them from the summary. The segment being
+// appended to is never compacted. removeLast() takes back the newest play
+// (undo), even from a compacted segment; the plays left in it then end at
+// the segment's start.
+class PlayLog {
+public:
+    static constexpr size_t kSegmentPlays = 4096;
+
+private:
+    struct Segment {
+        size_t firstSequence = 0;
+        PlaySummary summary;
+        std::vector<PlayLogEntry> entries;  // empty once compacted
+        bool compacted = false;
+    };
+    
+    std::vector<Segment> segments;
+    size_t playCount = 0;
+    size_t compactedPlays = 0;
+    
+    // First segment whose last play is at or after the given time
+    size_t firstSegmentEndingAtOrAfter(long long micros) const;
+    size_t segmentOf(size_t sequence) const;
+
+public:
+    // Constructor
+    PlayLog() = default;
+    
+    PlayLog(const PlayLog&) = delete;
+    PlayLog& operator=(const PlayLog&) = delete;
+    
+    // Core operations
+    long long append(int songId, int durationSeconds, std::chrono::system_clock::time_point playedAt);  // stored time
+    bool removeLast(int durationSeconds);  // duration of the removed play, needed if it was compacted
+    size_t compactBefore(std::chrono::system_clock::time_point cutoff);  // full segments ending before cutoff
+    void clear();
+    
+    // Queries over [from, to)
+    std::vector<std::pair<size_t, PlayLogEntry>> playsBetween(std::chrono::system_clock::time_point from,
+                                                              std::chrono::system_clock::time_point to) const;  // (sequence, play)
+    PlaySummary summarizeBetween(std::chrono::system_clock::time_point from,
+                                 std::chrono::system_clock::time_point to) const;
+    bool getPlayTime(size_t sequence, long long& playedMicros) const;  // false if compacted (segment start given)
+    
+    // Utility methods
+    size_t size() const { return playCount; }
+    size_t getSegmentCount() const { return segments.size(); }
+    size_t getCompactedPlays() const { return compactedPlays; }
+    MemoryUsage getMemoryUsage() const;
+    
+    // Time complexity annotations:
+    // append / removeLast: O(1) amortized
+    // compactBefore: O(s + c) - s segments checked, c compacted entries freed
+    // playsBetween: O(log n + k) - segment search, entry search, then k plays in range
+    // summarizeBetween: O(log n + s' + B) - s' segments in range, at most B = kSegmentPlays
+    //   live plays summed at each edge
+    // getPlayTime: O(log s) - s segments
+};
+
+#endif // PLAY_LOG_H
@@ -0,0 +1,270 @@
+#include "play_statistics.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <queue>
+
+namespace {
+
+// std::list node: two links plus the value
+template <typename T>
+size_t listNodeBytes() {
+    return 2 * sizeof(void*) + sizeof(T);
+}
+
+const double kMicrosPerHalfLife = PlayStatistics::kTrendingHalfLifeHours * 3600.0 * 1e6;
+
+}  // namespace
+
+void PlayCounter::increment(int key) {
+    auto found = positions.find(key);
+    if (found == positions.end()) {
+        if (buckets.empty() || buckets.front().count != 1) buckets.push_front(Bucket{1, {}});
+        auto bucket = buckets.begin();
+        bucket->keys.push_back(key);
+        positions.emplace(key, Position{bucket, std::prev(bucket->keys.end())});
+        return;
+    }
+    
+    Position& position = found->second;
+    auto current = position.bucket;
+    auto next = std::next(current);
+    if (next == buckets.end() || next->count != current->count + 1) {
+        next = buckets.insert(next, Bucket{current->count + 1, {}});
+    }
+    // splice keeps the key's list iterator valid
+    next->keys.splice(next->keys.end(), current->keys, position.key);
+    position.bucket = next;
+    if (current->keys.empty()) buckets.erase(current);
+}
+
+bool PlayCounter::decrement(int key) {
+    auto found = positions.find(key);
+    if (found == positions.end()) return false;
+    
+    Position& position = found->second;
+    auto current = position.bucket;
+    if (current->count == 1) {
+        current->keys.erase(position.key);
+        positions.erase(found);
+    } else {
+        auto previous = current == buckets.begin() ? buckets.end() : std::prev(current);
+        if (previous == buckets.end() || previous->count != current->count - 1) {
+            previous = buckets.insert(current, Bucket{current->count - 1, {}});
+        }
+        previous->keys.splice(previous->keys.end(), current->keys, position.key);
+        position.bucket = previous;
+    }
+    if (current->keys.empty()) buckets.erase(current);
+    return true;
+}
+
+void PlayCounter::clear() {
+    buckets.clear();
+    positions.clear();
+}
+
+unsigned long long PlayCounter::count(int key) const {
+    auto found = positions.find(key);
+    return found == positions.end() ? 0 : found->second.bucket->count;
+}
+
+std::vector<std::pair<int, unsigned long long>> PlayCounter::top(size_t k) const {
+    std::vector<std::pair<int, unsigned long long>> result;
+    for (auto bucket = buckets.rbegin(); bucket != buckets.rend() && result.size() < k; ++bucket) {
+        for (int key : bucket->keys) {
+            if (result.size() == k) break;
+            result.push_back({key, bucket->count});
+        }
+    }
+    return result;
+}
+
+MemoryUsage PlayCounter::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.items = positions.size();
+    usage.structureBytes = buckets.size() * listNodeBytes<Bucket>() + positions.size() * listNodeBytes<int>() +
+                           hashTableBytes(positions);
+    return usage;
+}
+
+long long PlayStatistics::hourOf(long long epochMicros) {
+    const long long microsPerHour = 3600LL * 1000000LL;
+    // Floor division, so plays before the epoch still land in distinct hours
+    return epochMicros / microsPerHour - (epochMicros % microsPerHour < 0 ? 1 : 0);
+}
+
+size_t PlayStatistics::slotOf(long long hour) {
+    return static_cast<size_t>(((hour % kTimelineHours) + kTimelineHours) % kTimelineHours);
+}
+
+int32_t PlayStatistics::encodeArtist(const std::string& artist) {
+    auto it = artistDictionary.find(artist);
+    if (it != artistDictionary.end()) return it->second;
+    
+    int32_t code = static_cast<int32_t>(artistNames.size());
+    artistNames.push_back(artist);
+    artistDictionary.emplace(artist, code);
+    return code;
+}
+
+double PlayStatistics::weightAt(long long epochMicros) const {
+    return std::exp2(static_cast<double>(epochMicros - decayOriginMicros) / kMicrosPerHalfLife);
+}
+
+void PlayStatistics::moveDecayOrigin(long long epochMicros) {
+    double scale = std::exp2(static_cast<double>(decayOriginMicros - epochMicros) / kMicrosPerHalfLife);
+    for (auto& entry : songs) {
+        entry.second.trendingWeight *= scale;
+    }
+    decayOriginMicros = epochMicros;
+}
+
+void PlayStatistics::recordPlay(const Song& song, std::chrono::system_clock::time_point when) {
+    long long playedMicros = toEpochMicros(when);
+    if (!hasDecayOrigin) {
+        decayOriginMicros = playedMicros;
+        hasDecayOrigin = true;
+    } else if (playedMicros - decayOriginMicros > kRescaleHalfLives * kMicrosPerHalfLife) {
+        moveDecayOrigin(playedMicros);
+    }
+    
+    int32_t artistCode = encodeArtist(song.artist);
+    SongEntry& entry = songs[song.id];
+    entry.title = song.title;
+    entry.artistCode = artistCode;
+    entry.trendingWeight += weightAt(playedMicros);
+    songPlays.increment(song.id);
+    artistPlays.increment(artistCode);
+    plays.push_back(PlayRecord{song.id, artistCode, playedMicros});
+    
+    long long hour = hourOf(playedMicros);
+    HourSlot& slot = timeline[slotOf(hour)];
+    if (slot.hour < hour) {
+        slot.hour = hour;
+        slot.plays = 0;
+    }
+    if (slot.hour == hour) slot.plays++;  // plays older than the slot's hour have aged out
+}
+
+bool PlayStatistics::undoPlay() {
+    if (plays.empty()) return false;
+    
+    PlayRecord play = plays.back();
+    plays.pop_back();
+    artistPlays.decrement(play.artistCode);
+    songPlays.decrement(play.songId);
+    
+    auto entry = songs.find(play.songId);
+    if (entry != songs.end()) {
+        if (songPlays.count(play.songId) == 0) {
+            songs.erase(entry);  // also drops any rounding left in the weight
+        } else {
+            entry->second.trendingWeight = std::max(0.0, entry->second.trendingWeight - weightAt(play.playedMicros));
+        }
+    }
+    
+    long long hour = hourOf(play.playedMicros);
+    HourSlot& slot = timeline[slotOf(hour)];
+    if (slot.hour == hour && slot.plays > 0) slot.plays--;
+    
+    if (plays.empty()) hasDecayOrigin = false;
+    return true;
+}
+
+void PlayStatistics::clear() {
+    songs.clear();
+    artistNames.clear();
+    artistDictionary.clear();
+    songPlays.clear();
+    artistPlays.clear();
+    plays.clear();
+    timeline.fill(HourSlot());
+    decayOriginMicros = 0;
+    hasDecayOrigin = false;
+}
+
+unsigned long long PlayStatistics::getArtistPlayCount(const std::string& artist) const {
+    auto it = artistDictionary.find(artist);
+    return it == artistDictionary.end() ? 0 : artistPlays.count(it->second);
+}
+
+double PlayStatistics::getTrendingScore(int songId, std::chrono::system_clock::time_point now) const {
+    auto entry = songs.find(songId);
+    if (entry == songs.end()) return 0.0;
+    return entry->second.trendingWeight / weightAt(toEpochMicros(now));
+}
+
+std::vector<std::pair<int, unsigned long long>> PlayStatistics::mostPlayedSongs(size_t count) const {
+    return songPlays.top(count);
+}
+
+std::vector<std::pair<std::string, unsigned long long>> PlayStatistics::mostPlayedArtists(size_t count) const {
+    std::vector<std::pair<std::string, unsigned long long>> result;
+    for (const auto& artist : artistPlays.top(count)) {
+        result.push_back({artistNames[artist.first], artist.second});
+    }
+    return result;
+}
+
+std::vector<std::pair<int, double>> PlayStatistics::trendingSongs(size_t count,
+                                                                  std::chrono::system_clock::time_point now) const {
+    if (count == 0) return {};
+    
+    // Min-heap of the best k (weight, -id); ties go to the lower id
+    using Entry = std::pair<double, int>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> best;
+    for (const auto& song : songs) {
+        Entry entry(song.second.trendingWeight, -song.first);
+        if (best.size() < count) {
+            best.push(entry);
+        } else if (best.top() < entry) {
+            best.pop();
+            best.push(entry);
+        }
+    }
+    
+    double decay = weightAt(toEpochMicros(now));
+    std::vector<std::pair<int, double>> result(best.size());
+    for (size_t i = result.size(); i-- > 0;) {
+        result[i] = {-best.top().second, best.top().first / decay};
+        best.pop();
+    }
+    return result;
+}
+
+std::vector<size_t> PlayStatistics::playsPerHour(int hours, std::chrono::system_clock::time_point now) const {
+    hours = std::max(0, std::min(hours, kTimelineHours));
+    long long currentHour = hourOf(toEpochMicros(now));
+    std::vector<size_t> result(hours, 0);
+    for (int i = 0; i < hours; i++) {
+        long long hour = currentHour - (hours - 1 - i);
+        const HourSlot& slot = timeline[slotOf(hour)];
+        if (slot.hour == hour) result[i] = slot.plays;
+    }
+    return result;
+}
+
+std::string PlayStatistics::describeSong(int songId) const {
+    auto entry = songs.find(songId);
+    if (entry == songs.end()) return "";
+    return entry->second.title + " by " + artistNames[entry->second.artistCode];
+}
+
+MemoryUsage PlayStatistics::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.items = plays.size();
+    usage.structureBytes = hashTableBytes(songs) + artistNames.capacity() * sizeof(std::string) +
+                           hashTableBytes(artistDictionary) + plays.capacity() * sizeof(PlayRecord) +
+                           sizeof(timeline);
+    for (const auto& song : songs) {
+        usage.stringBytes += stringHeapBytes(song.second.title);
+    }
+    for (const auto& artist : artistNames) {
+        usage.stringBytes += 2 * stringHeapBytes(artist);
+    }
+    MemoryUsage songCounts = songPlays.getMemoryUsage();
+    MemoryUsage artistCounts = artistPlays.getMemoryUsage();
+    usage.structureBytes += songCounts.structureBytes + artistCounts.structureBytes;
+    return usage;
+}
@@ -0,0 +1,155 @@
+#ifndef PLAY_STATISTICS_H
+#define PLAY_STATISTICS_H
+
+#include "song.h"
+#include "memory_usage.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Counts per integer key that only ever move by one, kept ordered at all
+// times.
+//
+// Keys with the same count share a bucket, and buckets form a list in
+// ascending count order. A +1 or -1 moves the key to the neighbouring
+// bucket, so both are O(1), and the top k is read off the end of the list
+// without sorting. Among equal counts, the key that reached the count first
+// comes first.
+class PlayCounter {
+private:
+    struct Bucket {
+        unsigned long long count;
+        std::list<int> keys;
+    };
+    
+    struct Position {
+        std::list<Bucket>::iterator bucket;
+        std::list<int>::iterator key;
+    };
+    
+    std::list<Bucket> buckets;  // ascending count, never empty
+    std::unordered_map<int, Position> positions;
+
+public:
+    // Constructor
+    PlayCounter() = default;
+    
+    PlayCounter(const PlayCounter&) = delete;
+    PlayCounter& operator=(const PlayCounter&) = delete;
+    
+    // Core operations
+    void increment(int key);
+    bool decrement(int key);  // false if the key has no count; a count of 0 drops the key
+    void clear();
+    
+    // Queries
+    unsigned long long count(int key) const;
+    std::vector<std::pair<int, unsigned long long>> top(size_t k) const;  // highest count first
+    size_t size() const { return positions.size(); }
+    MemoryUsage getMemoryUsage() const;
+    
+    // Time complexity annotations:
+    // increment / decrement / count: O(1) average - one hash lookup and a list splice
+    // top: O(k)
+};
+
+// Streaming play aggregates, updated as each play is recorded.
+//
+// Keeps play counts per song and per artist, an exponentially decayed
+// "trending" score per song (half-life kTrendingHalfLifeHours) and a
+// histogram of plays per clock hour for the last kTimelineHours hours.
+// Every play is remembered with its time, so undoPlay() reverses the newest
+// play exactly.
+//
+// Decay is applied lazily: a play at time t adds 2^((t - origin) / halfLife)
+// to the song's stored weight, which is scaled down to the query time only
+// when read. All songs decay by the same factor, so comparing stored
+// weights orders songs by their current score. The origin is moved forward
+// (rescaling every weight) before the weights can overflow.
+class PlayStatistics {
+public:
+    static constexpr int kTimelineHours = 24 * 7;
+    static constexpr double kTrendingHalfLifeHours = 24.0;
+
+private:
+    static constexpr double kRescaleHalfLives = 512.0;  // weights stay below 2^512 per play
+    
+    struct SongEntry {
+        std::string title;
+        int32_t artistCode = 0;
+        double trendingWeight = 0.0;  // relative to decayOriginMicros
+    };
+    
+    struct PlayRecord {
+        int songId;
+        int32_t artistCode;
+        long long playedMicros;
+    };
+    
+    struct HourSlot {
+        long long hour = -1;  // hours since the epoch, -1 = unused
+        size_t plays = 0;
+    };
+    
+    std::unordered_map<int, SongEntry> songs;  // songs with at least one play
+    std::vector<std::string> artistNames;      // code -> artist
+    std::unordered_map<std::string, int32_t> artistDictionary;
+    PlayCounter songPlays;                     // song id -> plays
+    PlayCounter artistPlays;                   // artist code -> plays
+    std::vector<PlayRecord> plays;             // oldest first, for undo
+    std::array<HourSlot, kTimelineHours> timeline;  // slot = hour % kTimelineHours
+    long long decayOriginMicros = 0;
+    bool hasDecayOrigin = false;
+    
+    static long long hourOf(long long epochMicros);
+    static size_t slotOf(long long hour);
+    int32_t encodeArtist(const std::string& artist);
+    double weightAt(long long epochMicros) const;  // 2^((t - origin) / halfLife)
+    void moveDecayOrigin(long long epochMicros);
+
+public:
+    // Constructor
+    PlayStatistics() = default;
+    
+    PlayStatistics(const PlayStatistics&) = delete;
+    PlayStatistics& operator=(const PlayStatistics&) = delete;
+    
+    // Core operations
+    void recordPlay(const Song& song, std::chrono::system_clock::time_point when = std::chrono::system_clock::now());
+    bool undoPlay();  // reverses the newest recorded play; false if there is none
+    void clear();
+    
+    // Queries
+    unsigned long long getPlayCount(int songId) const { return songPlays.count(songId); }
+    unsigned long long getArtistPlayCount(const std::string& artist) const;
+    double getTrendingScore(int songId,
+                            std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;
+    std::vector<std::pair<int, unsigned long long>> mostPlayedSongs(size_t count) const;
+    std::vector<std::pair<std::string, unsigned long long>> mostPlayedArtists(size_t count) const;
+    std::vector<std::pair<int, double>> trendingSongs(size_t count,
+        std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;  // highest first
+    std::vector<size_t> playsPerHour(int hours,
+        std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;  // oldest hour first
+    std::string describeSong(int songId) const;  // "title by artist", empty if never played
+    
+    // Utility methods
+    size_t getTotalPlays() const { return plays.size(); }
+    size_t getPlayedSongCount() const { return songs.size(); }
+    MemoryUsage getMemoryUsage() const;
+    
+    // Time complexity annotations:
+    // recordPlay / undoPlay: O(1) average (O(s) when the decay origin moves, at most once per
+    //   kRescaleHalfLives half-lives of play time); s = distinct songs played
+    // getPlayCount / getArtistPlayCount / getTrendingScore: O(1) average
+    // mostPlayedSongs / mostPlayedArtists: O(k) - read from the counter buckets
+    // trendingSongs: O(s log k) - bounded heap over the stored weights
+    // playsPerHour: O(h) - h <= kTimelineHours
+    // getMemoryUsage: O(s + a + p) - a artists, p remembered plays
+};
+
+#endif // PLAY_STATISTICS_H
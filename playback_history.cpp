@@ -1,13 +1,26 @@
 #include "playback_history.h"
+#include "metrics_registry.h"
+#include "write_ahead_log.h"
 #include <iostream>
 #include <algorithm>
 
-void PlaybackHistory::addPlayedSong(const Song& song) {
+void PlaybackHistory::addPlayedSong(const Song& song, std::chrono::system_clock::time_point playedAt) {
+    MetricsTimer timer(MetricId::HISTORY_PLAY);
     historyStack.push(song);
     historyVector.push_back(song);
+    long long playedMicros = playTimes.append(song.id, song.duration, playedAt);
+    sessions.recordPlay(playedMicros, song.duration);
+    playStats.recordPlay(song, playedAt);
+    topPlayed.add(song);
+    songsByHour.add(song.id, playedAt);
+    artistsByDay.add(song.artist, playedAt);
+    version++;
+    if (wal) wal->logHistoryPlay(song, playedAt);
+    if (events && events->hasSubscribers()) events->publish(EngineEvent(EngineEventType::PLAYED, song.id, -1, -1, 0, playedMicros));
 }
 
 Song PlaybackHistory::undoLastPlay() {
+    MetricsTimer timer(MetricId::HISTORY_UNDO);
     if (historyStack.empty()) {
         return Song(); // Return empty song
     }
@@ -19,10 +32,76 @@ Song PlaybackHistory::undoLastPlay() {
     if (!historyVector.empty()) {
         historyVector.pop_back();
     }
+    playTimes.removeLast(lastSong.duration);
+    long long previousEnd = 0;
+    if (!historyVector.empty()) {
+        playTimes.getPlayTime(historyVector.size() - 1, previousEnd);
+        previousEnd += static_cast<long long>(historyVector.back().duration) * 1000000;
+    }
+    sessions.removeLast(lastSong.duration, previousEnd);
+    playStats.undoPlay();
+    topPlayed.remove(lastSong.id);
+    version++;
+    if (wal) wal->logHistoryUndo();
+    if (events && events->hasSubscribers()) events->publish(EngineEvent(EngineEventType::PLAY_UNDONE, lastSong.id));
     
     return lastSong;
 }
 
+void PlaybackHistory::setHeavyHitterOptions(const HeavyHitterOptions& options) {
+    topPlayed.configure(options);
+    for (const auto& song : historyVector) {
+        topPlayed.add(song);
+    }
+    version++;
+}
+
+void PlaybackHistory::setSessionGap(long long idleGapSeconds) {
+    // Compacted plays count as played at their segment's start
+    sessions = ListeningSessions(idleGapSeconds);
+    for (size_t i = 0; i < historyVector.size(); i++) {
+        long long playedMicros = 0;
+        playTimes.getPlayTime(i, playedMicros);
+        sessions.recordPlay(playedMicros, historyVector[i].duration);
+    }
+    version++;
+}
+
+size_t PlaybackHistory::compactPlaysBefore(std::chrono::system_clock::time_point cutoff) {
+    size_t folded = playTimes.compactBefore(cutoff);
+    if (folded > 0) version++;
+    return folded;
+}
+
+double PlaybackHistory::estimateDistinctSongsLastDay(std::chrono::system_clock::time_point now) const {
+    return songsByHour.estimateLast(songsByHour.getSlotCount(), now);
+}
+
+double PlaybackHistory::estimateDistinctArtistsLastWeek(std::chrono::system_clock::time_point now) const {
+    return artistsByDay.estimateLast(artistsByDay.getSlotCount(), now);
+}
+
+std::vector<std::pair<std::chrono::system_clock::time_point, Song>> PlaybackHistory::getPlaysBetween(
+    std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to) const {
+    std::vector<std::pair<std::chrono::system_clock::time_point, Song>> plays;
+    for (const auto& play : playTimes.playsBetween(from, to)) {
+        plays.push_back({fromEpochMicros(play.second.playedMicros), historyVector[play.first]});
+    }
+    return plays;
+}
+
+PlaySummary PlaybackHistory::summarizePlaysBetween(std::chrono::system_clock::time_point from,
+                                                   std::chrono::system_clock::time_point to) const {
+    return playTimes.summarizeBetween(from, to);
+}
+
+bool PlaybackHistory::getPlayTime(size_t index, std::chrono::system_clock::time_point& playedAt) const {
+    long long playedMicros = 0;
+    bool exact = playTimes.getPlayTime(index, playedMicros);
+    if (exact || index < playTimes.size()) playedAt = fromEpochMicros(playedMicros);
+    return exact;
+}
+
 void PlaybackHistory::displayHistory() const {
     if (historyVector.empty()) {
         std::cout << "No playback history available.\n";
@@ -46,4 +125,18 @@ std::vector<Song> PlaybackHistory::getRecentlyPlayed(int count) const {
     }
     
     return recent;
+} 
+
+MemoryUsage PlaybackHistory::getMemoryUsage() const {
+    // historyStack and historyVector hold separate copies of the same songs;
+    // the distinct-count sketches are a fixed size
+    MemoryUsage usage;
+    usage.items = historyVector.size();
+    usage.structureBytes = (historyStack.size() + historyVector.capacity()) * sizeof(Song) +
+                           songsByHour.getMemoryUsage().structureBytes + artistsByDay.getMemoryUsage().structureBytes +
+                           sessions.getMemoryUsage().structureBytes;
+    for (const auto& song : historyVector) {
+        usage.stringBytes += 2 * songHeapBytes(song);
+    }
+    return usage;
 } 
\ No newline at end of file
@@ -2,32 +2,93 @@
 #define PLAYBACK_HISTORY_H
 
 #include "song.h"
+#include "memory_usage.h"
+#include "event_bus.h"
+#include "play_statistics.h"
+#include "heavy_hitters.h"
+#include "hyper_log_log.h"
+#include "play_log.h"
+#include "listening_sessions.h"
+#include <chrono>
 #include <stack>
 #include <vector>
 
+class WriteAheadLog;
+
 class PlaybackHistory {
 private:
     std::stack<Song> historyStack;
     std::vector<Song> historyVector; // For display purposes
+    PlayLog playTimes;               // when each play happened, in historyVector order
+    ListeningSessions sessions;      // plays grouped by idle gap
+    PlayStatistics playStats;        // play counts, trending scores, plays per hour
+    HeavyHitterTracker topPlayed;    // fixed-memory approximate top songs
+    WindowedHyperLogLog songsByHour{3600, 24};      // distinct songs, hourly slots for a day
+    WindowedHyperLogLog artistsByDay{24 * 3600, 7};  // distinct artists, daily slots for a week
+    unsigned long long version = 0;  // bumped on every mutation
+    WriteAheadLog* wal = nullptr;    // optional mutation log, not owned
+    EventBus* events = nullptr;      // optional change stream, not owned
     
 public:
     // Constructor
     PlaybackHistory() = default;
     
     // Core operations
-    void addPlayedSong(const Song& song);
+    void addPlayedSong(const Song& song,
+                       std::chrono::system_clock::time_point playedAt = std::chrono::system_clock::now());
     Song undoLastPlay();
     
+    // Persistence
+    void setWriteAheadLog(WriteAheadLog* log) { wal = log; }
+    
+    // Change events (PLAYED, PLAY_UNDONE)
+    void setEventBus(EventBus* bus) { events = bus; }
+    
+    // Resizes the heavy-hitter tracker and refills it from the history
+    void setHeavyHitterOptions(const HeavyHitterOptions& options);
+    
     // Utility methods
     void displayHistory() const;
     std::vector<Song> getRecentlyPlayed(int count = 5) const;
+    const std::vector<Song>& getAllPlayed() const { return historyVector; } // oldest first
     int getHistorySize() const { return historyStack.size(); }
+    unsigned long long getVersion() const { return version; }
+    const PlayStatistics& statistics() const { return playStats; }
+    const HeavyHitterTracker& heavyHitters() const { return topPlayed; }
+    
+    // Time-range queries over [from, to). Plays in compacted parts of the
+    // log are only counted by summarizePlaysBetween.
+    std::vector<std::pair<std::chrono::system_clock::time_point, Song>> getPlaysBetween(
+        std::chrono::system_clock::time_point from, std::chrono::system_clock::time_point to) const;  // oldest first
+    PlaySummary summarizePlaysBetween(std::chrono::system_clock::time_point from,
+                                      std::chrono::system_clock::time_point to) const;
+    // index into getAllPlayed(); false for a compacted play (playedAt is then its segment's start) or a bad index
+    bool getPlayTime(size_t index, std::chrono::system_clock::time_point& playedAt) const;
+    size_t compactPlaysBefore(std::chrono::system_clock::time_point cutoff);
+    const PlayLog& playLog() const { return playTimes; }
+    
+    // Listening sessions: plays separated by at most the idle gap
+    const ListeningSessions& listeningSessions() const { return sessions; }
+    std::vector<ListeningSession> getRecentSessions(size_t count = 5) const { return sessions.getRecent(count); }
+    void setSessionGap(long long idleGapSeconds);  // regroups the whole history
+    
+    // HyperLogLog estimates (about 1.6% error) over rolling windows of the last
+    // 24 hours / 7 days, not calendar days; undone plays still count
+    double estimateDistinctSongsLastDay(std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;
+    double estimateDistinctArtistsLastWeek(std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;
+    MemoryUsage getMemoryUsage() const;  // history only; see statistics().getMemoryUsage()
     
     // Time complexity annotations:
-    // addPlayedSong: O(1) - stack push operation
-    // undoLastPlay: O(1) - stack pop operation
+    // addPlayedSong: O(1) - stack push plus PlayStatistics::recordPlay
+    // undoLastPlay: O(1) - stack pop plus PlayStatistics::undoPlay
+    //   (both also update the heavy-hitter tracker in O(d + log t))
+    // setHeavyHitterOptions: O(n (d + log t)) - replays the history
+    // setSessionGap: O(n log s) - regroups every play, s log segments
+    // estimateDistinctSongsLastDay / estimateDistinctArtistsLastWeek: O(s * m) - s slots of m registers
+    // getPlaysBetween / summarizePlaysBetween / getPlayTime: see PlayLog
     // displayHistory: O(n) - needs to traverse all history
     // getRecentlyPlayed: O(n) - needs to copy recent songs
+    // getMemoryUsage: O(n) - walks the history
 };
 
 #endif // PLAYBACK_HISTORY_H 
\ No newline at end of file
@@ -1,10 +1,16 @@
 #include "playlist_engine.h"
+#include "metrics_registry.h"
+#include "write_ahead_log.h"
 #include <iostream>
 #include <algorithm>
 #include <random>
 #include <unordered_map>
+#include <cstdlib>
 
-PlaylistEngine::PlaylistEngine() : head(nullptr), tail(nullptr), size(0) {
+PlaylistEngine::PlaylistEngine()
+    : head(nullptr), tail(nullptr), size(0), version(0), wal(nullptr), totalDuration(0), events(nullptr),
+      cursorNode(nullptr), cursorIndex(0), cursorVersion(0), playingNode(nullptr), playingIndex(-1), lookAhead(3),
+      upNextVersion(0) {
 }
 
 PlaylistEngine::~PlaylistEngine() {
@@ -20,6 +26,10 @@ void PlaylistEngine::clearList() {
     }
     head = tail = nullptr;
     size = 0;
+    totalDuration = 0;
+    cursorNode = nullptr;
+    playingNode = nullptr;
+    playingIndex = -1;
 }
 
 PlaylistNode* PlaylistEngine::getNodeAt(int index) const {
@@ -56,11 +66,22 @@ void PlaylistEngine::insertNodeAt(PlaylistNode* node, int index) {
         current->prev = node;
     }
     size++;
+    totalDuration += node->song.duration;
+    cursorNode = nullptr;
+    if (playingNode && index <= playingIndex) playingIndex++;
 }
 
-void PlaylistEngine::removeNode(PlaylistNode* node) {
+void PlaylistEngine::unlinkNode(PlaylistNode* node, int index) {
     if (!node) return;
     
+    if (node == playingNode) {
+        // Step back so playNext() still continues with the following song
+        playingNode = node->prev;
+        playingIndex--;
+    } else if (playingNode && index < playingIndex) {
+        playingIndex--;
+    }
+    
     if (node->prev) {
         node->prev->next = node->next;
     } else {
@@ -73,22 +94,67 @@ void PlaylistEngine::removeNode(PlaylistNode* node) {
         tail = node->prev;
     }
     
-    delete node;
+    node->prev = nullptr;
+    node->next = nullptr;
     size--;
+    totalDuration -= node->song.duration;
+    cursorNode = nullptr;
+}
+
+void PlaylistEngine::removeNode(PlaylistNode* node, int index) {
+    if (!node) return;
+    
+    unlinkNode(node, index);
+    delete node;
 }
 
 void PlaylistEngine::addSong(const std::string& title, const std::string& artist, int duration) {
-    Song song(title, artist, duration);
+    addSong(Song(title, artist, duration));
+}
+
+void PlaylistEngine::addSong(const Song& song) {
+    MetricsTimer timer(MetricId::PLAYLIST_ADD);
     PlaylistNode* newNode = new PlaylistNode(song);
     
     // Add to end of list
     insertNodeAt(newNode, size);
+    version++;
     
     // Record action for undo
-    undoStack.push(PlaylistAction(ActionType::ADD, song, size - 1));
+    undoStack.push_back(PlaylistAction(ActionType::ADD, song, size - 1));
+    if (wal) wal->logPlaylistAdd(song);
+    if (publishing()) events->publish(EngineEvent(EngineEventType::SONG_ADDED, song.id, size - 1));
+}
+
+void PlaylistEngine::addSongs(const std::vector<Song>& songs) {
+    // Bulk loads (e.g. catalog imports) append directly and are not recorded
+    // for undo; undoing a million-row import one song at a time is useless
+    int first = size;
+    for (const auto& song : songs) {
+        PlaylistNode* newNode = new PlaylistNode(song);
+        newNode->prev = tail;
+        if (tail) {
+            tail->next = newNode;
+        } else {
+            head = newNode;
+        }
+        tail = newNode;
+        size++;
+        totalDuration += song.duration;
+    }
+    version++;
+    if (wal) wal->logPlaylistAppend(songs);
+    
+    if (publishing()) {
+        EventBatch batch(events);
+        for (size_t i = 0; i < songs.size(); i++) {
+            events->publish(EngineEvent(EngineEventType::SONG_ADDED, songs[i].id, first + static_cast<int>(i)));
+        }
+    }
 }
 
 void PlaylistEngine::deleteSong(int index) {
+    MetricsTimer timer(MetricId::PLAYLIST_DELETE);
     if (index < 0 || index >= size) {
         std::cout << "Invalid index for deletion!\n";
         return;
@@ -98,12 +164,45 @@ void PlaylistEngine::deleteSong(int index) {
     if (!nodeToDelete) return;
     
     // Record action for undo
-    undoStack.push(PlaylistAction(ActionType::DELETE, nodeToDelete->song, index));
+    undoStack.push_back(PlaylistAction(ActionType::DELETE, nodeToDelete->song, index));
+    int songId = nodeToDelete->song.id;
     
-    removeNode(nodeToDelete);
+    removeNode(nodeToDelete, index);
+    version++;
+    if (wal) wal->logPlaylistDelete(index);
+    if (publishing()) events->publish(EngineEvent(EngineEventType::SONG_REMOVED, songId, index));
+}
+
+int PlaylistEngine::deleteSongsById(const std::unordered_set<int>& songIds) {
+    MetricsTimer timer(MetricId::PLAYLIST_DELETE);
+    if (songIds.empty()) return 0;
+    
+    // Same undo records, log records and events as calling deleteSong at each
+    // song's current position, front to back, but in a single pass
+    EventBatch batch(publishing() ? events : nullptr);
+    int removed = 0;
+    int index = 0;
+    PlaylistNode* current = head;
+    while (current) {
+        PlaylistNode* next = current->next;
+        if (songIds.count(current->song.id)) {
+            undoStack.push_back(PlaylistAction(ActionType::DELETE, current->song, index));
+            int songId = current->song.id;
+            removeNode(current, index);
+            if (wal) wal->logPlaylistDelete(index);
+            if (publishing()) events->publish(EngineEvent(EngineEventType::SONG_REMOVED, songId, index));
+            removed++;
+        } else {
+            index++;
+        }
+        current = next;
+    }
+    if (removed > 0) version++;
+    return removed;
 }
 
 void PlaylistEngine::moveSong(int fromIndex, int toIndex) {
+    MetricsTimer timer(MetricId::PLAYLIST_MOVE);
     if (fromIndex < 0 || fromIndex >= size || toIndex < 0 || toIndex >= size) {
         std::cout << "Invalid indices for move operation!\n";
         return;
@@ -115,16 +214,27 @@ void PlaylistEngine::moveSong(int fromIndex, int toIndex) {
     if (!nodeToMove) return;
     
     // Record action for undo
-    undoStack.push(PlaylistAction(ActionType::MOVE, nodeToMove->song, fromIndex, toIndex));
+    undoStack.push_back(PlaylistAction(ActionType::MOVE, nodeToMove->song, fromIndex, toIndex));
     
-    // Remove from current position
-    removeNode(nodeToMove);
+    // Detach from current position (the node is reused, not freed)
+    bool wasPlaying = nodeToMove == playingNode;
+    unlinkNode(nodeToMove, fromIndex);
     
     // Insert at new position
     insertNodeAt(nodeToMove, toIndex);
+    if (wasPlaying) {
+        playingNode = nodeToMove;
+        playingIndex = toIndex;
+    }
+    version++;
+    if (wal) wal->logPlaylistMove(fromIndex, toIndex);
+    if (publishing()) {
+        events->publish(EngineEvent(EngineEventType::SONG_MOVED, nodeToMove->song.id, fromIndex, toIndex));
+    }
 }
 
 void PlaylistEngine::reversePlaylist() {
+    MetricsTimer timer(MetricId::PLAYLIST_REVERSE);
     if (size <= 1) return;
     
     PlaylistNode* current = head;
@@ -142,16 +252,28 @@ void PlaylistEngine::reversePlaylist() {
     temp = head;
     head = tail;
     tail = temp;
+    cursorNode = nullptr;
+    if (playingNode) playingIndex = size - 1 - playingIndex;
+    version++;
+    if (wal) wal->logPlaylistReverse();
+    if (publishing()) events->publish(EngineEvent(EngineEventType::REVERSED));
 }
 
 void PlaylistEngine::undoLastNEdits(int n) {
+    MetricsTimer timer(MetricId::PLAYLIST_UNDO);
     int undoCount = std::min(n, static_cast<int>(undoStack.size()));
     
+    // Log the undo itself; the edits it performs are replayed by re-running it
+    if (wal) wal->logPlaylistUndo(n);
+    WriteAheadLog* log = wal;
+    wal = nullptr;
+    EventBatch batch(events);  // subscribers see the whole undo at once
+    
     for (int i = 0; i < undoCount; i++) {
         if (undoStack.empty()) break;
         
-        PlaylistAction action = undoStack.top();
-        undoStack.pop();
+        PlaylistAction action = undoStack.back();
+        undoStack.pop_back();
         
         switch (action.type) {
             case ActionType::ADD:
@@ -163,6 +285,10 @@ void PlaylistEngine::undoLastNEdits(int n) {
                 {
                     PlaylistNode* newNode = new PlaylistNode(action.song);
                     insertNodeAt(newNode, action.index1);
+                    version++;
+                    if (publishing()) {
+                        events->publish(EngineEvent(EngineEventType::SONG_ADDED, action.song.id, action.index1));
+                    }
                 }
                 break;
             case ActionType::MOVE:
@@ -171,14 +297,175 @@ void PlaylistEngine::undoLastNEdits(int n) {
                 break;
         }
     }
+    
+    wal = log;
+}
+
+PlaylistNode* PlaylistEngine::seekNode(int index) const {
+    if (index < 0 || index >= size) return nullptr;
+    if (cursorVersion != version) {
+        cursorNode = nullptr;
+        cursorVersion = version;
+    }
+    
+    // Start from whichever of head, tail and the cursor is closest
+    PlaylistNode* current = head;
+    int position = 0;
+    if (size - 1 - index < index) {
+        current = tail;
+        position = size - 1;
+    }
+    if (cursorNode && std::abs(cursorIndex - index) < std::abs(position - index)) {
+        current = cursorNode;
+        position = cursorIndex;
+    }
+    
+    while (position < index) {
+        current = current->next;
+        position++;
+    }
+    while (position > index) {
+        current = current->prev;
+        position--;
+    }
+    
+    cursorNode = current;
+    cursorIndex = index;
+    return current;
+}
+
+const Song* PlaylistEngine::getSongAt(int index) const {
+    PlaylistNode* node = seekNode(index);
+    return node ? &node->song : nullptr;
+}
+
+void PlaylistEngine::fillUpNext() const {
+    upNextNodes.clear();
+    for (const PlaylistNode* node = playingNode ? playingNode->next : head;
+         node && upNextNodes.size() < lookAhead; node = node->next) {
+        upNextNodes.push_back(node);
+    }
+    upNextVersion = version;
+}
+
+const Song* PlaylistEngine::startPlayback(int index) {
+    PlaylistNode* node = seekNode(index);
+    if (!node) return nullptr;
+    
+    playingNode = node;
+    playingIndex = index;
+    fillUpNext();
+    return &node->song;
+}
+
+const Song* PlaylistEngine::playNext() {
+    PlaylistNode* next = playingNode ? playingNode->next : head;
+    if (!next) return nullptr;
+    if (upNextVersion != version) fillUpNext();
+    
+    playingNode = next;
+    playingIndex++;
+    // The queue moves up by one; only the song entering at the back is new
+    if (!upNextNodes.empty()) upNextNodes.pop_front();
+    const PlaylistNode* last = upNextNodes.empty() ? playingNode : upNextNodes.back();
+    if (last->next && upNextNodes.size() < lookAhead) upNextNodes.push_back(last->next);
+    return &playingNode->song;
+}
+
+const Song* PlaylistEngine::playPrevious() {
+    if (!playingNode || !playingNode->prev) return nullptr;
+    if (upNextVersion != version) fillUpNext();
+    
+    if (lookAhead > 0) {
+        upNextNodes.push_front(playingNode);
+        if (upNextNodes.size() > lookAhead) upNextNodes.pop_back();
+    }
+    playingNode = playingNode->prev;
+    playingIndex--;
+    return &playingNode->song;
+}
+
+void PlaylistEngine::stopPlayback() {
+    playingNode = nullptr;
+    playingIndex = -1;
+    fillUpNext();
+}
+
+std::vector<Song> PlaylistEngine::getUpNext() const {
+    if (upNextVersion != version) fillUpNext();
+    std::vector<Song> songs;
+    songs.reserve(upNextNodes.size());
+    for (const PlaylistNode* node : upNextNodes) {
+        songs.push_back(node->song);
+    }
+    return songs;
+}
+
+void PlaylistEngine::setLookAhead(size_t count) {
+    lookAhead = count;
+    fillUpNext();
+}
+
+int PlaylistEngine::indexOf(int songId) const {
+    int index = 0;
+    for (PlaylistNode* current = head; current; current = current->next, index++) {
+        if (current->song.id == songId) return index;
+    }
+    return -1;
+}
+
+std::vector<PlaylistAction> PlaylistEngine::getUndoLog() const {
+    return undoStack;
+}
+
+std::vector<PlaylistAction> PlaylistEngine::getLastActions(int n) const {
+    size_t count = n > 0 ? std::min(static_cast<size_t>(n), undoStack.size()) : 0;
+    return std::vector<PlaylistAction>(undoStack.end() - count, undoStack.end());
+}
+
+void PlaylistEngine::restoreUndoLog(const std::vector<PlaylistAction>& actions) {
+    for (const auto& action : actions) {
+        undoStack.push_back(action);
+    }
+    version++;
+}
+
+MemoryUsage PlaylistEngine::getMemoryUsage() const {
+    MemoryUsage usage;
+    for (PlaylistNode* node = head; node; node = node->next) {
+        usage.items++;
+        usage.stringBytes += songHeapBytes(node->song);
+    }
+    usage.structureBytes = usage.items * sizeof(PlaylistNode);
+    return usage;
+}
+
+MemoryUsage PlaylistEngine::getUndoMemoryUsage() const {
+    MemoryUsage usage;
+    usage.items = undoStack.size();
+    usage.structureBytes = undoStack.capacity() * sizeof(PlaylistAction);
+    for (const auto& action : undoStack) {
+        usage.stringBytes += songHeapBytes(action.song);
+    }
+    return usage;
 }
 
 void PlaylistEngine::shuffleWithConstraints() {
+    // Draw the seed here so the shuffle can be logged and replayed exactly
+    std::random_device rd;
+    shuffleWithConstraints(rd());
+}
+
+void PlaylistEngine::shuffleWithConstraints(unsigned int seed) {
+    MetricsTimer timer(MetricId::PLAYLIST_SHUFFLE);
     if (size <= 1) return;
     
-    std::vector<Song> songs = getSongs();
-    std::random_device rd;
-    std::mt19937 gen(rd());
+    if (wal) wal->logPlaylistShuffle(seed);
+    replaceOrder(shuffledOrder(getSongs(), seed));
+}
+
+std::vector<Song> PlaylistEngine::shuffledOrder(std::vector<Song> songs, unsigned int seed) {
+    std::mt19937 gen(seed);
     
     bool validShuffle = false;
     int maxAttempts = 100; // Prevent infinite loop
@@ -197,13 +484,35 @@ void PlaylistEngine::shuffleWithConstraints() {
         }
         attempts++;
     }
+    return songs;
+}
+
+bool PlaylistEngine::applyShuffle(unsigned int seed, const std::vector<Song>& order, unsigned long long basedOnVersion) {
+    MetricsTimer timer(MetricId::PLAYLIST_SHUFFLE);
+    // The playlist changed while the order was being computed
+    if (basedOnVersion != version) return false;
+    if (size <= 1) return true;
     
-    // Rebuild playlist with shuffled songs
+    if (wal) wal->logPlaylistShuffle(seed);
+    replaceOrder(order);
+    return true;
+}
+
+void PlaylistEngine::replaceOrder(const std::vector<Song>& songs) {
+    // Rebuild playlist with shuffled songs; playback stays on the same song
+    bool wasPlaying = playingNode != nullptr;
+    int playingId = wasPlaying ? playingNode->song.id : 0;
     clearList();
     for (const auto& song : songs) {
         PlaylistNode* newNode = new PlaylistNode(song);
         insertNodeAt(newNode, size);
+        if (wasPlaying && !playingNode && song.id == playingId) {
+            playingNode = newNode;
+            playingIndex = size - 1;
+        }
     }
+    version++;
+    if (publishing()) events->publish(EngineEvent(EngineEventType::SHUFFLED));
 }
 
 void PlaylistEngine::displayPlaylist() const {
@@ -2,9 +2,14 @@
 #define PLAYLIST_ENGINE_H
 
 #include "song.h"
+#include "memory_usage.h"
+#include "event_bus.h"
 #include <vector>
-#include <stack>
+#include <deque>
 #include <string>
+#include <unordered_set>
+
+class WriteAheadLog;
 
 // Node structure for doubly linked list
 struct PlaylistNode {
@@ -38,13 +43,37 @@ private:
     PlaylistNode* head;
     PlaylistNode* tail;
     int size;
-    std::stack<PlaylistAction> undoStack;
+    std::vector<PlaylistAction> undoStack; // newest last
+    unsigned long long version; // bumped on every mutation
+    WriteAheadLog* wal;          // optional mutation log, not owned
+    long long totalDuration;     // sum of song durations, kept up to date by the helpers
+    EventBus* events;            // optional change stream, not owned
+    
+    // Last node reached by getSongAt, so sequential row access is O(1)
+    mutable PlaylistNode* cursorNode;
+    mutable int cursorIndex;
+    mutable unsigned long long cursorVersion;
+    
+    // Now-playing cursor. It stays on its node across edits; null means
+    // "before the first song", so the next song is the head. The next
+    // lookAhead nodes are resolved ahead of time and reused while the
+    // playlist is unchanged.
+    PlaylistNode* playingNode;
+    int playingIndex;            // -1 when playingNode is null
+    size_t lookAhead;
+    mutable std::deque<const PlaylistNode*> upNextNodes;
+    mutable unsigned long long upNextVersion;
     
     // Helper methods
     PlaylistNode* getNodeAt(int index) const;
+    PlaylistNode* seekNode(int index) const;  // walks from the head, tail or last accessed row
     void insertNodeAt(PlaylistNode* node, int index);
-    void removeNode(PlaylistNode* node);
+    void unlinkNode(PlaylistNode* node, int index);
+    void removeNode(PlaylistNode* node, int index);
     void clearList();
+    void replaceOrder(const std::vector<Song>& songs);
+    void fillUpNext() const;
+    bool publishing() const { return events && events->hasSubscribers(); }
     
 public:
     // Constructor and destructor
@@ -53,28 +82,81 @@ public:
     
     // Core playlist operations
     void addSong(const std::string& title, const std::string& artist, int duration);
+    void addSong(const Song& song);
+    void addSongs(const std::vector<Song>& songs);
     void deleteSong(int index);
+    int deleteSongsById(const std::unordered_set<int>& songIds); // every entry of these songs; returns count
     void moveSong(int fromIndex, int toIndex);
     void reversePlaylist();
     
     // Undo functionality
     void undoLastNEdits(int n);
+    std::vector<PlaylistAction> getUndoLog() const;
+    std::vector<PlaylistAction> getLastActions(int n) const;  // the n that undoLastNEdits(n) reverts
+    void restoreUndoLog(const std::vector<PlaylistAction>& actions);
     
     // Shuffle with constraints
     void shuffleWithConstraints();
+    void shuffleWithConstraints(unsigned int seed);
+    
+    // Split shuffle for callers that compute the order off the UI thread:
+    // shuffledOrder(getSongs(), seed) can run anywhere, and applyShuffle
+    // installs it only if the playlist is still at basedOnVersion. The WAL
+    // records just the seed, so order must come from shuffledOrder.
+    static std::vector<Song> shuffledOrder(std::vector<Song> songs, unsigned int seed);
+    bool applyShuffle(unsigned int seed, const std::vector<Song>& order, unsigned long long basedOnVersion);
+    
+    // Now playing. Moving to the next or previous song is O(1) and never
+    // walks the list; the look-ahead queue holds the songs that follow.
+    // Edits keep the cursor on the same song; if that song is deleted the
+    // cursor steps back, so the next song is still the one that followed it.
+    const Song* startPlayback(int index);  // nullptr when out of range (playback unchanged)
+    const Song* playNext();                // nullptr at the end (cursor stays on the last song)
+    const Song* playPrevious();            // nullptr at the start
+    void stopPlayback();
+    const Song* getNowPlaying() const { return playingNode ? &playingNode->song : nullptr; }
+    int getNowPlayingIndex() const { return playingIndex; }
+    std::vector<Song> getUpNext() const;   // the next getLookAhead() songs, soonest first
+    void setLookAhead(size_t count);
+    size_t getLookAhead() const { return lookAhead; }
+    
+    // Persistence
+    void setWriteAheadLog(WriteAheadLog* log) { wal = log; }
+    
+    // Change events (SONG_ADDED, SONG_REMOVED, SONG_MOVED, REVERSED, SHUFFLED)
+    void setEventBus(EventBus* bus) { events = bus; }
     
     // Utility methods
     void displayPlaylist() const;
     std::vector<Song> getSongs() const;
+    const Song* getSongAt(int index) const;  // nullptr when out of range; valid until the next edit
+    int indexOf(int songId) const;           // first position of the song, or -1
     int getSize() const { return size; }
+    long long getTotalDuration() const { return totalDuration; }
+    unsigned long long getVersion() const { return version; }
+    
+    // Memory accounting
+    MemoryUsage getMemoryUsage() const;      // list nodes and their songs
+    MemoryUsage getUndoMemoryUsage() const;  // undo log (grows with every edit)
     
     // Time complexity annotations:
     // addSong: O(1) - adds to end
+    // addSongs: O(k) - appends k songs in one pass
     // deleteSong: O(n) - needs to traverse to index
+    // deleteSongsById: O(n) - one pass for any number of songs
     // moveSong: O(n) - needs to traverse to both indices
     // reversePlaylist: O(n) - needs to traverse entire list
     // undoLastNEdits: O(n*m) where n is number of undos, m is average operation cost
+    // indexOf: O(n) - linear scan
+    // getSongAt: O(d) - d is the distance from the head, tail or last accessed row
+    // startPlayback: O(d + q) - q = look-ahead songs resolved
+    // playNext / playPrevious: O(1) (O(q) refill after an edit)
+    // getUpNext: O(q) - copies the queued songs
+    // getUndoLog / restoreUndoLog: O(u) - copies the u recorded actions
+    // getLastActions: O(n) - copies only the newest n actions
     // shuffleWithConstraints: O(n^2) - may need multiple passes
+    // shuffledOrder: O(a * n) - a attempts (at most 100); applyShuffle: O(n) rebuild
+    // getMemoryUsage / getUndoMemoryUsage: O(n) / O(u) - walks the nodes / actions
 };
 
 #endif // PLAYLIST_ENGINE_H 
\ No newline at end of file
@@ -0,0 +1,99 @@
+#include "playlist_model.h"
+
+PlaylistModel::PlaylistModel(PlaylistEngine* playlistEngine, EventBus* eventBus, QObject* parent)
+    : QAbstractListModel(parent), engine(playlistEngine), bus(eventBus), subscription(0),
+      rows(playlistEngine->getSize()) {
+    subscription = bus->subscribe([this](const std::vector<EngineEvent>& events) { applyEvents(events); });
+}
+
+PlaylistModel::~PlaylistModel() {
+    if (bus) bus->unsubscribe(subscription);
+}
+
+void PlaylistModel::detach() {
+    if (!bus) return;
+    
+    bus->unsubscribe(subscription);
+    bus = nullptr;
+    engine = nullptr;
+    resetRows();
+}
+
+int PlaylistModel::rowCount(const QModelIndex& parent) const {
+    return parent.isValid() ? 0 : rows;
+}
+
+QVariant PlaylistModel::data(const QModelIndex& index, int role) const {
+    if (!engine || !index.isValid() || role != Qt::DisplayRole) {
+        return QVariant();
+    }
+    
+    const Song* song = engine->getSongAt(index.row());
+    if (!song) return QVariant();
+    
+    return QString::fromStdString(song->title) + " - " + QString::fromStdString(song->artist) +
+           " (" + QString::fromStdString(song->getFormattedDuration()) + ")";
+}
+
+void PlaylistModel::applyEvents(const std::vector<EngineEvent>& events) {
+    // Events arrive after the engine changed; rows still holds the old count
+    // between begin* and end*, which is all the view reads in between
+    size_t i = 0;
+    while (i < events.size()) {
+        const EngineEvent& event = events[i];
+        switch (event.type) {
+            case EngineEventType::SONG_ADDED: {
+                // A bulk append arrives as consecutive SONG_ADDED events
+                size_t end = i + 1;
+                while (end < events.size() && events[end].type == EngineEventType::SONG_ADDED &&
+                       events[end].index == events[end - 1].index + 1) {
+                    end++;
+                }
+                insertRange(event.index, event.index + static_cast<int>(end - i) - 1);
+                i = end;
+                continue;
+            }
+            case EngineEventType::SONG_REMOVED:
+                removeRow(event.index);
+                break;
+            case EngineEventType::SONG_MOVED:
+                moveRow(event.index, event.toIndex);
+                break;
+            case EngineEventType::REVERSED:
+            case EngineEventType::SHUFFLED:
+                resetRows();
+                break;
+            default:
+                break;  // history and rating events do not change rows
+        }
+        i++;
+    }
+}
+
+void PlaylistModel::insertRange(int first, int last) {
+    beginInsertRows(QModelIndex(), first, last);
+    rows += last - first + 1;
+    endInsertRows();
+}
+
+void PlaylistModel::removeRow(int row) {
+    beginRemoveRows(QModelIndex(), row, row);
+    rows--;
+    endRemoveRows();
+}
+
+void PlaylistModel::moveRow(int from, int to) {
+    // Qt's destination is the row the song is inserted before, in old positions
+    int destination = to > from ? to + 1 : to;
+    if (beginMoveRows(QModelIndex(), from, from, QModelIndex(), destination)) {
+        endMoveRows();
+    } else {
+        resetRows();
+    }
+}
+
+void PlaylistModel::resetRows() {
+    beginResetModel();
+    rows = engine ? engine->getSize() : 0;
+    endResetModel();
+}
@@ -0,0 +1,47 @@
+#ifndef PLAYLIST_MODEL_H
+#define PLAYLIST_MODEL_H
+
+#include "playlist_engine.h"
+#include "event_bus.h"
+#include <QAbstractListModel>
+#include <vector>
+
+// List model over a PlaylistEngine for QListView. Rows are formatted only
+// when the view asks for them (i.e. the visible ones), and every engine
+// edit arrives as a row insert/remove/move instead of a full rebuild, so
+// one edit costs O(1) UI work regardless of playlist size.
+//
+// The model follows the engine through its EventBus; call detach() before
+// the engine or the bus is destroyed.
+class PlaylistModel : public QAbstractListModel {
+    Q_OBJECT
+
+private:
+    PlaylistEngine* engine;
+    EventBus* bus;
+    int subscription;
+    int rows;  // row count the view has been told about
+    
+    void applyEvents(const std::vector<EngineEvent>& events);
+    void insertRange(int first, int last);
+    void removeRow(int row);
+    void moveRow(int from, int to);
+    void resetRows();
+    
+public:
+    PlaylistModel(PlaylistEngine* playlistEngine, EventBus* eventBus, QObject* parent = nullptr);
+    ~PlaylistModel() override;
+    
+    void detach();
+    
+    // QAbstractListModel
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    
+    // Time complexity annotations:
+    // data: O(1) for neighbouring rows - the engine keeps a cursor at the last row read
+    // applyEvents: O(e) - e events; consecutive appends become one insert
+    // resetRows: O(1) - the view re-reads only its visible rows
+};
+
+#endif // PLAYLIST_MODEL_H
@@ -1,127 +1,487 @@
 #include "playlist_sorter.h"
+#include "metrics_registry.h"
+#include "song_rating_tree.h"
 #include <iostream>
 #include <chrono>
+#include <cstring>
+#include <thread>
 
-void PlaylistSorter::mergeSort(std::vector<Song>& songs, int left, int right) {
-    if (left < right) {
-        int mid = left + (right - left) / 2;
-        mergeSort(songs, left, mid);
-        mergeSort(songs, mid + 1, right);
-        merge(songs, left, mid, right);
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+long long microsecondsSince(Clock::time_point start) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count();
+}
+
+// Work counters of the current thread. Plain increments keep them cheap on
+// the comparison path; sort calls read the difference.
+thread_local unsigned long long threadComparisons = 0;
+thread_local unsigned long long threadMoves = 0;
+
+// Integers are stored big-endian with the sign bit flipped, so memcmp
+// orders them like signed comparison
+void packInt32(unsigned char* out, int32_t value) {
+    uint32_t bits = static_cast<uint32_t>(value) ^ 0x80000000u;
+    for (int i = 3; i >= 0; i--) {
+        out[i] = static_cast<unsigned char>(bits & 0xFF);
+        bits >>= 8;
     }
 }
 
-void PlaylistSorter::merge(std::vector<Song>& songs, int left, int mid, int right) {
-    int n1 = mid - left + 1;
-    int n2 = right - mid;
+void packInt64(unsigned char* out, int64_t value) {
+    uint64_t bits = static_cast<uint64_t>(value) ^ 0x8000000000000000ull;
+    for (int i = 7; i >= 0; i--) {
+        out[i] = static_cast<unsigned char>(bits & 0xFF);
+        bits >>= 8;
+    }
+}
+
+bool isTextField(SortField field) {
+    return field == SortField::TITLE || field == SortField::ARTIST;
+}
+
+} // namespace
+
+size_t PlaylistSorter::fieldWidth(SortField field) {
+    switch (field) {
+        case SortField::TITLE:
+        case SortField::ARTIST:
+            return kTextPrefixBytes;
+        case SortField::ADDED_TIME:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+bool PlaylistSorter::packRows(const std::vector<Song>& songs, const std::vector<SortKey>& keys,
+                              PackedKeys& packed, size_t begin, size_t end) const {
+    bool truncated = false;
+    for (size_t i = begin; i < end; i++) {
+        const Song& song = songs[i];
+        unsigned char* out = packed.bytes.data() + i * packed.rowWidth;
+        
+        for (size_t k = 0; k < keys.size(); k++) {
+            const SortKey& key = keys[k];
+            size_t width = fieldWidth(key.field);
+            
+            switch (key.field) {
+                case SortField::TITLE:
+                case SortField::ARTIST: {
+                    // Zero padding sorts a prefix before its extensions;
+                    // normalized text never contains NUL bytes
+                    std::string text = normalizer.normalize(key.field == SortField::TITLE ? song.title : song.artist);
+                    size_t length = std::min(text.size(), width);
+                    std::memcpy(out, text.data(), length);
+                    if (text.size() > width) {
+                        truncated = true;
+                    }
+                    packed.texts[k][i] = std::move(text);
+                    break;
+                }
+                case SortField::DURATION:
+                    packInt32(out, song.duration);
+                    break;
+                case SortField::ADDED_TIME:
+                    packInt64(out, toEpochMicros(song.addedTime));
+                    break;
+                case SortField::RATING: {
+                    auto it = ratingsById.find(song.id);
+                    packInt32(out, it == ratingsById.end() ? 0 : it->second);
+                    break;
+                }
+                case SortField::ID:
+                    packInt32(out, song.id);
+                    break;
+            }
+            
+            if (!key.ascending) {
+                for (size_t b = 0; b < width; b++) {
+                    out[b] = static_cast<unsigned char>(~out[b]);
+                }
+            }
+            out += width;
+        }
+    }
+    return truncated;
+}
+
+PlaylistSorter::PackedKeys PlaylistSorter::packKeys(const std::vector<Song>& songs,
+                                                    const std::vector<SortKey>& keys, unsigned int threads) {
+    auto start = Clock::now();
+    PackedKeys packed;
+    packed.texts.resize(keys.size());
+    for (size_t k = 0; k < keys.size(); k++) {
+        packed.rowWidth += fieldWidth(keys[k].field);
+        if (isTextField(keys[k].field)) {
+            packed.texts[k].resize(songs.size());
+            packed.textEnds.push_back(packed.rowWidth);
+        }
+    }
+    packed.bytes.assign(songs.size() * packed.rowWidth, 0);
+    noteAllocation(packed.bytes.size());
+    for (const auto& texts : packed.texts) {
+        if (!texts.empty()) noteAllocation(texts.size() * sizeof(std::string));
+    }
     
-    std::vector<Song> leftArray(n1);
-    std::vector<Song> rightArray(n2);
+    if (threads <= 1) {
+        packed.truncated = packRows(songs, keys, packed, 0, songs.size());
+        lastMetrics.packMicroseconds = microsecondsSince(start);
+        return packed;
+    }
+    
+    // Rows are independent, so each thread packs its own slice
+    std::vector<char> truncated(threads, 0);
+    std::vector<std::thread> workers;
+    for (unsigned int t = 0; t < threads; t++) {
+        size_t begin = songs.size() * t / threads;
+        size_t end = songs.size() * (t + 1) / threads;
+        workers.emplace_back([&, t, begin, end] {
+            truncated[t] = packRows(songs, keys, packed, begin, end);
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    packed.truncated = std::find(truncated.begin(), truncated.end(), 1) != truncated.end();
+    lastMetrics.packMicroseconds = microsecondsSince(start);
+    return packed;
+}
+
+int PlaylistSorter::compareRows(const PackedKeys& packed, const std::vector<SortKey>& keys, uint32_t a, uint32_t b) {
+    threadComparisons++;
+    const unsigned char* rowA = packed.row(a);
+    const unsigned char* rowB = packed.row(b);
+    if (!packed.truncated) {
+        return std::memcmp(rowA, rowB, packed.rowWidth);
+    }
     
-    // Copy data to temporary arrays
-    for (int i = 0; i < n1; i++) {
-        leftArray[i] = songs[left + i];
+    // A text prefix can be equal while the full texts differ, and that must
+    // be decided before any later key is looked at
+    size_t start = 0;
+    size_t textIndex = 0;
+    for (size_t k = 0; k < keys.size(); k++) {
+        if (!isTextField(keys[k].field)) continue;
+        size_t end = packed.textEnds[textIndex++];
+        int order = std::memcmp(rowA + start, rowB + start, end - start);
+        if (order != 0) {
+            return order;
+        }
+        int textOrder = packed.texts[k][a].compare(packed.texts[k][b]);
+        if (textOrder != 0) {
+            return keys[k].ascending ? textOrder : -textOrder;
+        }
+        start = end;
     }
-    for (int j = 0; j < n2; j++) {
-        rightArray[j] = songs[mid + 1 + j];
+    return std::memcmp(rowA + start, rowB + start, packed.rowWidth - start);
+}
+
+bool PlaylistSorter::lessThan(const PackedKeys& packed, const std::vector<SortKey>& keys, uint32_t a, uint32_t b) {
+    return compareRows(packed, keys, a, b) < 0;
+}
+
+bool PlaylistSorter::rankedBefore(const PackedKeys& packed, const std::vector<SortKey>& keys, uint32_t a, uint32_t b) {
+    int order = compareRows(packed, keys, a, b);
+    return order < 0 || (order == 0 && a < b);
+}
+
+void PlaylistSorter::mergeSort(std::vector<uint32_t>& order, std::vector<uint32_t>& buffer, size_t left, size_t right,
+                               const PackedKeys& packed, const std::vector<SortKey>& keys) {
+    if (left < right) {
+        size_t mid = left + (right - left) / 2;
+        mergeSort(order, buffer, left, mid, packed, keys);
+        mergeSort(order, buffer, mid + 1, right, packed, keys);
+        merge(order, buffer, left, mid, right, packed, keys);
+    }
+}
+
+void PlaylistSorter::merge(std::vector<uint32_t>& order, std::vector<uint32_t>& buffer, size_t left, size_t mid, size_t right,
+                           const PackedKeys& packed, const std::vector<SortKey>& keys) {
+    // Already in order: nothing to merge
+    if (!lessThan(packed, keys, order[mid + 1], order[mid])) {
+        return;
     }
     
-    // Merge the temporary arrays back
-    int i = 0, j = 0, k = left;
-    while (i < n1 && j < n2) {
-        if (leftArray[i].title <= rightArray[j].title) {
-            songs[k] = leftArray[i];
-            i++;
+    std::copy(order.begin() + left, order.begin() + right + 1, buffer.begin() + left);
+    threadMoves += 2 * (right - left + 1);
+    
+    // Take from the left run on ties to keep the sort stable
+    size_t i = left, j = mid + 1, k = left;
+    while (i <= mid && j <= right) {
+        if (!lessThan(packed, keys, buffer[j], buffer[i])) {
+            order[k++] = buffer[i++];
         } else {
-            songs[k] = rightArray[j];
-            j++;
+            order[k++] = buffer[j++];
         }
-        k++;
     }
     
     // Copy remaining elements
-    while (i < n1) {
-        songs[k] = leftArray[i];
-        i++;
-        k++;
+    while (i <= mid) {
+        order[k++] = buffer[i++];
     }
-    while (j < n2) {
-        songs[k] = rightArray[j];
-        j++;
-        k++;
+    while (j <= right) {
+        order[k++] = buffer[j++];
     }
 }
 
-void PlaylistSorter::quickSort(std::vector<Song>& songs, int low, int high) {
-    if (low < high) {
-        int pi = partition(songs, low, high);
-        quickSort(songs, low, pi - 1);
-        quickSort(songs, pi + 1, high);
+void PlaylistSorter::parallelMergeSort(std::vector<uint32_t>& order, std::vector<uint32_t>& buffer,
+                                       size_t left, size_t right, unsigned int threads,
+                                       const PackedKeys& packed, const std::vector<SortKey>& keys) {
+    if (threads <= 1 || right - left + 1 < parallelThreshold) {
+        mergeSort(order, buffer, left, right, packed, keys);
+        return;
     }
-}
-
-int PlaylistSorter::partition(std::vector<Song>& songs, int low, int high) {
-    Song pivot = songs[high];
-    int i = low - 1;
     
-    for (int j = low; j < high; j++) {
-        if (songs[j].duration <= pivot.duration) {
-            i++;
-            std::swap(songs[i], songs[j]);
-        }
+    // Sort the halves on two threads, then merge them with the same threads
+    size_t mid = left + (right - left) / 2;
+    unsigned int leftThreads = threads / 2;
+    std::thread leftWorker([&, leftThreads] {
+        parallelMergeSort(order, buffer, left, mid, leftThreads, packed, keys);
+        collectWorkerCounts();
+    });
+    parallelMergeSort(order, buffer, mid + 1, right, threads - leftThreads, packed, keys);
+    leftWorker.join();
+    
+    if (!lessThan(packed, keys, order[mid + 1], order[mid])) {
+        return;
     }
-    std::swap(songs[i + 1], songs[high]);
-    return i + 1;
+    std::copy(order.begin() + left, order.begin() + right + 1, buffer.begin() + left);
+    threadMoves += right - left + 1;
+    parallelMerge(buffer, left, mid + 1, mid + 1, right + 1, order, left, threads, packed, keys);
 }
 
-std::vector<Song> PlaylistSorter::sortByTitle(const std::vector<Song>& songs) {
-    std::vector<Song> sortedSongs = songs;
+void PlaylistSorter::parallelMerge(const std::vector<uint32_t>& source, size_t leftBegin, size_t leftEnd,
+                                   size_t rightBegin, size_t rightEnd, std::vector<uint32_t>& target,
+                                   size_t targetBegin, unsigned int threads,
+                                   const PackedKeys& packed, const std::vector<SortKey>& keys) {
+    size_t leftSize = leftEnd - leftBegin;
+    size_t rightSize = rightEnd - rightBegin;
     
-    auto start = std::chrono::high_resolution_clock::now();
-    mergeSort(sortedSongs, 0, sortedSongs.size() - 1);
-    auto end = std::chrono::high_resolution_clock::now();
+    if (threads <= 1 || leftSize + rightSize < parallelThreshold || leftSize == 0) {
+        threadMoves += leftSize + rightSize;
+        
+        // Take from the left run on ties to keep the sort stable
+        size_t i = leftBegin, j = rightBegin, k = targetBegin;
+        while (i < leftEnd && j < rightEnd) {
+            if (!lessThan(packed, keys, source[j], source[i])) {
+                target[k++] = source[i++];
+            } else {
+                target[k++] = source[j++];
+            }
+        }
+        k = std::copy(source.begin() + i, source.begin() + leftEnd, target.begin() + k) - target.begin();
+        std::copy(source.begin() + j, source.begin() + rightEnd, target.begin() + k);
+        return;
+    }
     
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    std::cout << "Sort by title completed in " << duration.count() << " microseconds\n";
+    // Split at the middle of the left run. Right-run elements equal to the
+    // pivot go after it, which keeps the split stable.
+    size_t leftSplit = leftBegin + leftSize / 2;
+    uint32_t pivot = source[leftSplit];
+    size_t rightSplit = std::lower_bound(source.begin() + rightBegin, source.begin() + rightEnd, pivot,
+                                         [&](uint32_t a, uint32_t b) { return lessThan(packed, keys, a, b); }) -
+                        source.begin();
+    size_t targetSplit = targetBegin + (leftSplit - leftBegin) + (rightSplit - rightBegin);
     
-    return sortedSongs;
+    unsigned int lowerThreads = threads / 2;
+    std::thread lowerWorker([&, lowerThreads] {
+        parallelMerge(source, leftBegin, leftSplit, rightBegin, rightSplit, target, targetBegin,
+                      lowerThreads, packed, keys);
+        collectWorkerCounts();
+    });
+    parallelMerge(source, leftSplit, leftEnd, rightSplit, rightEnd, target, targetSplit,
+                  threads - lowerThreads, packed, keys);
+    lowerWorker.join();
 }
 
-std::vector<Song> PlaylistSorter::sortByDuration(const std::vector<Song>& songs, bool ascending) {
-    std::vector<Song> sortedSongs = songs;
+unsigned int PlaylistSorter::workerCount(size_t songCount) const {
+    if (songCount < parallelThreshold) {
+        return 1;
+    }
+    unsigned int threads = threadCount == 0 ? std::thread::hardware_concurrency() : threadCount;
+    return std::max(1u, threads);
+}
+
+std::vector<uint32_t> PlaylistSorter::sortedOrder(const std::vector<Song>& songs, const std::vector<SortKey>& keys) {
+    std::vector<uint32_t> order(songs.size());
+    noteAllocation(order.size() * sizeof(uint32_t));
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    if (songs.size() < 2 || keys.empty()) {
+        return order;
+    }
     
-    auto start = std::chrono::high_resolution_clock::now();
-    quickSort(sortedSongs, 0, sortedSongs.size() - 1);
-    auto end = std::chrono::high_resolution_clock::now();
+    PackedKeys packed = packKeys(songs, keys, lastMetrics.threadsUsed);
     
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    std::cout << "Sort by duration completed in " << duration.count() << " microseconds\n";
+    auto start = Clock::now();
+    std::vector<uint32_t> buffer(order.size());
+    noteAllocation(buffer.size() * sizeof(uint32_t));
+    parallelMergeSort(order, buffer, 0, order.size() - 1, lastMetrics.threadsUsed, packed, keys);
+    lastMetrics.sortMicroseconds = microsecondsSince(start);
+    return order;
+}
+
+std::vector<Song> PlaylistSorter::topK(const std::vector<Song>& songs, const std::vector<SortKey>& keys, size_t k) {
+    MetricsTimer timer(MetricId::SORT_TOP_K);
+    beginMetrics(songs.size(), workerCount(songs.size()));
+    size_t count = keys.empty() ? 0 : std::min(k, songs.size());
+    std::vector<uint32_t> heap;
     
-    if (!ascending) {
-        std::reverse(sortedSongs.begin(), sortedSongs.end());
+    if (count > 0) {
+        PackedKeys packed = packKeys(songs, keys, lastMetrics.threadsUsed);
+        auto before = [&](uint32_t a, uint32_t b) { return rankedBefore(packed, keys, a, b); };
+        
+        // Max-heap of the best k so far; its top is the worst of them
+        auto start = Clock::now();
+        heap.reserve(count);
+        noteAllocation(count * sizeof(uint32_t));
+        for (uint32_t i = 0; i < songs.size(); i++) {
+            if (heap.size() < count) {
+                heap.push_back(i);
+                std::push_heap(heap.begin(), heap.end(), before);
+                threadMoves++;
+            } else if (before(i, heap.front())) {
+                std::pop_heap(heap.begin(), heap.end(), before);
+                heap.back() = i;
+                std::push_heap(heap.begin(), heap.end(), before);
+                threadMoves++;
+            }
+        }
+        std::sort_heap(heap.begin(), heap.end(), before);
+        lastMetrics.sortMicroseconds = microsecondsSince(start);
+    } else if (keys.empty()) {
+        // No keys: the input order is already the sorted order
+        for (uint32_t i = 0; i < std::min(k, songs.size()); i++) {
+            heap.push_back(i);
+        }
     }
     
-    return sortedSongs;
+    std::vector<Song> result = gather(songs, heap.data(), heap.data() + heap.size());
+    finishMetrics(result.size());
+    return result;
 }
 
-std::vector<Song> PlaylistSorter::sortByRecentlyAdded(const std::vector<Song>& songs) {
-    std::vector<Song> sortedSongs = songs;
-    
-    auto start = std::chrono::high_resolution_clock::now();
+std::vector<Song> PlaylistSorter::sortedPage(const std::vector<Song>& songs, const std::vector<SortKey>& keys,
+                                             size_t offset, size_t limit) {
+    MetricsTimer timer(MetricId::SORT_PAGE);
+    beginMetrics(songs.size(), workerCount(songs.size()));
+    if (offset >= songs.size() || limit == 0) {
+        finishMetrics(0);
+        return {};
+    }
+    size_t pageEnd = offset + std::min(limit, songs.size() - offset);
     
-    // Sort by added time (most recent first)
-    std::sort(sortedSongs.begin(), sortedSongs.end(), 
-              [](const Song& a, const Song& b) {
-                  return a.addedTime > b.addedTime;
-              });
+    std::vector<uint32_t> order(songs.size());
+    noteAllocation(order.size() * sizeof(uint32_t));
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = static_cast<uint32_t>(i);
+    }
     
-    auto end = std::chrono::high_resolution_clock::now();
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    std::cout << "Sort by recently added completed in " << duration.count() << " microseconds\n";
+    if (!keys.empty()) {
+        PackedKeys packed = packKeys(songs, keys, lastMetrics.threadsUsed);
+        auto before = [&](uint32_t a, uint32_t b) { return rankedBefore(packed, keys, a, b); };
+        
+        // Select the page boundaries, then sort only the page itself
+        auto start = Clock::now();
+        if (pageEnd < order.size()) {
+            std::nth_element(order.begin(), order.begin() + pageEnd, order.end(), before);
+        }
+        if (offset > 0) {
+            std::nth_element(order.begin(), order.begin() + offset, order.begin() + pageEnd, before);
+        }
+        std::sort(order.begin() + offset, order.begin() + pageEnd, before);
+        lastMetrics.sortMicroseconds = microsecondsSince(start);
+    }
     
+    std::vector<Song> page = gather(songs, order.data() + offset, order.data() + pageEnd);
+    finishMetrics(page.size());
+    return page;
+}
+
+void PlaylistSorter::beginMetrics(size_t songCount, unsigned int threads) {
+    lastMetrics = SortMetrics();
+    lastMetrics.songCount = songCount;
+    lastMetrics.threadsUsed = threads;
+    startComparisons = threadComparisons;
+    startMoves = threadMoves;
+    workerComparisons = 0;
+    workerMoves = 0;
+}
+
+void PlaylistSorter::finishMetrics(size_t resultCount) {
+    lastMetrics.resultCount = resultCount;
+    lastMetrics.comparisons = threadComparisons - startComparisons + workerComparisons.load();
+    lastMetrics.moves = threadMoves - startMoves + workerMoves.load();
+}
+
+void PlaylistSorter::noteAllocation(size_t bytes) {
+    lastMetrics.allocations++;
+    lastMetrics.allocatedBytes += bytes;
+}
+
+void PlaylistSorter::collectWorkerCounts() {
+    // Runs at the end of a worker thread; its thread-local counts die with it
+    workerComparisons.fetch_add(threadComparisons, std::memory_order_relaxed);
+    workerMoves.fetch_add(threadMoves, std::memory_order_relaxed);
+}
+
+std::vector<Song> PlaylistSorter::gather(const std::vector<Song>& songs, const uint32_t* begin, const uint32_t* end) {
+    auto start = Clock::now();
+    std::vector<Song> result;
+    result.reserve(end - begin);
+    noteAllocation(result.capacity() * sizeof(Song));
+    for (const uint32_t* index = begin; index != end; ++index) {
+        result.push_back(songs[*index]);
+    }
+    lastMetrics.copyMicroseconds = microsecondsSince(start);
+    return result;
+}
+
+void PlaylistSorter::setThreadCount(unsigned int threads) {
+    threadCount = threads;
+}
+
+void PlaylistSorter::setParallelThreshold(size_t songCount) {
+    parallelThreshold = std::max<size_t>(2, songCount);
+}
+
+void PlaylistSorter::setRatings(const SongRatingTree& ratingTree) {
+    ratingsById.clear();
+    for (const auto& ratingPair : ratingTree.getAllRatings()) {
+        for (const auto& song : ratingPair.second) {
+            ratingsById[song.id] = ratingPair.first;
+        }
+    }
+}
+
+std::vector<Song> PlaylistSorter::sortBy(const std::vector<Song>& songs, const std::vector<SortKey>& keys) {
+    MetricsTimer timer(MetricId::SORT_FULL);
+    beginMetrics(songs.size(), workerCount(songs.size()));
+    std::vector<uint32_t> order = sortedOrder(songs, keys);
+    std::vector<Song> sortedSongs = gather(songs, order.data(), order.data() + order.size());
+    finishMetrics(sortedSongs.size());
     return sortedSongs;
 }
 
+std::vector<Song> PlaylistSorter::sortByTitle(const std::vector<Song>& songs) {
+    return sortBy(songs, {{SortField::TITLE, true}});
+}
+
+std::vector<Song> PlaylistSorter::sortByDuration(const std::vector<Song>& songs, bool ascending) {
+    return sortBy(songs, {{SortField::DURATION, ascending}});
+}
+
+std::vector<Song> PlaylistSorter::sortByRecentlyAdded(const std::vector<Song>& songs) {
+    // Most recent first
+    return sortBy(songs, {{SortField::ADDED_TIME, false}});
+}
+
+std::vector<Song> PlaylistSorter::sortByArtistThenRating(const std::vector<Song>& songs) {
+    return sortBy(songs, {{SortField::ARTIST, true}, {SortField::RATING, false}, {SortField::TITLE, true}});
+}
+
 void PlaylistSorter::displaySortingStats(const std::vector<Song>& original, const std::vector<Song>& sorted) {
     std::cout << "\n=== Sorting Statistics ===\n";
     std::cout << "Original size: " << original.size() << " songs\n";
@@ -2,37 +2,163 @@
 #define PLAYLIST_SORTER_H
 
 #include "song.h"
+#include "text_normalizer.h"
 #include <vector>
+#include <string>
+#include <cstdint>
+#include <unordered_map>
+#include <atomic>
 #include <algorithm>
 
+class SongRatingTree;
+
+// Fields a playlist can be ordered by
+enum class SortField {
+    TITLE,
+    ARTIST,
+    DURATION,
+    ADDED_TIME,
+    RATING,
+    ID
+};
+
+// One level of a multi-key ordering, e.g. {SortField::RATING, false} for
+// "rating, highest first"
+struct SortKey {
+    SortField field;
+    bool ascending = true;
+};
+
+// Per-phase cost of the last sort call. The sorter itself never prints;
+// callers log or aggregate these.
+struct SortMetrics {
+    size_t songCount = 0;
+    size_t resultCount = 0;
+    unsigned int threadsUsed = 1;
+    long long packMicroseconds = 0;   // building the packed keys
+    long long sortMicroseconds = 0;   // ordering (or selecting) song indices
+    long long copyMicroseconds = 0;   // copying songs into the result
+    unsigned long long comparisons = 0;
+    unsigned long long moves = 0;     // index entries written while merging / heap updates
+    size_t allocations = 0;           // buffers allocated by the sorter
+    size_t allocatedBytes = 0;
+    
+    long long totalMicroseconds() const { return packMicroseconds + sortMicroseconds + copyMicroseconds; }
+};
+
+// Sorts songs by a list of keys. Before sorting, the keys of every song are
+// packed into one fixed-width byte string (normalized text prefixes and
+// big-endian integers, inverted for descending keys), so comparing two songs
+// is a single memcmp. When a text is longer than its prefix, rows are compared
+// key by key and equal prefixes fall back to the full normalized text. Equal
+// songs keep their original order.
 class PlaylistSorter {
 private:
-    // Merge sort helper methods
-    void mergeSort(std::vector<Song>& songs, int left, int right);
-    void merge(std::vector<Song>& songs, int left, int mid, int right);
+    static const size_t kTextPrefixBytes = 16;
+    
+    // Packed keys for one sort call
+    struct PackedKeys {
+        std::vector<unsigned char> bytes;          // rowWidth bytes per song
+        size_t rowWidth = 0;
+        std::vector<std::vector<std::string>> texts; // full normalized text per text key
+        std::vector<size_t> textEnds;              // end offset of each text key in a row
+        bool truncated = false;                    // some text was longer than the prefix
+        
+        const unsigned char* row(uint32_t index) const { return bytes.data() + index * rowWidth; }
+    };
+    
+    TextNormalizer normalizer;
+    std::unordered_map<int, int> ratingsById;
+    unsigned int threadCount = 1;       // 0 = one per hardware thread
+    size_t parallelThreshold = 1 << 15; // smaller inputs are sorted on the calling thread
+    
+    // Metrics of the last call; worker threads add their counts on exit
+    SortMetrics lastMetrics;
+    unsigned long long startComparisons = 0;
+    unsigned long long startMoves = 0;
+    std::atomic<unsigned long long> workerComparisons{0};
+    std::atomic<unsigned long long> workerMoves{0};
     
-    // Quick sort helper methods
-    void quickSort(std::vector<Song>& songs, int low, int high);
-    int partition(std::vector<Song>& songs, int low, int high);
+    void beginMetrics(size_t songCount, unsigned int threads);
+    void finishMetrics(size_t resultCount);
+    void noteAllocation(size_t bytes);
+    void collectWorkerCounts();
+    std::vector<Song> gather(const std::vector<Song>& songs, const uint32_t* begin, const uint32_t* end);
+    
+    // Key packing
+    static size_t fieldWidth(SortField field);
+    bool packRows(const std::vector<Song>& songs, const std::vector<SortKey>& keys,
+                  PackedKeys& packed, size_t begin, size_t end) const;
+    PackedKeys packKeys(const std::vector<Song>& songs, const std::vector<SortKey>& keys, unsigned int threads);
+    static int compareRows(const PackedKeys& packed, const std::vector<SortKey>& keys, uint32_t a, uint32_t b);
+    static bool lessThan(const PackedKeys& packed, const std::vector<SortKey>& keys, uint32_t a, uint32_t b);
+    // Total order matching the stable sort: equal keys rank by original position
+    static bool rankedBefore(const PackedKeys& packed, const std::vector<SortKey>& keys, uint32_t a, uint32_t b);
+    
+    // Merge sort helper methods (on song indices)
+    void mergeSort(std::vector<uint32_t>& order, std::vector<uint32_t>& buffer, size_t left, size_t right,
+                   const PackedKeys& packed, const std::vector<SortKey>& keys);
+    void merge(std::vector<uint32_t>& order, std::vector<uint32_t>& buffer, size_t left, size_t mid, size_t right,
+               const PackedKeys& packed, const std::vector<SortKey>& keys);
+    
+    // Parallel merge sort: halves are sorted on separate threads, and the
+    // merge is split around a pivot so both halves of the output are merged
+    // concurrently. Produces exactly the serial (stable) order.
+    void parallelMergeSort(std::vector<uint32_t>& order, std::vector<uint32_t>& buffer,
+                           size_t left, size_t right, unsigned int threads,
+                           const PackedKeys& packed, const std::vector<SortKey>& keys);
+    void parallelMerge(const std::vector<uint32_t>& source, size_t leftBegin, size_t leftEnd,
+                       size_t rightBegin, size_t rightEnd, std::vector<uint32_t>& target,
+                       size_t targetBegin, unsigned int threads,
+                       const PackedKeys& packed, const std::vector<SortKey>& keys);
+    unsigned int workerCount(size_t songCount) const;
+    
+    std::vector<uint32_t> sortedOrder(const std::vector<Song>& songs, const std::vector<SortKey>& keys);
     
 public:
     // Constructor
     PlaylistSorter() = default;
     
-    // Sorting methods
+    PlaylistSorter(const PlaylistSorter&) = delete;
+    PlaylistSorter& operator=(const PlaylistSorter&) = delete;
+    
+    // Rating values used by SortField::RATING (unrated songs count as 0)
+    void setRatings(const SongRatingTree& ratingTree);
+    
+    // Parallel mode: inputs of at least parallelThreshold songs are packed and
+    // merge-sorted on up to threads threads (0 = hardware concurrency)
+    void setThreadCount(unsigned int threads);
+    void setParallelThreshold(size_t songCount);
+    unsigned int getThreadCount() const { return threadCount; }
+    
+    // Sort engine
+    std::vector<Song> sortBy(const std::vector<Song>& songs, const std::vector<SortKey>& keys);
+    
+    // Partial results, identical to the matching slice of sortBy
+    std::vector<Song> topK(const std::vector<Song>& songs, const std::vector<SortKey>& keys, size_t k);
+    std::vector<Song> sortedPage(const std::vector<Song>& songs, const std::vector<SortKey>& keys,
+                                 size_t offset, size_t limit);
+    
+    // Presets
     std::vector<Song> sortByTitle(const std::vector<Song>& songs);
     std::vector<Song> sortByDuration(const std::vector<Song>& songs, bool ascending = true);
     std::vector<Song> sortByRecentlyAdded(const std::vector<Song>& songs);
+    std::vector<Song> sortByArtistThenRating(const std::vector<Song>& songs);
+    
+    // Profiling
+    const SortMetrics& getLastSortMetrics() const { return lastMetrics; }
     
     // Utility methods
     void displaySortingStats(const std::vector<Song>& original, const std::vector<Song>& sorted);
     
     // Time complexity annotations:
-    // sortByTitle: O(n log n) - merge sort
-    // sortByDuration: O(n log n) - merge sort
-    // sortByRecentlyAdded: O(n log n) - merge sort
+    // sortBy: O(n * w + n log n * w) - w bytes of packed key per song, merge sort
+    // topK: O(n * w + n log k) - bounded heap of k indices
+    // sortedPage: O(n * w + n + l log l) - introselect for the page bounds, then sort l songs
+    // sortByTitle / sortByDuration / sortByRecentlyAdded / sortByArtistThenRating: same as sortBy
+    // setRatings: O(r) - r rated songs
     // mergeSort: O(n log n) - divide and conquer
-    // quickSort: O(n log n) average, O(n^2) worst case
+    // parallelMergeSort: O(n log n / t + n) - t threads; merges are split as well
 };
 
 #endif // PLAYLIST_SORTER_H 
\ No newline at end of file
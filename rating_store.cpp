@@ -0,0 +1,170 @@
+#include "rating_store.h"
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+int RatingStore::toHundredths(double rating) {
+    return static_cast<int>(std::lround(rating * 100.0));
+}
+
+void RatingStore::reindex(int songId, const RatingAggregate& before, const RatingAggregate& after) {
+    if (before.count > 0) {
+        byAverage.erase(before.average(), songId);
+    }
+    if (after.count > 0) {
+        byAverage.insert(after.average(), songId);
+    }
+}
+
+bool RatingStore::rate(int userId, int songId, double rating) {
+    if (!(rating >= kMinRating && rating <= kMaxRating)) {
+        return false;
+    }
+    
+    int hundredths = toHundredths(rating);
+    int& stored = ratingsBySong[songId][userId];  // 0 = not rated yet
+    RatingAggregate& aggregate = aggregates[songId];
+    RatingAggregate before = aggregate;
+    
+    if (stored != 0) {
+        aggregate.sumHundredths -= stored;
+    } else {
+        aggregate.count++;
+    }
+    aggregate.sumHundredths += hundredths;
+    stored = hundredths;
+    
+    reindex(songId, before, aggregate);
+    version++;
+    return true;
+}
+
+bool RatingStore::removeRating(int userId, int songId) {
+    auto song = ratingsBySong.find(songId);
+    if (song == ratingsBySong.end()) return false;
+    auto user = song->second.find(userId);
+    if (user == song->second.end()) return false;
+    
+    RatingAggregate& aggregate = aggregates[songId];
+    RatingAggregate before = aggregate;
+    aggregate.sumHundredths -= user->second;
+    aggregate.count--;
+    reindex(songId, before, aggregate);
+    
+    song->second.erase(user);
+    if (song->second.empty()) {
+        ratingsBySong.erase(song);
+        aggregates.erase(songId);
+    }
+    version++;
+    return true;
+}
+
+bool RatingStore::removeSong(int songId) {
+    auto aggregate = aggregates.find(songId);
+    if (aggregate == aggregates.end()) return false;
+    
+    reindex(songId, aggregate->second, RatingAggregate());
+    aggregates.erase(aggregate);
+    ratingsBySong.erase(songId);
+    version++;
+    return true;
+}
+
+bool RatingStore::getUserRating(int userId, int songId, double& rating) const {
+    auto song = ratingsBySong.find(songId);
+    if (song == ratingsBySong.end()) return false;
+    auto user = song->second.find(userId);
+    if (user == song->second.end()) return false;
+    
+    rating = user->second / 100.0;
+    return true;
+}
+
+RatingAggregate RatingStore::getAggregate(int songId) const {
+    auto it = aggregates.find(songId);
+    return it != aggregates.end() ? it->second : RatingAggregate();
+}
+
+std::vector<int> RatingStore::songsWithAverageAtLeast(double minAverage, size_t limit) const {
+    // Highest averages first, so a limit keeps the best matches
+    std::vector<int> result;
+    size_t matching = byAverage.size() - byAverage.countBelow(minAverage);
+    if (limit < matching) {
+        ScoredSong entry;
+        for (size_t k = 0; k < limit && byAverage.selectBest(k, entry); k++) {
+            result.push_back(entry.songId);
+        }
+        return result;
+    }
+    
+    std::vector<ScoredSong> entries = byAverage.range(minAverage, std::numeric_limits<double>::max());
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        result.push_back(it->songId);
+    }
+    return result;
+}
+
+std::vector<int> RatingStore::songsWithAverageBetween(double minAverage, double maxAverage) const {
+    std::vector<int> result;
+    for (const auto& entry : byAverage.range(minAverage, maxAverage)) {
+        result.push_back(entry.songId);
+    }
+    return result;
+}
+
+std::vector<int> RatingStore::topRated(size_t count) const {
+    std::vector<int> result;
+    ScoredSong entry;
+    for (size_t k = 0; k < count && byAverage.selectBest(k, entry); k++) {
+        result.push_back(entry.songId);
+    }
+    return result;
+}
+
+size_t RatingStore::countWithAverageBetween(double minAverage, double maxAverage) const {
+    return byAverage.countBetween(minAverage, maxAverage);
+}
+
+bool RatingStore::getRank(int songId, size_t& rank) const {
+    auto it = aggregates.find(songId);
+    if (it == aggregates.end()) return false;
+    
+    rank = byAverage.size() - 1 - byAverage.rankOf(it->second.average(), songId);
+    return true;
+}
+
+bool RatingStore::getPercentile(int songId, double& percentile) const {
+    auto it = aggregates.find(songId);
+    if (it == aggregates.end()) return false;
+    
+    percentile = byAverage.percentileOf(it->second.average(), songId);
+    return true;
+}
+
+bool RatingStore::kthBest(size_t k, int& songId) const {
+    ScoredSong entry;
+    if (!byAverage.selectBest(k, entry)) return false;
+    
+    songId = entry.songId;
+    return true;
+}
+
+size_t RatingStore::getRatingCount() const {
+    size_t total = 0;
+    for (const auto& song : ratingsBySong) {
+        total += song.second.size();
+    }
+    return total;
+}
+
+MemoryUsage RatingStore::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.items = getRatingCount();
+    usage.structureBytes = hashTableBytes(ratingsBySong) + hashTableBytes(aggregates);
+    for (const auto& song : ratingsBySong) {
+        usage.structureBytes += hashTableBytes(song.second);
+    }
+    usage.structureBytes += byAverage.size() * sizeof(RankNode);
+    return usage;
+}
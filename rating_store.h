@@ -0,0 +1,82 @@
+#ifndef RATING_STORE_H
+#define RATING_STORE_H
+
+#include "memory_usage.h"
+#include "order_statistic_tree.h"
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Running totals of every user rating of one song. Ratings are kept in
+// hundredths of a star so sums stay exact under any order of updates.
+struct RatingAggregate {
+    long long sumHundredths = 0;
+    int count = 0;
+    
+    double average() const { return count ? sumHundredths / (100.0 * count) : 0.0; }
+};
+
+// Per-user fractional ratings (e.g. 4.5 stars) with per-song aggregates.
+//
+// Each (user, song) pair holds at most one rating; rating again replaces
+// it. Aggregates are updated in O(1) per change, and an order-statistic
+// tree on (average, song id) answers range queries such as "average >= 4.2",
+// ranks, percentiles and k-th best without recomputing anything.
+class RatingStore {
+public:
+    static constexpr double kMinRating = 0.5;
+    static constexpr double kMaxRating = 5.0;
+
+private:
+    std::unordered_map<int, std::unordered_map<int, int>> ratingsBySong; // song -> user -> hundredths
+    std::unordered_map<int, RatingAggregate> aggregates;
+    OrderStatisticTree byAverage;                 // (average, song id), rated songs only
+    unsigned long long version = 0;               // bumped on every mutation
+    
+    static int toHundredths(double rating);
+    void reindex(int songId, const RatingAggregate& before, const RatingAggregate& after);
+
+public:
+    // Constructor
+    RatingStore() = default;
+    
+    RatingStore(const RatingStore&) = delete;
+    RatingStore& operator=(const RatingStore&) = delete;
+    
+    // Core operations
+    bool rate(int userId, int songId, double rating);  // false if outside [kMinRating, kMaxRating]
+    bool removeRating(int userId, int songId);
+    bool removeSong(int songId);
+    
+    // Queries
+    bool getUserRating(int userId, int songId, double& rating) const;
+    RatingAggregate getAggregate(int songId) const;
+    std::vector<int> songsWithAverageAtLeast(double minAverage, size_t limit = static_cast<size_t>(-1)) const;
+    std::vector<int> songsWithAverageBetween(double minAverage, double maxAverage) const;  // inclusive
+    std::vector<int> topRated(size_t count) const;  // highest average first
+    size_t countWithAverageBetween(double minAverage, double maxAverage) const;  // inclusive
+    
+    // Rank queries over rated songs; ties on the average are broken by song id
+    bool getRank(int songId, size_t& rank) const;            // 0 = highest average
+    bool getPercentile(int songId, double& percentile) const; // share of songs ranked below, in [0, 1)
+    bool kthBest(size_t k, int& songId) const;                // k = 0 is the best
+    
+    // Utility methods
+    size_t getRatedSongCount() const { return aggregates.size(); }
+    size_t getRatingCount() const;
+    unsigned long long getVersion() const { return version; }
+    MemoryUsage getMemoryUsage() const;
+    
+    // Time complexity annotations:
+    // rate / removeRating: O(log s) - O(1) aggregate update plus one index move; s rated songs
+    // removeSong: O(u + log s) - u users who rated the song
+    // getUserRating / getAggregate: O(1) - hash lookups
+    // songsWithAverageAtLeast: O(log s + m) - m songs returned (O(l log s) with a limit l < m)
+    // songsWithAverageBetween: O(log s + m)
+    // topRated: O(k log s) - one select per song
+    // countWithAverageBetween / getRank / getPercentile / kthBest: O(log s)
+    // getRatingCount / getMemoryUsage: O(s)
+};
+
+#endif // RATING_STORE_H
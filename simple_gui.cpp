@@ -163,10 +163,10 @@ private:
                     int index;
                     cin >> index;
                     
-                    vector<Song> songs = playlistEngine->getSongs();
-                    if (index >= 0 && index < static_cast<int>(songs.size())) {
-                        history->addPlayedSong(songs[index]);
-                        cout << "Now playing: " << songs[index].title << " by " << songs[index].artist << "\n";
+                    const Song* song = playlistEngine->startPlayback(index);
+                    if (song) {
+                        history->addPlayedSong(*song);
+                        cout << "Now playing: " << song->title << " by " << song->artist << "\n";
                     } else {
                         cout << "Invalid song index!\n";
                     }
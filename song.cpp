@@ -1,9 +1,10 @@
 #include "song.h"
 #include <sstream>
 #include <iomanip>
+#include <atomic>
 
-// Static counter for generating unique IDs
-static int nextSongId = 1;
+// Static counter for generating unique IDs (songs may be created on several threads)
+static std::atomic<int> nextSongId{1};
 
 Song::Song(const std::string& title, const std::string& artist, int duration) 
     : title(title), artist(artist), duration(duration), id(nextSongId++), 
@@ -34,6 +35,21 @@ bool Song::operator==(const Song& other) const {
     return id == other.id;
 }
 
+void Song::reserveIdsThrough(int id) {
+    int current = nextSongId.load();
+    while (current <= id && !nextSongId.compare_exchange_weak(current, id + 1)) {
+    }
+}
+
+long long toEpochMicros(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(time.time_since_epoch()).count();
+}
+
+std::chrono::system_clock::time_point fromEpochMicros(long long micros) {
+    return std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::microseconds(micros)));
+}
+
 std::string Song::getFormattedDuration() const {
     int minutes = duration / 60;
     int seconds = duration % 60;
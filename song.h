@@ -28,6 +28,14 @@ public:
     // Utility methods
     std::string getFormattedDuration() const;
     std::string toString() const;
+    
+    // Makes sure ids handed out from now on are greater than id (used after
+    // restoring songs that were created in an earlier run)
+    static void reserveIdsThrough(int id);
 };
 
+// Timestamp conversions shared by the on-disk formats
+long long toEpochMicros(std::chrono::system_clock::time_point time);
+std::chrono::system_clock::time_point fromEpochMicros(long long micros);
+
 #endif // SONG_H 
\ No newline at end of file
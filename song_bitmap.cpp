@@ -0,0 +1,416 @@
+#include "song_bitmap.h"
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+const size_t kWords = SongBitmap::kBitsetWords;
+
+// Branch-free popcount; unlike a builtin it vectorizes inside the word loops
+inline uint32_t popcount64(uint64_t x) {
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = x + (x >> 8);
+    x = x + (x >> 16);
+    x = x + (x >> 32);
+    return static_cast<uint32_t>(x & 0x7F);
+}
+
+// Word loops over whole bitsets. Fixed trip count, no early exit and no
+// aliasing between inputs and output, so -O2/-O3 turn them into SIMD loads,
+// logic ops and stores.
+uint32_t countWords(const uint64_t* words) {
+    uint32_t count = 0;
+    for (size_t i = 0; i < kWords; i++) count += popcount64(words[i]);
+    return count;
+}
+
+void andWords(const uint64_t* __restrict a, const uint64_t* __restrict b, uint64_t* __restrict out) {
+    for (size_t i = 0; i < kWords; i++) out[i] = a[i] & b[i];
+}
+
+void orWords(const uint64_t* __restrict a, const uint64_t* __restrict b, uint64_t* __restrict out) {
+    for (size_t i = 0; i < kWords; i++) out[i] = a[i] | b[i];
+}
+
+void andNotWords(const uint64_t* __restrict a, const uint64_t* __restrict b, uint64_t* __restrict out) {
+    for (size_t i = 0; i < kWords; i++) out[i] = a[i] & ~b[i];
+}
+
+uint32_t andCountWords(const uint64_t* a, const uint64_t* b) {
+    uint32_t count = 0;
+    for (size_t i = 0; i < kWords; i++) count += popcount64(a[i] & b[i]);
+    return count;
+}
+
+inline bool testBit(const std::vector<uint64_t>& words, uint16_t low) {
+    return (words[low >> 6] >> (low & 63)) & 1;
+}
+
+} // namespace
+
+bool SongBitmap::Container::contains(uint16_t low) const {
+    if (isBitset()) return testBit(words, low);
+    return std::binary_search(values.begin(), values.end(), low);
+}
+
+bool SongBitmap::Container::add(uint16_t low) {
+    if (isBitset()) {
+        uint64_t mask = 1ULL << (low & 63);
+        if (words[low >> 6] & mask) return false;
+        words[low >> 6] |= mask;
+        cardinality++;
+        return true;
+    }
+    
+    auto it = std::lower_bound(values.begin(), values.end(), low);
+    if (it != values.end() && *it == low) return false;
+    values.insert(it, low);
+    cardinality++;
+    if (cardinality > kArrayLimit) toBitset();
+    return true;
+}
+
+bool SongBitmap::Container::remove(uint16_t low) {
+    if (isBitset()) {
+        uint64_t mask = 1ULL << (low & 63);
+        if (!(words[low >> 6] & mask)) return false;
+        words[low >> 6] &= ~mask;
+        cardinality--;
+        if (cardinality <= kArrayLimit) toArray();
+        return true;
+    }
+    
+    auto it = std::lower_bound(values.begin(), values.end(), low);
+    if (it == values.end() || *it != low) return false;
+    values.erase(it);
+    cardinality--;
+    return true;
+}
+
+void SongBitmap::Container::toBitset() {
+    words.assign(kWords, 0);
+    for (uint16_t low : values) {
+        words[low >> 6] |= 1ULL << (low & 63);
+    }
+    std::vector<uint16_t>().swap(values);
+}
+
+void SongBitmap::Container::toArray() {
+    std::vector<uint16_t> result;
+    result.reserve(cardinality);
+    for (size_t w = 0; w < kWords; w++) {
+        uint64_t word = words[w];
+        while (word) {
+            uint64_t lowest = word & (~word + 1);
+            result.push_back(static_cast<uint16_t>(w * 64 + popcount64(lowest - 1)));
+            word ^= lowest;
+        }
+    }
+    values.swap(result);
+    std::vector<uint64_t>().swap(words);
+}
+
+void SongBitmap::Container::normalize() {
+    if (isBitset() && cardinality <= kArrayLimit) {
+        toArray();
+    } else if (!isBitset() && cardinality > kArrayLimit) {
+        toBitset();
+    }
+}
+
+size_t SongBitmap::lowerBound(uint16_t key) const {
+    size_t low = 0;
+    size_t high = containers.size();
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (containers[mid].key < key) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+bool SongBitmap::add(int songId) {
+    if (songId < 0) return false;
+    uint16_t key = static_cast<uint16_t>(songId >> 16);
+    size_t position = lowerBound(key);
+    if (position == containers.size() || containers[position].key != key) {
+        Container container;
+        container.key = key;
+        containers.insert(containers.begin() + position, std::move(container));
+    }
+    return containers[position].add(static_cast<uint16_t>(songId & 0xFFFF));
+}
+
+bool SongBitmap::remove(int songId) {
+    if (songId < 0) return false;
+    uint16_t key = static_cast<uint16_t>(songId >> 16);
+    size_t position = lowerBound(key);
+    if (position == containers.size() || containers[position].key != key) return false;
+    
+    Container& container = containers[position];
+    if (!container.remove(static_cast<uint16_t>(songId & 0xFFFF))) return false;
+    if (container.cardinality == 0) {
+        containers.erase(containers.begin() + position);
+    }
+    return true;
+}
+
+bool SongBitmap::contains(int songId) const {
+    if (songId < 0) return false;
+    uint16_t key = static_cast<uint16_t>(songId >> 16);
+    size_t position = lowerBound(key);
+    return position < containers.size() && containers[position].key == key &&
+           containers[position].contains(static_cast<uint16_t>(songId & 0xFFFF));
+}
+
+SongBitmap::Container SongBitmap::andContainers(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+    
+    if (a.isBitset() && b.isBitset()) {
+        result.words.resize(kWords);
+        andWords(a.words.data(), b.words.data(), result.words.data());
+        result.cardinality = countWords(result.words.data());
+        result.normalize();
+    } else if (a.isBitset() || b.isBitset()) {
+        const Container& array = a.isBitset() ? b : a;
+        const Container& bitset = a.isBitset() ? a : b;
+        for (uint16_t low : array.values) {
+            if (testBit(bitset.words, low)) result.values.push_back(low);
+        }
+        result.cardinality = static_cast<uint32_t>(result.values.size());
+    } else {
+        std::set_intersection(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                              std::back_inserter(result.values));
+        result.cardinality = static_cast<uint32_t>(result.values.size());
+    }
+    return result;
+}
+
+SongBitmap::Container SongBitmap::orContainers(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+    
+    if (a.isBitset() && b.isBitset()) {
+        result.words.resize(kWords);
+        orWords(a.words.data(), b.words.data(), result.words.data());
+        result.cardinality = countWords(result.words.data());
+    } else if (a.isBitset() || b.isBitset()) {
+        const Container& array = a.isBitset() ? b : a;
+        result = a.isBitset() ? a : b;
+        for (uint16_t low : array.values) {
+            uint64_t mask = 1ULL << (low & 63);
+            if (!(result.words[low >> 6] & mask)) {
+                result.words[low >> 6] |= mask;
+                result.cardinality++;
+            }
+        }
+    } else {
+        std::set_union(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                       std::back_inserter(result.values));
+        result.cardinality = static_cast<uint32_t>(result.values.size());
+        result.normalize();
+    }
+    return result;
+}
+
+SongBitmap::Container SongBitmap::andNotContainers(const Container& a, const Container& b) {
+    Container result;
+    result.key = a.key;
+    
+    if (a.isBitset() && b.isBitset()) {
+        result.words.resize(kWords);
+        andNotWords(a.words.data(), b.words.data(), result.words.data());
+        result.cardinality = countWords(result.words.data());
+    } else if (a.isBitset()) {
+        result = a;
+        for (uint16_t low : b.values) {
+            uint64_t mask = 1ULL << (low & 63);
+            if (result.words[low >> 6] & mask) {
+                result.words[low >> 6] &= ~mask;
+                result.cardinality--;
+            }
+        }
+    } else if (b.isBitset()) {
+        for (uint16_t low : a.values) {
+            if (!testBit(b.words, low)) result.values.push_back(low);
+        }
+        result.cardinality = static_cast<uint32_t>(result.values.size());
+    } else {
+        std::set_difference(a.values.begin(), a.values.end(), b.values.begin(), b.values.end(),
+                            std::back_inserter(result.values));
+        result.cardinality = static_cast<uint32_t>(result.values.size());
+    }
+    result.normalize();
+    return result;
+}
+
+size_t SongBitmap::andCount(const Container& a, const Container& b) {
+    if (a.isBitset() && b.isBitset()) {
+        return andCountWords(a.words.data(), b.words.data());
+    }
+    if (a.isBitset() || b.isBitset()) {
+        const Container& array = a.isBitset() ? b : a;
+        const Container& bitset = a.isBitset() ? a : b;
+        size_t count = 0;
+        for (uint16_t low : array.values) {
+            count += testBit(bitset.words, low);
+        }
+        return count;
+    }
+    
+    size_t count = 0;
+    auto left = a.values.begin();
+    auto right = b.values.begin();
+    while (left != a.values.end() && right != b.values.end()) {
+        if (*left < *right) {
+            ++left;
+        } else if (*right < *left) {
+            ++right;
+        } else {
+            count++;
+            ++left;
+            ++right;
+        }
+    }
+    return count;
+}
+
+SongBitmap SongBitmap::intersect(const SongBitmap& a, const SongBitmap& b) {
+    SongBitmap result;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.containers.size() && j < b.containers.size()) {
+        uint16_t left = a.containers[i].key;
+        uint16_t right = b.containers[j].key;
+        if (left < right) {
+            i++;
+        } else if (right < left) {
+            j++;
+        } else {
+            Container container = andContainers(a.containers[i], b.containers[j]);
+            if (container.cardinality > 0) result.containers.push_back(std::move(container));
+            i++;
+            j++;
+        }
+    }
+    return result;
+}
+
+SongBitmap SongBitmap::unite(const SongBitmap& a, const SongBitmap& b) {
+    SongBitmap result;
+    result.containers.reserve(std::max(a.containers.size(), b.containers.size()));
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.containers.size() || j < b.containers.size()) {
+        if (j == b.containers.size() || (i < a.containers.size() && a.containers[i].key < b.containers[j].key)) {
+            result.containers.push_back(a.containers[i++]);
+        } else if (i == a.containers.size() || b.containers[j].key < a.containers[i].key) {
+            result.containers.push_back(b.containers[j++]);
+        } else {
+            result.containers.push_back(orContainers(a.containers[i], b.containers[j]));
+            i++;
+            j++;
+        }
+    }
+    return result;
+}
+
+SongBitmap SongBitmap::subtract(const SongBitmap& a, const SongBitmap& b) {
+    SongBitmap result;
+    size_t j = 0;
+    for (const Container& container : a.containers) {
+        while (j < b.containers.size() && b.containers[j].key < container.key) j++;
+        if (j < b.containers.size() && b.containers[j].key == container.key) {
+            Container remaining = andNotContainers(container, b.containers[j]);
+            if (remaining.cardinality > 0) result.containers.push_back(std::move(remaining));
+        } else {
+            result.containers.push_back(container);
+        }
+    }
+    return result;
+}
+
+size_t SongBitmap::intersectCount(const SongBitmap& a, const SongBitmap& b) {
+    size_t count = 0;
+    size_t i = 0;
+    size_t j = 0;
+    while (i < a.containers.size() && j < b.containers.size()) {
+        uint16_t left = a.containers[i].key;
+        uint16_t right = b.containers[j].key;
+        if (left < right) {
+            i++;
+        } else if (right < left) {
+            j++;
+        } else {
+            count += andCount(a.containers[i], b.containers[j]);
+            i++;
+            j++;
+        }
+    }
+    return count;
+}
+
+SongBitmap& SongBitmap::operator&=(const SongBitmap& other) {
+    *this = intersect(*this, other);
+    return *this;
+}
+
+SongBitmap& SongBitmap::operator|=(const SongBitmap& other) {
+    *this = unite(*this, other);
+    return *this;
+}
+
+SongBitmap& SongBitmap::operator-=(const SongBitmap& other) {
+    *this = subtract(*this, other);
+    return *this;
+}
+
+size_t SongBitmap::cardinality() const {
+    size_t count = 0;
+    for (const Container& container : containers) {
+        count += container.cardinality;
+    }
+    return count;
+}
+
+std::vector<int> SongBitmap::toIds(size_t limit) const {
+    std::vector<int> ids;
+    ids.reserve(std::min(limit, cardinality()));
+    for (const Container& container : containers) {
+        int high = static_cast<int>(container.key) << 16;
+        if (container.isBitset()) {
+            for (size_t w = 0; w < kWords; w++) {
+                uint64_t word = container.words[w];
+                while (word) {
+                    if (ids.size() >= limit) return ids;
+                    uint64_t lowest = word & (~word + 1);
+                    ids.push_back(high | static_cast<int>(w * 64 + popcount64(lowest - 1)));
+                    word ^= lowest;
+                }
+            }
+        } else {
+            for (uint16_t low : container.values) {
+                if (ids.size() >= limit) return ids;
+                ids.push_back(high | low);
+            }
+        }
+    }
+    return ids;
+}
+
+MemoryUsage SongBitmap::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.items = cardinality();
+    usage.structureBytes = containers.capacity() * sizeof(Container);
+    for (const Container& container : containers) {
+        usage.structureBytes += container.values.capacity() * sizeof(uint16_t) +
+                                container.words.capacity() * sizeof(uint64_t);
+    }
+    return usage;
+}
@@ -0,0 +1,88 @@
+#ifndef SONG_BITMAP_H
+#define SONG_BITMAP_H
+
+#include "memory_usage.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compressed set of song ids in the style of a roaring bitmap.
+//
+// Ids are split into a 16-bit high key and a 16-bit low part. Each key that
+// has members owns one container: a sorted array of low parts while it holds
+// at most kArrayLimit ids, and a 65536-bit bitset above that. Set operations
+// work container by container; bitset pairs are combined with plain word
+// loops that the compiler vectorizes, and counts are taken without building
+// the result. Negative ids are ignored.
+class SongBitmap {
+public:
+    static constexpr size_t kArrayLimit = 4096;  // a bitset is never larger than this many ids as an array
+    static constexpr size_t kBitsetWords = 1024;
+
+private:
+    struct Container {
+        uint16_t key = 0;
+        uint32_t cardinality = 0;
+        std::vector<uint16_t> values;  // array form: sorted low parts
+        std::vector<uint64_t> words;   // bitset form: kBitsetWords words, empty in array form
+        
+        bool isBitset() const { return !words.empty(); }
+        bool contains(uint16_t low) const;
+        bool add(uint16_t low);
+        bool remove(uint16_t low);
+        void toBitset();
+        void toArray();
+        void normalize();  // picks the smaller form for the current cardinality
+    };
+    
+    std::vector<Container> containers;  // sorted by key
+    
+    size_t lowerBound(uint16_t key) const;
+    
+    static Container andContainers(const Container& a, const Container& b);
+    static Container orContainers(const Container& a, const Container& b);
+    static Container andNotContainers(const Container& a, const Container& b);
+    static size_t andCount(const Container& a, const Container& b);
+
+public:
+    // Constructor
+    SongBitmap() = default;
+    
+    // Core operations
+    bool add(int songId);     // false if already present
+    bool remove(int songId);  // false if absent
+    bool contains(int songId) const;
+    void clear() { containers.clear(); }
+    
+    // In-place set operations
+    SongBitmap& operator&=(const SongBitmap& other);
+    SongBitmap& operator|=(const SongBitmap& other);
+    SongBitmap& operator-=(const SongBitmap& other);  // AND NOT
+    
+    // Set operations producing a new bitmap
+    static SongBitmap intersect(const SongBitmap& a, const SongBitmap& b);
+    static SongBitmap unite(const SongBitmap& a, const SongBitmap& b);
+    static SongBitmap subtract(const SongBitmap& a, const SongBitmap& b);
+    
+    // Counts without building the result
+    static size_t intersectCount(const SongBitmap& a, const SongBitmap& b);
+    size_t cardinality() const;
+    bool empty() const { return containers.empty(); }
+    
+    // Members in ascending order
+    std::vector<int> toIds(size_t limit = static_cast<size_t>(-1)) const;
+    
+    // Utility methods
+    MemoryUsage getMemoryUsage() const;
+    
+    // Time complexity annotations:
+    // add / remove: O(log c + A) - c containers; A = kArrayLimit shifts in array form, O(1) as bitset
+    // contains: O(log c + log A)
+    // intersect / unite / subtract and the in-place forms: O(c * W) - W = kBitsetWords for
+    //   bitset pairs, merge of the two arrays or an array scan otherwise
+    // intersectCount: same as intersect, without allocating
+    // cardinality: O(c)
+    // toIds: O(m) - m ids returned
+};
+
+#endif // SONG_BITMAP_H
@@ -0,0 +1,231 @@
+#include "song_columns.h"
+#include "column_kernels.h"
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+int32_t SongColumns::encodeArtist(const std::string& artist) {
+    auto it = artistDictionary.find(artist);
+    if (it != artistDictionary.end()) return it->second;
+    
+    // Codes are never reused, so a row's code stays valid after removals
+    int32_t code = static_cast<int32_t>(artistNames.size());
+    artistNames.push_back(artist);
+    artistDictionary.emplace(artist, code);
+    return code;
+}
+
+void SongColumns::addSong(const Song& song, int rating) {
+    int8_t stars = static_cast<int8_t>(rating >= 1 && rating <= 5 ? rating : 0);
+    int32_t artist = encodeArtist(song.artist);
+    
+    auto existing = rowById.find(song.id);
+    if (existing != rowById.end()) {
+        uint32_t row = existing->second;
+        durations[row] = song.duration;
+        addedMicros[row] = toEpochMicros(song.addedTime);
+        artistCodes[row] = artist;
+        if (stars) ratings[row] = stars;
+        version++;
+        return;
+    }
+    
+    rowById.emplace(song.id, static_cast<uint32_t>(ids.size()));
+    ids.push_back(song.id);
+    durations.push_back(song.duration);
+    addedMicros.push_back(toEpochMicros(song.addedTime));
+    ratings.push_back(stars);
+    artistCodes.push_back(artist);
+    version++;
+}
+
+bool SongColumns::removeSong(int songId) {
+    auto it = rowById.find(songId);
+    if (it == rowById.end()) return false;
+    
+    uint32_t row = it->second;
+    uint32_t last = static_cast<uint32_t>(ids.size() - 1);
+    if (row != last) {
+        ids[row] = ids[last];
+        durations[row] = durations[last];
+        addedMicros[row] = addedMicros[last];
+        ratings[row] = ratings[last];
+        artistCodes[row] = artistCodes[last];
+        rowById[ids[row]] = row;
+    }
+    ids.pop_back();
+    durations.pop_back();
+    addedMicros.pop_back();
+    ratings.pop_back();
+    artistCodes.pop_back();
+    rowById.erase(songId);
+    version++;
+    return true;
+}
+
+bool SongColumns::setRating(int songId, int rating) {
+    auto it = rowById.find(songId);
+    if (it == rowById.end()) return false;
+    ratings[it->second] = static_cast<int8_t>(rating >= 1 && rating <= 5 ? rating : 0);
+    version++;
+    return true;
+}
+
+void SongColumns::apply(const std::vector<EngineEvent>& events) {
+    for (const auto& event : events) {
+        if (event.type == EngineEventType::RATED) {
+            setRating(event.songId, event.rating);
+        } else if (event.type == EngineEventType::UNRATED) {
+            // A re-rate publishes UNRATED for the old bucket before RATED
+            auto it = rowById.find(event.songId);
+            if (it != rowById.end() && ratings[it->second] == event.rating) {
+                ratings[it->second] = 0;
+                version++;
+            }
+        }
+    }
+}
+
+void SongColumns::clear() {
+    ids.clear();
+    durations.clear();
+    addedMicros.clear();
+    ratings.clear();
+    artistCodes.clear();
+    artistNames.clear();
+    artistDictionary.clear();
+    rowById.clear();
+    version++;
+}
+
+std::shared_ptr<const SongColumns> SongColumns::scanCopy() const {
+    auto copy = std::make_shared<SongColumns>();
+    copy->ids = ids;
+    copy->durations = durations;
+    copy->addedMicros = addedMicros;
+    copy->ratings = ratings;
+    copy->artistCodes = artistCodes;
+    copy->artistNames = artistNames;
+    copy->version = version;
+    return copy;
+}
+
+DurationSummary SongColumns::summarizeDurations() const {
+    const ColumnKernelTable& kernels = ColumnKernels::active();
+    DurationSummary summary;
+    summary.count = durations.size();
+    if (summary.count == 0) return summary;
+    summary.totalSeconds = kernels.sumInt32(durations.data(), durations.size());
+    kernels.minMaxInt32(durations.data(), durations.size(), summary.shortest, summary.longest);
+    return summary;
+}
+
+std::vector<size_t> SongColumns::durationHistogram(int bandSeconds, int bandCount) const {
+    if (bandSeconds <= 0 || bandCount <= 0) return {};
+    std::vector<size_t> histogram(bandCount, 0);
+    ColumnKernels::active().bandHistogram(durations.data(), durations.size(), bandSeconds, histogram.data(), bandCount);
+    return histogram;
+}
+
+std::array<size_t, 6> SongColumns::ratingHistogram() const {
+    std::array<size_t, 6> histogram{};
+    ColumnKernels::active().ratingHistogram(ratings.data(), ratings.size(), histogram.data());
+    return histogram;
+}
+
+size_t SongColumns::countAddedBetween(std::chrono::system_clock::time_point from,
+                                     std::chrono::system_clock::time_point to) const {
+    return ColumnKernels::active().countInRangeInt64(addedMicros.data(), addedMicros.size(),
+                                                     toEpochMicros(from), toEpochMicros(to));
+}
+
+size_t SongColumns::countDurationBetween(int minSeconds, int maxSeconds) const {
+    return ColumnKernels::active().countInRange(durations.data(), durations.size(), minSeconds, maxSeconds);
+}
+
+std::vector<int> SongColumns::songsWithDurationBetween(int minSeconds, int maxSeconds) const {
+    std::vector<uint32_t> rows(durations.size());
+    size_t matches = ColumnKernels::active().selectInRange(durations.data(), durations.size(),
+                                                           minSeconds, maxSeconds, rows.data());
+    std::vector<int> songIds(matches);
+    for (size_t i = 0; i < matches; i++) {
+        songIds[i] = ids[rows[i]];
+    }
+    return songIds;
+}
+
+std::vector<int> SongColumns::longestSongIds(size_t count) const {
+    if (count == 0) return {};
+    
+    // Min-heap of the best k (duration, -id); most rows fail the first compare
+    using Entry = std::pair<int32_t, int32_t>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> best;
+    const ColumnKernelTable& kernels = ColumnKernels::active();
+    const size_t blockRows = 1024;
+    for (size_t begin = 0; begin < durations.size(); begin += blockRows) {
+        size_t end = std::min(durations.size(), begin + blockRows);
+        
+        // Once k songs are held, a block whose longest song is shorter than
+        // the k-th longest so far cannot contribute
+        if (best.size() == count) {
+            int32_t shortest = 0;
+            int32_t longest = 0;
+            kernels.minMaxInt32(durations.data() + begin, end - begin, shortest, longest);
+            if (longest < best.top().first) continue;
+        }
+        for (size_t row = begin; row < end; row++) {
+            Entry entry(durations[row], -ids[row]);
+            if (best.size() < count) {
+                best.push(entry);
+            } else if (best.top() < entry) {
+                best.pop();
+                best.push(entry);
+            }
+        }
+    }
+    
+    std::vector<int> result(best.size());
+    for (size_t i = result.size(); i-- > 0;) {
+        result[i] = -best.top().second;
+        best.pop();
+    }
+    return result;
+}
+
+std::vector<std::pair<std::string, size_t>> SongColumns::topArtists(size_t count) const {
+    std::vector<size_t> songsPerArtist(artistNames.size(), 0);
+    for (int32_t code : artistCodes) {
+        songsPerArtist[code]++;
+    }
+    
+    std::vector<int32_t> codes;
+    for (size_t code = 0; code < songsPerArtist.size(); code++) {
+        if (songsPerArtist[code] > 0) codes.push_back(static_cast<int32_t>(code));
+    }
+    auto moreSongs = [&songsPerArtist](int32_t a, int32_t b) {
+        return songsPerArtist[a] != songsPerArtist[b] ? songsPerArtist[a] > songsPerArtist[b] : a < b;
+    };
+    size_t kept = std::min(count, codes.size());
+    std::partial_sort(codes.begin(), codes.begin() + kept, codes.end(), moreSongs);
+    
+    std::vector<std::pair<std::string, size_t>> result;
+    for (size_t i = 0; i < kept; i++) {
+        result.push_back({artistNames[codes[i]], songsPerArtist[codes[i]]});
+    }
+    return result;
+}
+
+MemoryUsage SongColumns::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage.items = ids.size();
+    usage.structureBytes = ids.capacity() * sizeof(int32_t) + durations.capacity() * sizeof(int32_t) +
+                           addedMicros.capacity() * sizeof(int64_t) + ratings.capacity() * sizeof(int8_t) +
+                           artistCodes.capacity() * sizeof(int32_t) +
+                           artistNames.capacity() * sizeof(std::string) +
+                           hashTableBytes(artistDictionary) + hashTableBytes(rowById);
+    for (const auto& artist : artistNames) {
+        // Each name is stored twice: in the code table and as a dictionary key
+        usage.stringBytes += 2 * stringHeapBytes(artist);
+    }
+    return usage;
+}
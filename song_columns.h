@@ -0,0 +1,95 @@
+#ifndef SONG_COLUMNS_H
+#define SONG_COLUMNS_H
+
+#include "song.h"
+#include "event_bus.h"
+#include "memory_usage.h"
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Result of one pass over the duration column
+struct DurationSummary {
+    size_t count = 0;
+    long long totalSeconds = 0;
+    int shortest = 0;
+    int longest = 0;
+    
+    double average() const { return count ? static_cast<double>(totalSeconds) / count : 0.0; }
+};
+
+// Columnar (structure-of-arrays) mirror of the catalog for statistics scans.
+//
+// Row i of every column describes one song: id, duration, added time in
+// epoch microseconds, star rating (0 = unrated) and a dictionary code for
+// the artist. Scans read only the columns they need, as contiguous
+// fixed-width arrays, and run on the SIMD kernels picked for the CPU (see
+// ColumnKernels) instead of walking Song objects with their strings. Rows
+// are not in playlist order: removal moves the last row into the hole.
+class SongColumns {
+private:
+    std::vector<int32_t> ids;
+    std::vector<int32_t> durations;
+    std::vector<int64_t> addedMicros;
+    std::vector<int8_t> ratings;
+    std::vector<int32_t> artistCodes;
+    
+    std::vector<std::string> artistNames;                    // code -> artist
+    std::unordered_map<std::string, int32_t> artistDictionary;  // artist -> code
+    std::unordered_map<int, uint32_t> rowById;
+    unsigned long long version = 0;  // bumped on every change
+    
+    int32_t encodeArtist(const std::string& artist);
+
+public:
+    // Constructor
+    SongColumns() = default;
+    
+    SongColumns(const SongColumns&) = delete;
+    SongColumns& operator=(const SongColumns&) = delete;
+    
+    // Row maintenance
+    void addSong(const Song& song, int rating = 0);  // an existing id is overwritten in place
+    bool removeSong(int songId);
+    bool setRating(int songId, int rating);          // 0 clears
+    void apply(const std::vector<EngineEvent>& events);  // RATED / UNRATED
+    void clear();
+    
+    // Copy of the columns and artist names only, for scans on another thread.
+    // The copy has no id map: it can be scanned but not updated.
+    std::shared_ptr<const SongColumns> scanCopy() const;
+    
+    // Column scans
+    DurationSummary summarizeDurations() const;
+    std::vector<size_t> durationHistogram(int bandSeconds, int bandCount) const;  // last band is open-ended
+    std::array<size_t, 6> ratingHistogram() const;  // index = stars, 0 = unrated
+    size_t countAddedBetween(std::chrono::system_clock::time_point from,
+                             std::chrono::system_clock::time_point to) const;  // [from, to)
+    size_t countDurationBetween(int minSeconds, int maxSeconds) const;  // [min, max)
+    std::vector<int> songsWithDurationBetween(int minSeconds, int maxSeconds) const;  // row order
+    std::vector<int> longestSongIds(size_t count) const;  // longest first, ties by lower id
+    std::vector<std::pair<std::string, size_t>> topArtists(size_t count) const;  // most songs first
+    
+    // Utility methods
+    size_t size() const { return ids.size(); }
+    size_t getArtistCount() const { return artistNames.size(); }
+    unsigned long long getVersion() const { return version; }
+    MemoryUsage getMemoryUsage() const;
+    
+    // Time complexity annotations:
+    // addSong / removeSong / setRating: O(1) average - hash lookups, swap-remove
+    // scanCopy: O(n + a) - one copy of each fixed-width column and the artist names
+    // summarizeDurations / ratingHistogram / countAddedBetween / countDurationBetween: O(n) - SIMD pass
+    // durationHistogram: O(n * b) vector compares for b <= 16 bands, O(n) scalar beyond
+    // songsWithDurationBetween: O(n + m) - m matching rows
+    // longestSongIds: O(n + n' log k) - blocks below the k-th longest are skipped after a SIMD max
+    // topArtists: O(n + a log k) - a distinct artists
+    // getMemoryUsage: O(a) - string payloads of the artist dictionary
+};
+
+#endif // SONG_COLUMNS_H
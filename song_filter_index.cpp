@@ -0,0 +1,294 @@
+#include "song_filter_index.h"
+#include <algorithm>
+#include <climits>
+#include <iterator>
+
+int SongFilterIndex::bandOf(int duration) {
+    if (duration < 0) duration = 0;
+    return std::min(duration / kDurationBandSeconds, kDurationBands - 1);
+}
+
+long long SongFilterIndex::hourOf(std::chrono::system_clock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::hours>(time.time_since_epoch()).count();
+}
+
+void SongFilterIndex::addSong(const Song& song) {
+    if (song.id < 0) return;
+    
+    std::string artistKey = normalizer.normalize(song.artist);
+    auto existing = indexedSongs.find(song.id);
+    if (existing != indexedSongs.end()) {
+        if (existing->second.first == song.duration && existing->second.second == artistKey) return;
+        
+        durationBands[bandOf(existing->second.first)].remove(song.id);
+        auto artist = artistSongs.find(existing->second.second);
+        if (artist != artistSongs.end()) {
+            artist->second.remove(song.id);
+            if (artist->second.empty()) artistSongs.erase(artist);
+        }
+    }
+    
+    catalog.add(song.id);
+    durationBands[bandOf(song.duration)].add(song.id);
+    artistSongs[artistKey].add(song.id);
+    indexedSongs[song.id] = std::make_pair(song.duration, std::move(artistKey));
+    version++;
+}
+
+void SongFilterIndex::removeSong(int songId) {
+    auto existing = indexedSongs.find(songId);
+    if (existing == indexedSongs.end()) return;
+    
+    catalog.remove(songId);
+    durationBands[bandOf(existing->second.first)].remove(songId);
+    auto artist = artistSongs.find(existing->second.second);
+    if (artist != artistSongs.end()) {
+        artist->second.remove(songId);
+        if (artist->second.empty()) artistSongs.erase(artist);
+    }
+    for (SongBitmap& bucket : ratingBuckets) {
+        bucket.remove(songId);
+    }
+    indexedSongs.erase(existing);
+    version++;
+}
+
+void SongFilterIndex::clearCatalog() {
+    catalog.clear();
+    for (SongBitmap& bucket : ratingBuckets) bucket.clear();
+    for (SongBitmap& band : durationBands) band.clear();
+    artistSongs.clear();
+    indexedSongs.clear();
+    version++;
+}
+
+void SongFilterIndex::clearPlays() {
+    playWindows.clear();
+    recentPlays.clear();
+    version++;
+}
+
+void SongFilterIndex::addRating(int songId, int rating) {
+    if (rating < 1 || rating > 5) return;
+    ratingBuckets[rating].add(songId);
+    version++;
+}
+
+void SongFilterIndex::removeRating(int songId, int rating) {
+    if (rating < 1 || rating > 5) return;
+    ratingBuckets[rating].remove(songId);
+    version++;
+}
+
+void SongFilterIndex::expireWindows(long long currentHour) {
+    while (!playWindows.empty() && playWindows.front().hour <= currentHour - kRecencyHours) {
+        playWindows.pop_front();
+    }
+    while (!recentPlays.empty() && recentPlays.front().second <= currentHour - kRecencyHours) {
+        recentPlays.pop_front();
+    }
+}
+
+void SongFilterIndex::recordPlay(int songId, std::chrono::system_clock::time_point when) {
+    long long hour = hourOf(when);
+    if (!playWindows.empty() && hour <= playWindows.back().hour - kRecencyHours) return;
+    
+    // Plays arrive in time order, so the window is almost always the last one
+    auto it = playWindows.end();
+    while (it != playWindows.begin() && std::prev(it)->hour > hour) --it;
+    if (it == playWindows.begin() || std::prev(it)->hour != hour) {
+        PlayWindow window;
+        window.hour = hour;
+        it = playWindows.insert(it, std::move(window));
+    } else {
+        --it;
+    }
+    
+    it->songs.add(songId);
+    it->plays[songId]++;
+    recentPlays.push_back({songId, hour});
+    expireWindows(playWindows.back().hour);
+    version++;
+}
+
+void SongFilterIndex::undoPlay(int songId) {
+    // History undoes its newest play; older ones have already left the windows
+    if (recentPlays.empty() || recentPlays.back().first != songId) return;
+    long long hour = recentPlays.back().second;
+    recentPlays.pop_back();
+    version++;
+    
+    for (auto it = playWindows.rbegin(); it != playWindows.rend(); ++it) {
+        if (it->hour != hour) continue;
+        auto plays = it->plays.find(songId);
+        if (plays != it->plays.end() && --plays->second == 0) {
+            it->plays.erase(plays);
+            it->songs.remove(songId);
+        }
+        break;
+    }
+}
+
+void SongFilterIndex::apply(const std::vector<EngineEvent>& events) {
+    for (const auto& event : events) {
+        switch (event.type) {
+            case EngineEventType::RATED:
+                addRating(event.songId, event.rating);
+                break;
+            case EngineEventType::UNRATED:
+                removeRating(event.songId, event.rating);
+                break;
+            case EngineEventType::PLAYED:
+                // Loaded and replayed plays keep their own time, not the time of the load
+                recordPlay(event.songId, fromEpochMicros(event.micros));
+                break;
+            case EngineEventType::PLAY_UNDONE:
+                undoPlay(event.songId);
+                break;
+            default:
+                break;  // playlist order is not indexed; catalog changes come from the owner
+        }
+    }
+}
+
+SongBitmap SongFilterIndex::durationsBetween(int minDuration, int maxDuration) const {
+    long long upper = maxDuration < 0 ? LLONG_MAX : maxDuration;
+    SongBitmap result;
+    for (int band = 0; band < kDurationBands; band++) {
+        long long bandStart = static_cast<long long>(band) * kDurationBandSeconds;
+        long long bandEnd = band == kDurationBands - 1 ? LLONG_MAX : bandStart + kDurationBandSeconds;
+        if (bandEnd <= minDuration || bandStart >= upper) continue;
+        
+        if (bandStart >= minDuration && bandEnd <= upper) {
+            result |= durationBands[band];
+        } else {
+            // Band straddles a bound: check the members' exact durations
+            for (int songId : durationBands[band].toIds()) {
+                int duration = indexedSongs.at(songId).first;
+                if (duration >= minDuration && duration < upper) result.add(songId);
+            }
+        }
+    }
+    return result;
+}
+
+SongBitmap SongFilterIndex::playedSince(long long firstHour) const {
+    SongBitmap result;
+    for (auto it = playWindows.rbegin(); it != playWindows.rend() && it->hour >= firstHour; ++it) {
+        result |= it->songs;
+    }
+    return result;
+}
+
+SongBitmap SongFilterIndex::ratingsBetween(int minRating, int maxRating) const {
+    SongBitmap result;
+    for (int rating = std::max(minRating, 1); rating <= std::min(maxRating, 5); rating++) {
+        result |= ratingBuckets[rating];
+    }
+    return result;
+}
+
+SongBitmap SongFilterIndex::artistsIn(const std::vector<std::string>& artists) const {
+    SongBitmap result;
+    for (const auto& artist : artists) {
+        auto it = artistSongs.find(normalizer.normalize(artist));
+        if (it != artistSongs.end()) result |= it->second;
+    }
+    return result;
+}
+
+void SongFilterIndex::collectConditions(const SongFilter& filter, std::chrono::system_clock::time_point now,
+                                        std::vector<SongBitmap>& required, SongBitmap& excluded,
+                                        bool& hasExcluded) const {
+    long long currentHour = hourOf(now);
+    
+    if (filter.minRating >= 1) {
+        required.push_back(ratingsBetween(filter.minRating, filter.maxRating));
+    }
+    if (filter.minDuration > 0 || filter.maxDuration >= 0) {
+        required.push_back(durationsBetween(filter.minDuration, filter.maxDuration));
+    }
+    if (!filter.artists.empty()) {
+        required.push_back(artistsIn(filter.artists));
+    }
+    if (filter.playedWithinHours > 0) {
+        int hours = std::min(filter.playedWithinHours, kRecencyHours);
+        required.push_back(playedSince(currentHour - hours + 1));
+    }
+    
+    hasExcluded = filter.notPlayedWithinHours > 0;
+    if (hasExcluded) {
+        int hours = std::min(filter.notPlayedWithinHours, kRecencyHours);
+        excluded = playedSince(currentHour - hours + 1);
+    }
+    
+    // Smallest first, so every AND shrinks the working set as early as possible
+    std::sort(required.begin(), required.end(), [](const SongBitmap& a, const SongBitmap& b) {
+        return a.cardinality() < b.cardinality();
+    });
+}
+
+SongBitmap SongFilterIndex::evaluate(const SongFilter& filter, std::chrono::system_clock::time_point now) const {
+    std::vector<SongBitmap> required;
+    SongBitmap excluded;
+    bool hasExcluded = false;
+    collectConditions(filter, now, required, excluded, hasExcluded);
+    
+    SongBitmap result = required.empty() ? catalog : SongBitmap::intersect(required[0], catalog);
+    for (size_t i = 1; i < required.size() && !result.empty(); i++) {
+        result &= required[i];
+    }
+    if (hasExcluded) result -= excluded;
+    return result;
+}
+
+size_t SongFilterIndex::count(const SongFilter& filter, std::chrono::system_clock::time_point now) const {
+    std::vector<SongBitmap> required;
+    SongBitmap excluded;
+    bool hasExcluded = false;
+    collectConditions(filter, now, required, excluded, hasExcluded);
+    
+    // The last step only counts: |A AND B| or |A| - |A AND NOT-excluded|
+    if (required.empty()) {
+        return catalog.cardinality() - (hasExcluded ? SongBitmap::intersectCount(catalog, excluded) : 0);
+    }
+    if (!hasExcluded && required.size() == 1) {
+        return SongBitmap::intersectCount(required[0], catalog);
+    }
+    
+    SongBitmap candidates = SongBitmap::intersect(required[0], catalog);
+    size_t last = hasExcluded ? required.size() : required.size() - 1;
+    for (size_t i = 1; i < last && !candidates.empty(); i++) {
+        candidates &= required[i];
+    }
+    if (!hasExcluded) {
+        return SongBitmap::intersectCount(candidates, required.back());
+    }
+    return candidates.cardinality() - SongBitmap::intersectCount(candidates, excluded);
+}
+
+std::vector<int> SongFilterIndex::query(const SongFilter& filter, size_t limit,
+                                        std::chrono::system_clock::time_point now) const {
+    return evaluate(filter, now).toIds(limit);
+}
+
+MemoryUsage SongFilterIndex::getMemoryUsage() const {
+    MemoryUsage usage;
+    usage += catalog.getMemoryUsage();
+    for (const SongBitmap& bucket : ratingBuckets) usage += bucket.getMemoryUsage();
+    for (const SongBitmap& band : durationBands) usage += band.getMemoryUsage();
+    usage.structureBytes += hashTableBytes(artistSongs) + hashTableBytes(indexedSongs);
+    for (const auto& artist : artistSongs) {
+        usage += artist.second.getMemoryUsage();
+        usage.stringBytes += stringHeapBytes(artist.first);
+    }
+    for (const auto& song : indexedSongs) {
+        usage.stringBytes += stringHeapBytes(song.second.second);
+    }
+    for (const auto& window : playWindows) {
+        usage += window.songs.getMemoryUsage();
+        usage.structureBytes += hashTableBytes(window.plays);
+    }
+    usage.items = catalog.cardinality();
+    return usage;
+}
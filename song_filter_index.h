@@ -0,0 +1,115 @@
+#ifndef SONG_FILTER_INDEX_H
+#define SONG_FILTER_INDEX_H
+
+#include "song.h"
+#include "song_bitmap.h"
+#include "event_bus.h"
+#include "text_normalizer.h"
+#include "memory_usage.h"
+#include <chrono>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Conditions of a dashboard filter, combined with AND. Unset fields match
+// every song, e.g. "rating >= 4 AND duration < 300 AND artist in {...} AND
+// not played in the last 24h" is {4, 5, 0, 300, {...}, 0, 24}.
+struct SongFilter {
+    int minRating = 0;                  // star rating range (1-5); minRating 0 = no rating condition
+    int maxRating = 5;                  // only applies together with minRating
+    int minDuration = 0;                // seconds, inclusive
+    int maxDuration = -1;               // seconds, exclusive; -1 = no upper limit
+    std::vector<std::string> artists;   // any of these (normalized match); empty = any artist
+    int playedWithinHours = 0;          // 0 = no condition
+    int notPlayedWithinHours = 0;       // 0 = no condition
+};
+
+// Bitmap indexes over catalog song ids for filtered library queries.
+//
+// Every condition of a SongFilter has its own SongBitmap family: one per
+// star rating, per 30-second duration band, per artist and per clock hour of
+// plays. A query ANDs, ORs and AND-NOTs those bitmaps, so counting matches
+// never touches a Song; only the final ids are handed out. Play recency is
+// tracked in whole clock hours for the last kRecencyHours hours.
+//
+// Catalog songs are added and removed by the owner (see Library); ratings
+// and plays arrive as EngineEvents through apply().
+class SongFilterIndex {
+public:
+    static constexpr int kDurationBandSeconds = 30;
+    static constexpr int kDurationBands = 40;    // the last band holds everything from 19:30 up
+    static constexpr int kRecencyHours = 24 * 7; // older play windows are dropped
+
+private:
+    // Songs played during one clock hour
+    struct PlayWindow {
+        long long hour = 0;                   // hours since the epoch
+        SongBitmap songs;
+        std::unordered_map<int, int> plays;   // song id -> plays in this hour, for undo
+    };
+    
+    TextNormalizer normalizer;
+    SongBitmap catalog;
+    SongBitmap ratingBuckets[6];               // index = star rating 1-5
+    SongBitmap durationBands[kDurationBands];
+    std::unordered_map<std::string, SongBitmap> artistSongs;  // normalized artist -> songs
+    std::unordered_map<int, std::pair<int, std::string>> indexedSongs;  // id -> (duration, artist key)
+    std::deque<PlayWindow> playWindows;        // oldest first
+    std::deque<std::pair<int, long long>> recentPlays;  // (song id, hour), newest last
+    unsigned long long version = 0;            // bumped on every change
+    
+    static int bandOf(int duration);
+    static long long hourOf(std::chrono::system_clock::time_point time);
+    SongBitmap durationsBetween(int minDuration, int maxDuration) const;
+    SongBitmap playedSince(long long firstHour) const;
+    SongBitmap ratingsBetween(int minRating, int maxRating) const;
+    SongBitmap artistsIn(const std::vector<std::string>& artists) const;
+    void expireWindows(long long currentHour);
+    
+    // Positive conditions (ANDed onto the catalog) and the optional AND-NOT
+    void collectConditions(const SongFilter& filter, std::chrono::system_clock::time_point now,
+                           std::vector<SongBitmap>& required, SongBitmap& excluded, bool& hasExcluded) const;
+
+public:
+    // Constructor
+    SongFilterIndex() = default;
+    
+    SongFilterIndex(const SongFilterIndex&) = delete;
+    SongFilterIndex& operator=(const SongFilterIndex&) = delete;
+    
+    // Catalog maintenance
+    void addSong(const Song& song);  // re-adding an id refreshes its duration and artist
+    void removeSong(int songId);
+    void clearCatalog();             // drops songs and ratings; play windows are kept
+    void clearPlays();               // drops the play windows
+    
+    // Rating and play updates
+    void addRating(int songId, int rating);
+    void removeRating(int songId, int rating);
+    void recordPlay(int songId, std::chrono::system_clock::time_point when = std::chrono::system_clock::now());
+    void undoPlay(int songId);
+    void apply(const std::vector<EngineEvent>& events);  // RATED / UNRATED / PLAYED / PLAY_UNDONE
+    
+    // Queries
+    SongBitmap evaluate(const SongFilter& filter,
+                        std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;
+    size_t count(const SongFilter& filter,
+                 std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;
+    std::vector<int> query(const SongFilter& filter, size_t limit = static_cast<size_t>(-1),
+                           std::chrono::system_clock::time_point now = std::chrono::system_clock::now()) const;
+    
+    // Utility methods
+    size_t getSongCount() const { return catalog.cardinality(); }
+    unsigned long long getVersion() const { return version; }
+    MemoryUsage getMemoryUsage() const;
+    
+    // Time complexity annotations:
+    // addSong / removeSong: O(L + B) - L normalized artist length, B = bitmap add/remove
+    // addRating / removeRating / recordPlay / undoPlay: O(B) amortized
+    // evaluate / count: O(k * c * W) - k conditions, c containers, W bitset words; no Song is read
+    // query: evaluate plus O(m) for m ids returned
+};
+
+#endif // SONG_FILTER_INDEX_H
@@ -1,13 +1,46 @@
 #include "song_lookup.h"
+#include "metrics_registry.h"
 #include <iostream>
+#include <algorithm>
+
+SongLookup::SongLookup(const NormalizationOptions& options) : normalizer(options) {
+}
 
 void SongLookup::addSong(const Song& song) {
-    titleToSong[song.title] = song;
+    MetricsTimer timer(MetricId::LOOKUP_ADD);
+    titleToSong[makeKey(song.title)] = song;
     idToSong[song.id] = song;
+    version++;
+}
+
+void SongLookup::addSongs(const std::vector<Song>& songs) {
+    // Grow geometrically: reserving exactly size + k on every batch would
+    // rehash the whole map once per batch
+    size_t needed = titleToSong.size() + songs.size();
+    if (needed > titleToSong.bucket_count() * titleToSong.max_load_factor()) {
+        titleToSong.reserve(std::max(needed, titleToSong.size() * 2));
+        idToSong.reserve(std::max(needed, idToSong.size() * 2));
+    }
+    
+    for (const auto& song : songs) {
+        titleToSong.insert_or_assign(makeKey(song.title), song);
+        idToSong.insert_or_assign(song.id, song);
+    }
+    version++;
+}
+
+void SongLookup::reserve(size_t songCount) {
+    titleToSong.reserve(songCount);
+    idToSong.reserve(songCount);
 }
 
 Song* SongLookup::searchByTitle(const std::string& title) {
-    auto it = titleToSong.find(title);
+    return searchByKey(makeKey(title));
+}
+
+Song* SongLookup::searchByKey(const std::string& key) {
+    MetricsTimer timer(MetricId::LOOKUP_SEARCH);
+    auto it = titleToSong.find(key);
     if (it != titleToSong.end()) {
         return &(it->second);
     }
@@ -15,6 +48,11 @@ Song* SongLookup::searchByTitle(const std::string& title) {
 }
 
 Song* SongLookup::searchById(int id) {
+    return const_cast<Song*>(static_cast<const SongLookup*>(this)->searchById(id));
+}
+
+const Song* SongLookup::searchById(int id) const {
+    MetricsTimer timer(MetricId::LOOKUP_SEARCH);
     auto it = idToSong.find(id);
     if (it != idToSong.end()) {
         return &(it->second);
@@ -23,12 +61,29 @@ Song* SongLookup::searchById(int id) {
 }
 
 void SongLookup::deleteSong(const std::string& title) {
-    auto it = titleToSong.find(title);
+    MetricsTimer timer(MetricId::LOOKUP_DELETE);
+    auto it = titleToSong.find(makeKey(title));
     if (it != titleToSong.end()) {
         int id = it->second.id;
         titleToSong.erase(it);
         idToSong.erase(id);
+        version++;
+    }
+}
+
+bool SongLookup::deleteById(int id) {
+    MetricsTimer timer(MetricId::LOOKUP_DELETE);
+    auto it = idToSong.find(id);
+    if (it == idToSong.end()) return false;
+    
+    // The title slot may hold a different song with the same title
+    auto byTitle = titleToSong.find(makeKey(it->second.title));
+    if (byTitle != titleToSong.end() && byTitle->second.id == id) {
+        titleToSong.erase(byTitle);
     }
+    idToSong.erase(it);
+    version++;
+    return true;
 }
 
 void SongLookup::displayAllSongs() const {
@@ -54,4 +109,18 @@ std::vector<Song> SongLookup::getAllSongs() const {
     }
     
     return songs;
+} 
+
+MemoryUsage SongLookup::getMemoryUsage() const {
+    // Both maps store their own copy of every song
+    MemoryUsage usage;
+    usage.items = titleToSong.size();
+    usage.structureBytes = hashTableBytes(titleToSong) + hashTableBytes(idToSong);
+    for (const auto& entry : titleToSong) {
+        usage.stringBytes += stringHeapBytes(entry.first) + songHeapBytes(entry.second);
+    }
+    for (const auto& entry : idToSong) {
+        usage.stringBytes += songHeapBytes(entry.second);
+    }
+    return usage;
 } 
\ No newline at end of file
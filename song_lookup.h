@@ -2,37 +2,58 @@
 #define SONG_LOOKUP_H
 
 #include "song.h"
+#include "text_normalizer.h"
+#include "memory_usage.h"
 #include <unordered_map>
 #include <string>
 #include <vector>
 
 class SongLookup {
 private:
+    // Titles are keyed by their normalized form, computed once on insertion
     std::unordered_map<std::string, Song> titleToSong;
     std::unordered_map<int, Song> idToSong;
+    TextNormalizer normalizer;
+    unsigned long long version = 0; // bumped on every mutation
     
 public:
     // Constructor
-    SongLookup() = default;
+    explicit SongLookup(const NormalizationOptions& options = NormalizationOptions());
     
     // Core operations
     void addSong(const Song& song);
+    void addSongs(const std::vector<Song>& songs);
+    void reserve(size_t songCount);  // room for songCount songs in total, before a large import
     Song* searchByTitle(const std::string& title);
+    Song* searchByKey(const std::string& key);
     Song* searchById(int id);
+    const Song* searchById(int id) const;
     void deleteSong(const std::string& title);
+    bool deleteById(int id);
+    
+    // Key helpers
+    std::string makeKey(const std::string& title) const { return normalizer.normalize(title); }
+    const TextNormalizer& getNormalizer() const { return normalizer; }
     
     // Utility methods
     void displayAllSongs() const;
     std::vector<Song> getAllSongs() const;
     int getSongCount() const { return titleToSong.size(); }
+    unsigned long long getVersion() const { return version; }
+    MemoryUsage getMemoryUsage() const;
     
     // Time complexity annotations:
-    // addSong: O(1) - hash map insertion
-    // searchByTitle: O(1) - hash map lookup
+    // addSong: O(L) - normalizes the title once, then hash map insertion
+    // addSongs: O(k * L) - reserves once, then inserts k songs
+    // reserve: O(n) - rehashes both maps at most once
+    // searchByTitle: O(L) - normalizes the query once, then hash map lookup
+    // searchByKey: O(1) - hash map lookup on a precomputed key
     // searchById: O(1) - hash map lookup
-    // deleteSong: O(1) - hash map deletion
+    // deleteSong: O(L) - normalization plus hash map deletion
+    // deleteById: O(L) - id lookup, then the title entry if it belongs to that song
     // displayAllSongs: O(n) - needs to traverse all songs
     // getAllSongs: O(n) - needs to copy all songs
+    // getMemoryUsage: O(n) - visits both maps
 };
 
 #endif // SONG_LOOKUP_H 
\ No newline at end of file
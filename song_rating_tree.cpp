@@ -1,8 +1,10 @@
 #include "song_rating_tree.h"
+#include "metrics_registry.h"
+#include "write_ahead_log.h"
 #include <iostream>
 #include <algorithm>
 
-SongRatingTree::SongRatingTree() : root(nullptr) {
+SongRatingTree::SongRatingTree() : root(nullptr), version(0), wal(nullptr), events(nullptr) {
 }
 
 SongRatingTree::~SongRatingTree() {
@@ -90,6 +92,7 @@ void SongRatingTree::inorderTraversal(RatingNode* node, std::vector<std::pair<in
 }
 
 void SongRatingTree::insertSong(const Song& song, int rating) {
+    MetricsTimer timer(MetricId::RATING_INSERT);
     if (rating < 1 || rating > 5) {
         std::cout << "Invalid rating! Must be between 1 and 5.\n";
         return;
@@ -105,9 +108,39 @@ void SongRatingTree::insertSong(const Song& song, int rating) {
         node = findNode(root, rating);
         node->songs.push_back(song);
     }
+    version++;
+    if (wal) wal->logRatingInsert(song, rating);
+    if (events && events->hasSubscribers()) events->publish(EngineEvent(EngineEventType::RATED, song.id, -1, -1, rating));
+}
+
+void SongRatingTree::insertSongs(const std::vector<std::pair<Song, int>>& ratedSongs) {
+    // Resolve each rating bucket once instead of walking the tree per song
+    RatingNode* buckets[6] = {nullptr, nullptr, nullptr, nullptr, nullptr, nullptr};
+    bool publishing = events && events->hasSubscribers();
+    EventBatch batch(publishing ? events : nullptr);
+    
+    for (const auto& ratedSong : ratedSongs) {
+        int rating = ratedSong.second;
+        if (rating < 1 || rating > 5) {
+            continue;
+        }
+        
+        if (!buckets[rating]) {
+            buckets[rating] = findNode(root, rating);
+            if (!buckets[rating]) {
+                root = insertNode(root, rating);
+                buckets[rating] = findNode(root, rating);
+            }
+        }
+        buckets[rating]->songs.push_back(ratedSong.first);
+        if (wal) wal->logRatingInsert(ratedSong.first, rating);
+        if (publishing) events->publish(EngineEvent(EngineEventType::RATED, ratedSong.first.id, -1, -1, rating));
+    }
+    version++;
 }
 
 std::vector<Song> SongRatingTree::searchByRating(int rating) const {
+    MetricsTimer timer(MetricId::RATING_SEARCH);
     if (rating < 1 || rating > 5) {
         return std::vector<Song>();
     }
@@ -119,28 +152,109 @@ std::vector<Song> SongRatingTree::searchByRating(int rating) const {
     return std::vector<Song>();
 }
 
+void SongRatingTree::collectRange(const RatingNode* node, int lowRating, int highRating,
+                                  std::vector<Song>& out) const {
+    if (!node) return;
+    if (lowRating < node->rating) collectRange(node->left, lowRating, highRating, out);
+    if (node->rating >= lowRating && node->rating <= highRating) {
+        out.insert(out.end(), node->songs.begin(), node->songs.end());
+    }
+    if (node->rating < highRating) collectRange(node->right, lowRating, highRating, out);
+}
+
+std::vector<Song> SongRatingTree::songsWithRatingBetween(int lowRating, int highRating) const {
+    MetricsTimer timer(MetricId::RATING_SEARCH);
+    std::vector<Song> result;
+    collectRange(root, lowRating, highRating, result);
+    return result;
+}
+
+bool SongRatingTree::eraseFirst(RatingNode* node, const std::function<bool(const Song&)>& matches,
+                                int& songId, int& rating) {
+    if (!node) return false;
+    if (eraseFirst(node->left, matches, songId, rating)) return true;
+    
+    auto it = std::find_if(node->songs.begin(), node->songs.end(), matches);
+    if (it != node->songs.end()) {
+        songId = it->id;
+        rating = node->rating;
+        node->songs.erase(it);
+        return true;
+    }
+    return eraseFirst(node->right, matches, songId, rating);
+}
+
+void SongRatingTree::dropEmptyBucket(int rating) {
+    RatingNode* node = findNode(root, rating);
+    if (node && node->songs.empty()) {
+        root = deleteNode(root, rating);
+    }
+}
+
 void SongRatingTree::deleteSong(const std::string& songTitle) {
-    // Search through all rating buckets
-    std::vector<std::pair<int, std::vector<Song>>> allRatings;
-    inorderTraversal(root, allRatings);
+    MetricsTimer timer(MetricId::RATING_DELETE);
+    // Erase from the tree's own buckets, in rating order
+    int songId = -1;
+    int rating = 0;
+    bool found = eraseFirst(root, [&songTitle](const Song& song) { return song.title == songTitle; },
+                            songId, rating);
+    if (!found) return;
     
-    for (auto& ratingPair : allRatings) {
-        auto& songs = ratingPair.second;
-        auto it = std::find_if(songs.begin(), songs.end(),
-                              [&songTitle](const Song& song) {
-                                  return song.title == songTitle;
-                              });
-        
-        if (it != songs.end()) {
-            songs.erase(it);
-            
-            // If bucket becomes empty, remove the rating node
-            if (songs.empty()) {
-                root = deleteNode(root, ratingPair.first);
-            }
-            break;
+    // If bucket becomes empty, remove the rating node
+    dropEmptyBucket(rating);
+    version++;
+    if (wal) wal->logRatingDelete(songTitle);
+    if (events && events->hasSubscribers()) {
+        events->publish(EngineEvent(EngineEventType::UNRATED, songId, -1, -1, rating));
+    }
+}
+
+bool SongRatingTree::deleteSongById(int songId) {
+    return deleteSongsById({songId}) > 0;
+}
+
+void SongRatingTree::eraseIds(RatingNode* node, const std::unordered_set<int>& songIds,
+                              std::vector<std::pair<int, int>>& erased) {
+    if (!node) return;
+    eraseIds(node->left, songIds, erased);
+    
+    auto kept = std::remove_if(node->songs.begin(), node->songs.end(), [&](const Song& song) {
+        if (!songIds.count(song.id)) return false;
+        erased.push_back({song.id, node->rating});
+        return true;
+    });
+    node->songs.erase(kept, node->songs.end());
+    
+    eraseIds(node->right, songIds, erased);
+}
+
+size_t SongRatingTree::deleteSongsById(const std::unordered_set<int>& songIds, std::vector<int>* erasedIds) {
+    MetricsTimer timer(MetricId::RATING_DELETE);
+    if (songIds.empty()) return 0;
+    
+    // One pass over every bucket; a song rated more than once sits in several
+    std::vector<std::pair<int, int>> erased; // (song id, rating)
+    eraseIds(root, songIds, erased);
+    if (erased.empty()) return 0;
+    
+    for (int rating = 1; rating <= 5; rating++) {
+        dropEmptyBucket(rating);
+    }
+    version++;
+    
+    std::unordered_set<int> distinctIds;
+    for (const auto& entry : erased) {
+        if (!distinctIds.insert(entry.first).second) continue;
+        if (wal) wal->logRatingDeleteById(entry.first);
+        if (erasedIds) erasedIds->push_back(entry.first);
+    }
+    if (events && events->hasSubscribers()) {
+        EventBatch batch(events);
+        for (const auto& entry : erased) {
+            events->publish(EngineEvent(EngineEventType::UNRATED, entry.first, -1, -1, entry.second));
         }
     }
+    return erased.size();
 }
 
 void SongRatingTree::displayAllRatings() const {
@@ -163,14 +277,39 @@ void SongRatingTree::displayAllRatings() const {
     }
 }
 
-std::vector<std::pair<int, int>> SongRatingTree::getSongCountByRating() const {
-    std::vector<std::pair<int, int>> result;
+std::vector<std::pair<int, std::vector<Song>>> SongRatingTree::getAllRatings() const {
     std::vector<std::pair<int, std::vector<Song>>> allRatings;
     inorderTraversal(root, allRatings);
-    
-    for (const auto& ratingPair : allRatings) {
-        result.push_back({ratingPair.first, static_cast<int>(ratingPair.second.size())});
+    return allRatings;
+}
+
+void SongRatingTree::countBuckets(const RatingNode* node, std::vector<std::pair<int, int>>& result) const {
+    if (node) {
+        countBuckets(node->left, result);
+        result.push_back({node->rating, static_cast<int>(node->songs.size())});
+        countBuckets(node->right, result);
     }
-    
+}
+
+std::vector<std::pair<int, int>> SongRatingTree::getSongCountByRating() const {
+    std::vector<std::pair<int, int>> result;
+    countBuckets(root, result);
     return result;
+}
+
+void SongRatingTree::addMemoryUsage(const RatingNode* node, MemoryUsage& usage) const {
+    if (!node) return;
+    usage.structureBytes += sizeof(RatingNode) + node->songs.capacity() * sizeof(Song);
+    usage.items += node->songs.size();
+    for (const auto& song : node->songs) {
+        usage.stringBytes += songHeapBytes(song);
+    }
+    addMemoryUsage(node->left, usage);
+    addMemoryUsage(node->right, usage);
+}
+
+MemoryUsage SongRatingTree::getMemoryUsage() const {
+    MemoryUsage usage;
+    addMemoryUsage(root, usage);
+    return usage;
 } 
\ No newline at end of file
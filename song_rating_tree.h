@@ -2,8 +2,14 @@
 #define SONG_RATING_TREE_H
 
 #include "song.h"
+#include "memory_usage.h"
+#include "event_bus.h"
 #include <vector>
 #include <string>
+#include <functional>
+#include <unordered_set>
+
+class WriteAheadLog;
 
 // Node structure for BST
 struct RatingNode {
@@ -18,6 +24,9 @@ struct RatingNode {
 class SongRatingTree {
 private:
     RatingNode* root;
+    unsigned long long version; // bumped on every mutation
+    WriteAheadLog* wal;          // optional mutation log, not owned
+    EventBus* events;            // optional change stream, not owned
     
     // Helper methods
     RatingNode* insertNode(RatingNode* node, int rating);
@@ -26,6 +35,12 @@ private:
     RatingNode* findMin(RatingNode* node) const;
     void inorderTraversal(RatingNode* node, std::vector<std::pair<int, std::vector<Song>>>& result) const;
     void clearTree(RatingNode* node);
+    void addMemoryUsage(const RatingNode* node, MemoryUsage& usage) const;
+    void collectRange(const RatingNode* node, int lowRating, int highRating, std::vector<Song>& out) const;
+    void countBuckets(const RatingNode* node, std::vector<std::pair<int, int>>& result) const;
+    bool eraseFirst(RatingNode* node, const std::function<bool(const Song&)>& matches, int& songId, int& rating);
+    void dropEmptyBucket(int rating);
+    void eraseIds(RatingNode* node, const std::unordered_set<int>& songIds, std::vector<std::pair<int, int>>& erased);
     
 public:
     // Constructor and destructor
@@ -34,19 +49,37 @@ public:
     
     // Core operations
     void insertSong(const Song& song, int rating);
+    void insertSongs(const std::vector<std::pair<Song, int>>& ratedSongs);
     std::vector<Song> searchByRating(int rating) const;
-    void deleteSong(const std::string& songTitle);
+    std::vector<Song> songsWithRatingBetween(int lowRating, int highRating) const;  // inclusive, lowest first
+    void deleteSong(const std::string& songTitle);   // first song with this title, lowest rating first
+    bool deleteSongById(int songId);                  // every rating of this song
+    size_t deleteSongsById(const std::unordered_set<int>& songIds,
+                           std::vector<int>* erasedIds = nullptr); // returns ratings removed
+    
+    // Persistence
+    void setWriteAheadLog(WriteAheadLog* log) { wal = log; }
+    
+    // Change events (RATED, UNRATED)
+    void setEventBus(EventBus* bus) { events = bus; }
     
     // Utility methods
     void displayAllRatings() const;
     std::vector<std::pair<int, int>> getSongCountByRating() const;
+    std::vector<std::pair<int, std::vector<Song>>> getAllRatings() const;
+    unsigned long long getVersion() const { return version; }
+    MemoryUsage getMemoryUsage() const;
     
     // Time complexity annotations:
     // insertSong: O(log n) - BST insertion
+    // insertSongs: O(k + log n) - one bucket lookup per distinct rating
     // searchByRating: O(log n) - BST search
-    // deleteSong: O(log n) - BST deletion
+    // songsWithRatingBetween: O(log n + k) - only buckets inside the range are visited
+    // deleteSong / deleteSongById: O(n) - scans the buckets in place, then BST deletion
+    // deleteSongsById: O(n) - one pass for any number of ids
     // displayAllRatings: O(n) - inorder traversal
-    // getSongCountByRating: O(n) - inorder traversal
+    // getSongCountByRating: O(b) - b rating buckets, no songs are copied
+    // getMemoryUsage: O(n) - visits every node and song
 };
 
 #endif // SONG_RATING_TREE_H 
\ No newline at end of file
@@ -1,4 +1,6 @@
 #include "system_snapshot.h"
+#include "library.h"
+#include "metrics_registry.h"
 #include <algorithm>
 #include <iostream>
 
@@ -6,40 +8,114 @@ SystemStats SystemSnapshot::exportSnapshot(const PlaylistEngine& engine,
                                           const PlaybackHistory& history,
                                           const SongRatingTree& ratingTree,
                                           const SongLookup& lookup) {
+    return exportSnapshot(captureState(engine, history, ratingTree, lookup));
+}
+
+SnapshotState SystemSnapshot::captureState(const PlaylistEngine& engine,
+                                           const PlaybackHistory& history,
+                                           const SongRatingTree& ratingTree,
+                                           const SongLookup& lookup) {
+    SnapshotState state;
+    state.playlistSongs = engine.getSongs();
+    state.totalSongsInPlaylist = engine.getSize();
+    state.recentlyPlayed = getRecentlyPlayedSongs(history, 5);
+    state.songCountByRating = ratingTree.getSongCountByRating();
+    state.totalSongsInDatabase = lookup.getSongCount();
+    state.totalPlayedSongs = history.getHistorySize();
+    state.memoryByComponent = getMemoryByComponent(engine, history, ratingTree, lookup);
+    capturePlayStatistics(history, state);
+    return state;
+}
+
+SystemStats SystemSnapshot::exportSnapshot(const SnapshotState& state) {
+    MetricsTimer timer(MetricId::SNAPSHOT_EXPORT);
     SystemStats stats;
     
-    // Get songs from playlist
-    std::vector<Song> playlistSongs = engine.getSongs();
+    // Get top 5 longest songs; the column scan yields ids only
+    if (state.catalogColumns) {
+        stats.topLongestIds = state.catalogColumns->longestSongIds(5);
+    } else {
+        stats.topLongestSongs = getTopLongestSongs(state.playlistSongs, 5);
+    }
     
-    // Get top 5 longest songs
-    stats.topLongestSongs = getTopLongestSongs(playlistSongs, 5);
+    stats.recentlyPlayed = state.recentlyPlayed;
+    for (const auto& pair : state.songCountByRating) {
+        stats.songCountByRating[pair.first] = pair.second;
+    }
     
-    // Get recently played songs
-    stats.recentlyPlayed = getRecentlyPlayedSongs(history, 5);
+    // Get total counts
+    stats.totalSongsInPlaylist = state.totalSongsInPlaylist;
+    stats.totalSongsInDatabase = state.totalSongsInDatabase;
+    stats.totalPlayedSongs = state.totalPlayedSongs;
     
-    // Get song count by rating
-    stats.songCountByRating = getSongCountByRating(ratingTree);
+    // Get heap footprint per component
+    stats.memoryByComponent = state.memoryByComponent;
+    stats.totalMemoryBytes = 0;
+    for (const auto& component : stats.memoryByComponent) {
+        stats.totalMemoryBytes += component.second.totalBytes();
+    }
     
-    // Get total counts
-    stats.totalSongsInPlaylist = engine.getSize();
-    stats.totalSongsInDatabase = lookup.getSongCount();
-    stats.totalPlayedSongs = history.getHistorySize();
+    stats.mostPlayedSongs = state.mostPlayedSongs;
+    stats.mostPlayedArtists = state.mostPlayedArtists;
+    stats.playsPerHour = state.playsPerHour;
+    stats.topTrending = state.topTrending;
+    stats.distinctSongsLastDay = state.distinctSongsLastDay;
+    stats.distinctArtistsLastWeek = state.distinctArtistsLastWeek;
     
+    if (state.catalogColumns) {
+        stats.catalogDurations = state.catalogColumns->summarizeDurations();
+        stats.durationHistogram = state.catalogColumns->durationHistogram(60, 11);
+        stats.topArtists = state.catalogColumns->topArtists(5);
+    }
     return stats;
 }
 
-std::vector<Song> SystemSnapshot::getTopLongestSongs(const std::vector<Song>& songs, int count) {
-    std::vector<Song> sortedSongs = songs;
-    
-    // Sort by duration in descending order
-    std::sort(sortedSongs.begin(), sortedSongs.end(), 
-              [](const Song& a, const Song& b) {
-                  return a.duration > b.duration;
-              });
+SnapshotState SystemSnapshot::captureState(const Library& library) {
+    const PlaylistEngine& engine = library.playlist();
+    const SongFilterIndex& filters = library.filters();
+    const SongColumns& columns = library.columns();
+    SnapshotState state;
     
-    // Return top 'count' songs
-    int actualCount = std::min(count, static_cast<int>(sortedSongs.size()));
-    return std::vector<Song>(sortedSongs.begin(), sortedSongs.begin() + actualCount);
+    // A plain copy of the columns; the scans run later, on whichever thread
+    // calls exportSnapshot
+    state.catalogColumns = columns.scanCopy();
+    state.totalSongsInPlaylist = engine.getSize();
+    state.recentlyPlayed = getRecentlyPlayedSongs(library.history(), 5);
+    state.songCountByRating = library.ratings().getSongCountByRating();
+    state.totalSongsInDatabase = library.lookup().getSongCount();
+    state.totalPlayedSongs = library.history().getHistorySize();
+    state.memoryByComponent = getMemoryByComponent(engine, library.history(), library.ratings(), library.lookup());
+    auto append = [&state](const std::vector<std::pair<std::string, MemoryUsage>>& component) {
+        state.memoryByComponent.insert(state.memoryByComponent.end(), component.begin(), component.end());
+    };
+    append(cachedRows(filterMemory, &filters, filters.getVersion(), [&filters]() {
+        return std::vector<std::pair<std::string, MemoryUsage>>{{"Filter index", filters.getMemoryUsage()}};
+    }));
+    append(cachedRows(columnMemory, &columns, columns.getVersion(), [&columns]() {
+        return std::vector<std::pair<std::string, MemoryUsage>>{{"Catalog columns", columns.getMemoryUsage()}};
+    }));
+    capturePlayStatistics(library.history(), state);
+    return state;
+}
+
+SystemStats SystemSnapshot::exportSnapshot(const Library& library) {
+    SystemStats stats = exportSnapshot(captureState(library));
+    resolveTopLongestSongs(library, stats);
+    return stats;
+}
+
+void SystemSnapshot::resolveTopLongestSongs(const Library& library, SystemStats& stats) {
+    // Songs removed since the columns were copied are skipped
+    stats.topLongestSongs.clear();
+    for (int songId : stats.topLongestIds) {
+        const Song* song = library.lookup().searchById(songId);
+        if (song) stats.topLongestSongs.push_back(*song);
+    }
+}
+
+std::vector<Song> SystemSnapshot::getTopLongestSongs(const std::vector<Song>& songs, int count) {
+    // Only the longest 'count' songs are ordered; ties keep playlist order
+    return sorter.topK(songs, {{SortField::DURATION, false}}, static_cast<size_t>(std::max(count, 0)));
 }
 
 std::vector<Song> SystemSnapshot::getRecentlyPlayedSongs(const PlaybackHistory& history, int count) {
@@ -57,6 +133,63 @@ std::map<int, int> SystemSnapshot::getSongCountByRating(const SongRatingTree& ra
     return ratingCounts;
 }
 
+void SystemSnapshot::capturePlayStatistics(const PlaybackHistory& history, SnapshotState& state) {
+    const PlayStatistics& plays = history.statistics();
+    for (const auto& song : plays.mostPlayedSongs(5)) {
+        state.mostPlayedSongs.push_back({plays.describeSong(song.first), song.second});
+    }
+    state.mostPlayedArtists = plays.mostPlayedArtists(5);
+    state.playsPerHour = plays.playsPerHour(24);
+    state.topTrending = history.heavyHitters().top(5);
+    state.distinctSongsLastDay = history.estimateDistinctSongsLastDay();
+    state.distinctArtistsLastWeek = history.estimateDistinctArtistsLastWeek();
+}
+
+template <typename Measure>
+const std::vector<std::pair<std::string, MemoryUsage>>& SystemSnapshot::cachedRows(MemoryCacheEntry& entry,
+                                                                                  const void* source,
+                                                                                  unsigned long long version,
+                                                                                  Measure measure) {
+    if (entry.rows.empty() || entry.source != source || entry.version != version) {
+        entry.rows = measure();
+        entry.source = source;
+        entry.version = version;
+    }
+    return entry.rows;
+}
+
+std::vector<std::pair<std::string, MemoryUsage>> SystemSnapshot::getMemoryByComponent(const PlaylistEngine& engine,
+                                                                                      const PlaybackHistory& history,
+                                                                                      const SongRatingTree& ratingTree,
+                                                                                      const SongLookup& lookup) {
+    // Walking a component is O(n), so it is only measured again after it changed
+    std::vector<std::pair<std::string, MemoryUsage>> rows;
+    auto append = [&rows](const std::vector<std::pair<std::string, MemoryUsage>>& component) {
+        rows.insert(rows.end(), component.begin(), component.end());
+    };
+    append(cachedRows(engineMemory, &engine, engine.getVersion(), [&engine]() {
+        return std::vector<std::pair<std::string, MemoryUsage>>{
+            {"Playlist", engine.getMemoryUsage()},
+            {"Undo log", engine.getUndoMemoryUsage()},
+        };
+    }));
+    append(cachedRows(historyMemory, &history, history.getVersion(), [&history]() {
+        return std::vector<std::pair<std::string, MemoryUsage>>{
+            {"Playback history", history.getMemoryUsage()},
+            {"Play statistics", history.statistics().getMemoryUsage()},
+            {"Top trending sketch", history.heavyHitters().getMemoryUsage()},
+            {"Play log", history.playLog().getMemoryUsage()},
+        };
+    }));
+    append(cachedRows(ratingMemory, &ratingTree, ratingTree.getVersion(), [&ratingTree]() {
+        return std::vector<std::pair<std::string, MemoryUsage>>{{"Rating tree", ratingTree.getMemoryUsage()}};
+    }));
+    append(cachedRows(lookupMemory, &lookup, lookup.getVersion(), [&lookup]() {
+        return std::vector<std::pair<std::string, MemoryUsage>>{{"Song lookup", lookup.getMemoryUsage()}};
+    }));
+    return rows;
+}
+
 void SystemSnapshot::displaySystemStats(const SystemStats& stats) {
     std::cout << "\n=== System Statistics ===\n";
     std::cout << "Total songs in playlist: " << stats.totalSongsInPlaylist << "\n";
@@ -80,4 +213,42 @@ void SystemSnapshot::displaySystemStats(const SystemStats& stats) {
     for (const auto& pair : stats.songCountByRating) {
         std::cout << "Rating " << pair.first << ": " << pair.second << " songs\n";
     }
+    
+    if (!stats.mostPlayedSongs.empty()) {
+        std::cout << "\nMost played songs:\n";
+        for (const auto& song : stats.mostPlayedSongs) {
+            std::cout << song.first << ": " << song.second << " plays\n";
+        }
+        std::cout << "Most played artists:\n";
+        for (const auto& artist : stats.mostPlayedArtists) {
+            std::cout << artist.first << ": " << artist.second << " plays\n";
+        }
+        size_t lastDay = 0;
+        for (size_t plays : stats.playsPerHour) lastDay += plays;
+        std::cout << "Plays in the last 24 hours: " << lastDay << "\n";
+        std::cout << "Distinct songs in the last 24 hours: ~" << static_cast<long long>(stats.distinctSongsLastDay + 0.5)
+                  << ", distinct artists in the last 7 days: ~"
+                  << static_cast<long long>(stats.distinctArtistsLastWeek + 0.5) << "\n";
+        std::cout << "Top trending (approximate):\n";
+        for (const auto& song : stats.topTrending) {
+            std::cout << song.label << ": " << song.count << " plays (+/- " << song.error << ")\n";
+        }
+    }
+    
+    if (stats.catalogDurations.count > 0) {
+        std::cout << "\nCatalog durations: " << stats.catalogDurations.totalSeconds << "s total, "
+                  << stats.catalogDurations.shortest << "s shortest, " << stats.catalogDurations.longest
+                  << "s longest\n";
+        std::cout << "Top artists:\n";
+        for (const auto& artist : stats.topArtists) {
+            std::cout << artist.first << ": " << artist.second << " songs\n";
+        }
+    }
+    
+    std::cout << "\nMemory by component:\n";
+    for (const auto& component : stats.memoryByComponent) {
+        std::cout << component.first << ": " << component.second.totalBytes() / 1024 << " KB ("
+                  << component.second.items << " items)\n";
+    }
+    std::cout << "Total: " << stats.totalMemoryBytes / 1024 << " KB\n";
 } 
\ No newline at end of file
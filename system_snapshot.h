@@ -6,20 +6,85 @@
 #include "playback_history.h"
 #include "song_rating_tree.h"
 #include "song_lookup.h"
+#include "playlist_sorter.h"
+#include "song_columns.h"
+#include "memory_usage.h"
 #include <vector>
 #include <map>
+#include <memory>
+#include <string>
+#include <utility>
+
+class Library;
 
 // Structure to hold system statistics
 struct SystemStats {
-    std::vector<Song> topLongestSongs;
+    std::vector<Song> topLongestSongs;  // playlist songs; catalog songs in the Library form
     std::vector<Song> recentlyPlayed;
     std::map<int, int> songCountByRating;
     int totalSongsInPlaylist;
     int totalSongsInDatabase;
     int totalPlayedSongs;
+    std::vector<std::pair<std::string, MemoryUsage>> memoryByComponent;
+    size_t totalMemoryBytes;
+    
+    // Play aggregates kept by the history (see PlayStatistics)
+    std::vector<std::pair<std::string, unsigned long long>> mostPlayedSongs;  // "title by artist", plays
+    std::vector<std::pair<std::string, unsigned long long>> mostPlayedArtists;
+    std::vector<size_t> playsPerHour;  // last 24 clock hours, oldest first
+    std::vector<HeavyHitter> topTrending;  // approximate, from the heavy-hitter tracker
+    double distinctSongsLastDay = 0.0;     // HyperLogLog estimates over the last 24 hours / 7 days
+    double distinctArtistsLastWeek = 0.0;
+    
+    // Catalog-wide figures from the library's column store; empty when the
+    // snapshot was taken from the bare components
+    DurationSummary catalogDurations;
+    std::vector<size_t> durationHistogram;  // one-minute bands, the last one open-ended
+    std::vector<std::pair<std::string, size_t>> topArtists;
+    std::vector<int> topLongestIds;  // Library form: found by the scan, resolved to songs afterwards
+};
+
+// Copy of the engine state a snapshot is computed from. Capturing is a
+// plain copy on the owning thread; the stats can then be computed on any
+// thread while the engines keep changing.
+struct SnapshotState {
+    std::vector<Song> playlistSongs;     // only copied when there are no catalog columns
+    std::shared_ptr<const SongColumns> catalogColumns;  // Library form; scanned in exportSnapshot
+    int totalSongsInPlaylist = 0;
+    std::vector<Song> recentlyPlayed;
+    std::vector<std::pair<int, int>> songCountByRating;
+    int totalSongsInDatabase = 0;
+    int totalPlayedSongs = 0;
+    std::vector<std::pair<std::string, MemoryUsage>> memoryByComponent;
+    std::vector<std::pair<std::string, unsigned long long>> mostPlayedSongs;
+    std::vector<std::pair<std::string, unsigned long long>> mostPlayedArtists;
+    std::vector<size_t> playsPerHour;
+    std::vector<HeavyHitter> topTrending;
+    double distinctSongsLastDay = 0.0;
+    double distinctArtistsLastWeek = 0.0;
 };
 
 class SystemSnapshot {
+private:
+    PlaylistSorter sorter;
+    
+    // Memory rows of one component, reused while its version is unchanged
+    struct MemoryCacheEntry {
+        const void* source = nullptr;
+        unsigned long long version = 0;
+        std::vector<std::pair<std::string, MemoryUsage>> rows;
+    };
+    MemoryCacheEntry engineMemory;
+    MemoryCacheEntry historyMemory;
+    MemoryCacheEntry ratingMemory;
+    MemoryCacheEntry lookupMemory;
+    MemoryCacheEntry filterMemory;
+    MemoryCacheEntry columnMemory;
+    
+    template <typename Measure>
+    const std::vector<std::pair<std::string, MemoryUsage>>& cachedRows(MemoryCacheEntry& entry, const void* source,
+                                                                      unsigned long long version, Measure measure);
+
 public:
     // Constructor
     SystemSnapshot() = default;
@@ -30,19 +95,44 @@ public:
                               const SongRatingTree& ratingTree,
                               const SongLookup& lookup);
     
+    // Two-step form of exportSnapshot for background computation
+    SnapshotState captureState(const PlaylistEngine& engine,
+                               const PlaybackHistory& history,
+                               const SongRatingTree& ratingTree,
+                               const SongLookup& lookup);
+    SystemStats exportSnapshot(const SnapshotState& state);
+    
+    // Library form: statistics come from a copy of the column store, so the
+    // playlist is never copied. exportSnapshot(state) only finds the ids of
+    // the longest songs; resolveTopLongestSongs looks them up afterwards, on
+    // the library's thread.
+    SnapshotState captureState(const Library& library);
+    SystemStats exportSnapshot(const Library& library);
+    void resolveTopLongestSongs(const Library& library, SystemStats& stats);
+    
     // Individual statistics methods
     std::vector<Song> getTopLongestSongs(const std::vector<Song>& songs, int count = 5);
     std::vector<Song> getRecentlyPlayedSongs(const PlaybackHistory& history, int count = 5);
     std::map<int, int> getSongCountByRating(const SongRatingTree& ratingTree);
+    void capturePlayStatistics(const PlaybackHistory& history, SnapshotState& state);
+    std::vector<std::pair<std::string, MemoryUsage>> getMemoryByComponent(const PlaylistEngine& engine,
+                                                                          const PlaybackHistory& history,
+                                                                          const SongRatingTree& ratingTree,
+                                                                          const SongLookup& lookup);
     
     // Utility methods
     void displaySystemStats(const SystemStats& stats);
     
     // Time complexity annotations:
-    // exportSnapshot: O(n log n) - dominated by sorting operations
-    // getTopLongestSongs: O(n log n) - sorting by duration
+    // exportSnapshot: O(n log k) - dominated by the top-k selection, or the column scans
+    // captureState: O(n) - copies the playlist and walks every container once
+    // captureState(Library): O(n) - copies the fixed-width columns; memory rows are cached by version
+    // resolveTopLongestSongs: O(k) - id lookups
+    // getTopLongestSongs: O(n log k) - bounded heap of k songs
     // getRecentlyPlayedSongs: O(n) - linear traversal
     // getSongCountByRating: O(n) - tree traversal
+    // capturePlayStatistics: O(k + h + t log t + s * m) - read from the streaming aggregates and sketches
+    // getMemoryByComponent: O(n) - walks every container that changed since the last call, O(1) otherwise
 };
 
 #endif // SYSTEM_SNAPSHOT_H 
\ No newline at end of file
@@ -0,0 +1,83 @@
+#include "task_executor.h"
+#include <algorithm>
+
+TaskExecutor::TaskExecutor(Poster poster, unsigned int threads) : post(std::move(poster)), stopping(false) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned int i = 0; i < threads; i++) {
+        workers.emplace_back(&TaskExecutor::workerLoop, this);
+    }
+}
+
+TaskExecutor::~TaskExecutor() {
+    cancelAll();
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+        queue.clear();
+    }
+    taskAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+CancellationToken TaskExecutor::enqueue(const std::string& kind, std::function<void(const CancellationToken&)> job) {
+    CancellationToken token;
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        auto previous = latestByKind.find(kind);
+        if (previous != latestByKind.end()) {
+            previous->second.cancel();
+        }
+        latestByKind[kind] = token;
+        
+        // Drop queued tasks that can no longer deliver
+        queue.erase(std::remove_if(queue.begin(), queue.end(),
+                                   [](const Task& task) { return task.token.isCancelled(); }),
+                    queue.end());
+        queue.push_back(Task{[job, token]() { job(token); }, token});
+    }
+    taskAvailable.notify_one();
+    return token;
+}
+
+void TaskExecutor::workerLoop() {
+    while (true) {
+        Task task;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            taskAvailable.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (stopping) return;
+            task = std::move(queue.front());
+            queue.pop_front();
+        }
+        
+        if (!task.token.isCancelled()) {
+            task.run();
+        }
+    }
+}
+
+void TaskExecutor::cancel(const std::string& kind) {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    auto it = latestByKind.find(kind);
+    if (it != latestByKind.end()) {
+        it->second.cancel();
+        latestByKind.erase(it);
+    }
+}
+
+void TaskExecutor::cancelAll() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    for (auto& entry : latestByKind) {
+        entry.second.cancel();
+    }
+    latestByKind.clear();
+}
+
+size_t TaskExecutor::getPendingCount() {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    return queue.size();
+}
@@ -0,0 +1,100 @@
+#ifndef TASK_EXECUTOR_H
+#define TASK_EXECUTOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Cancellation flag shared by a task, its result delivery and the executor.
+// Long-running work may poll isCancelled() and return early.
+class CancellationToken {
+private:
+    std::shared_ptr<std::atomic<bool>> flag;
+
+public:
+    CancellationToken() : flag(std::make_shared<std::atomic<bool>>(false)) {}
+    
+    bool isCancelled() const { return flag->load(std::memory_order_acquire); }
+    void cancel() const { flag->store(true, std::memory_order_release); }
+};
+
+// Runs background work on a small thread pool and posts each result back
+// through a caller-supplied function (e.g. onto the Qt event loop).
+//
+// Every task has a kind, such as "sort" or "snapshot". Submitting a task
+// cancels the previous task of the same kind: if it has not started it is
+// dropped, and if it is running its result is discarded. Only the latest
+// request of each kind is ever delivered. Tasks must work on copied state;
+// the executor does not synchronize access to the engines.
+class TaskExecutor {
+public:
+    using Poster = std::function<void(std::function<void()>)>;
+
+private:
+    struct Task {
+        std::function<void()> run;
+        CancellationToken token;
+    };
+    
+    Poster post;
+    std::vector<std::thread> workers;
+    std::mutex queueMutex;
+    std::condition_variable taskAvailable;
+    std::deque<Task> queue;
+    std::unordered_map<std::string, CancellationToken> latestByKind;
+    bool stopping;
+    
+    void workerLoop();
+    CancellationToken enqueue(const std::string& kind, std::function<void(const CancellationToken&)> job);
+
+public:
+    // Constructor and destructor. Without a poster, results are delivered on
+    // the worker thread. threads = 0 uses one per hardware thread.
+    explicit TaskExecutor(Poster poster = Poster(), unsigned int threads = 0);
+    ~TaskExecutor();
+    
+    TaskExecutor(const TaskExecutor&) = delete;
+    TaskExecutor& operator=(const TaskExecutor&) = delete;
+    
+    // Runs work(token) on a worker and then onDone(result) through the
+    // poster, unless a newer task of the same kind was submitted meanwhile
+    template <typename Work, typename Done>
+    CancellationToken submit(const std::string& kind, Work work, Done onDone) {
+        Poster poster = post;
+        return enqueue(kind, [work, onDone, poster](const CancellationToken& token) mutable {
+            auto result = std::make_shared<decltype(work(token))>(work(token));
+            if (token.isCancelled()) return;
+            
+            auto deliver = [onDone, result, token]() mutable {
+                // Checked again here: a newer request may have arrived after the work finished
+                if (!token.isCancelled()) onDone(std::move(*result));
+            };
+            if (poster) {
+                poster(deliver);
+            } else {
+                deliver();
+            }
+        });
+    }
+    
+    void cancel(const std::string& kind);
+    void cancelAll();
+    
+    unsigned int getThreadCount() const { return static_cast<unsigned int>(workers.size()); }
+    size_t getPendingCount();
+    
+    // Time complexity annotations:
+    // submit / cancel: O(1) - plus the queued closure's copy
+    // cancelAll: O(k) - k task kinds seen so far
+    // destructor: cancels pending tasks and waits for running ones
+};
+
+#endif // TASK_EXECUTOR_H
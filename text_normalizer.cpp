@@ -0,0 +1,497 @@
+#include "text_normalizer.h"
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+
+// Canonical decompositions (precomposed letter -> base + combining mark) for
+// Latin-1, Latin Extended-A and Greek. Sorted by composed code point.
+struct Decomposition {
+    char32_t composed;
+    char32_t base;
+    char32_t mark;
+};
+
+const Decomposition kDecompositions[] = {
+    {0x00C0, 0x0041, 0x0300}, {0x00C1, 0x0041, 0x0301}, {0x00C2, 0x0041, 0x0302}, {0x00C3, 0x0041, 0x0303},
+    {0x00C4, 0x0041, 0x0308}, {0x00C5, 0x0041, 0x030A}, {0x00C7, 0x0043, 0x0327}, {0x00C8, 0x0045, 0x0300},
+    {0x00C9, 0x0045, 0x0301}, {0x00CA, 0x0045, 0x0302}, {0x00CB, 0x0045, 0x0308}, {0x00CC, 0x0049, 0x0300},
+    {0x00CD, 0x0049, 0x0301}, {0x00CE, 0x0049, 0x0302}, {0x00CF, 0x0049, 0x0308}, {0x00D1, 0x004E, 0x0303},
+    {0x00D2, 0x004F, 0x0300}, {0x00D3, 0x004F, 0x0301}, {0x00D4, 0x004F, 0x0302}, {0x00D5, 0x004F, 0x0303},
+    {0x00D6, 0x004F, 0x0308}, {0x00D9, 0x0055, 0x0300}, {0x00DA, 0x0055, 0x0301}, {0x00DB, 0x0055, 0x0302},
+    {0x00DC, 0x0055, 0x0308}, {0x00DD, 0x0059, 0x0301}, {0x00E0, 0x0061, 0x0300}, {0x00E1, 0x0061, 0x0301},
+    {0x00E2, 0x0061, 0x0302}, {0x00E3, 0x0061, 0x0303}, {0x00E4, 0x0061, 0x0308}, {0x00E5, 0x0061, 0x030A},
+    {0x00E7, 0x0063, 0x0327}, {0x00E8, 0x0065, 0x0300}, {0x00E9, 0x0065, 0x0301}, {0x00EA, 0x0065, 0x0302},
+    {0x00EB, 0x0065, 0x0308}, {0x00EC, 0x0069, 0x0300}, {0x00ED, 0x0069, 0x0301}, {0x00EE, 0x0069, 0x0302},
+    {0x00EF, 0x0069, 0x0308}, {0x00F1, 0x006E, 0x0303}, {0x00F2, 0x006F, 0x0300}, {0x00F3, 0x006F, 0x0301},
+    {0x00F4, 0x006F, 0x0302}, {0x00F5, 0x006F, 0x0303}, {0x00F6, 0x006F, 0x0308}, {0x00F9, 0x0075, 0x0300},
+    {0x00FA, 0x0075, 0x0301}, {0x00FB, 0x0075, 0x0302}, {0x00FC, 0x0075, 0x0308}, {0x00FD, 0x0079, 0x0301},
+    {0x00FF, 0x0079, 0x0308}, {0x0100, 0x0041, 0x0304}, {0x0101, 0x0061, 0x0304}, {0x0102, 0x0041, 0x0306},
+    {0x0103, 0x0061, 0x0306}, {0x0104, 0x0041, 0x0328}, {0x0105, 0x0061, 0x0328}, {0x0106, 0x0043, 0x0301},
+    {0x0107, 0x0063, 0x0301}, {0x0108, 0x0043, 0x0302}, {0x0109, 0x0063, 0x0302}, {0x010A, 0x0043, 0x0307},
+    {0x010B, 0x0063, 0x0307}, {0x010C, 0x0043, 0x030C}, {0x010D, 0x0063, 0x030C}, {0x010E, 0x0044, 0x030C},
+    {0x010F, 0x0064, 0x030C}, {0x0112, 0x0045, 0x0304}, {0x0113, 0x0065, 0x0304}, {0x0114, 0x0045, 0x0306},
+    {0x0115, 0x0065, 0x0306}, {0x0116, 0x0045, 0x0307}, {0x0117, 0x0065, 0x0307}, {0x0118, 0x0045, 0x0328},
+    {0x0119, 0x0065, 0x0328}, {0x011A, 0x0045, 0x030C}, {0x011B, 0x0065, 0x030C}, {0x011C, 0x0047, 0x0302},
+    {0x011D, 0x0067, 0x0302}, {0x011E, 0x0047, 0x0306}, {0x011F, 0x0067, 0x0306}, {0x0120, 0x0047, 0x0307},
+    {0x0121, 0x0067, 0x0307}, {0x0122, 0x0047, 0x0327}, {0x0123, 0x0067, 0x0327}, {0x0124, 0x0048, 0x0302},
+    {0x0125, 0x0068, 0x0302}, {0x0128, 0x0049, 0x0303}, {0x0129, 0x0069, 0x0303}, {0x012A, 0x0049, 0x0304},
+    {0x012B, 0x0069, 0x0304}, {0x012C, 0x0049, 0x0306}, {0x012D, 0x0069, 0x0306}, {0x012E, 0x0049, 0x0328},
+    {0x012F, 0x0069, 0x0328}, {0x0130, 0x0049, 0x0307}, {0x0134, 0x004A, 0x0302}, {0x0135, 0x006A, 0x0302},
+    {0x0136, 0x004B, 0x0327}, {0x0137, 0x006B, 0x0327}, {0x0139, 0x004C, 0x0301}, {0x013A, 0x006C, 0x0301},
+    {0x013B, 0x004C, 0x0327}, {0x013C, 0x006C, 0x0327}, {0x013D, 0x004C, 0x030C}, {0x013E, 0x006C, 0x030C},
+    {0x0143, 0x004E, 0x0301}, {0x0144, 0x006E, 0x0301}, {0x0145, 0x004E, 0x0327}, {0x0146, 0x006E, 0x0327},
+    {0x0147, 0x004E, 0x030C}, {0x0148, 0x006E, 0x030C}, {0x014C, 0x004F, 0x0304}, {0x014D, 0x006F, 0x0304},
+    {0x014E, 0x004F, 0x0306}, {0x014F, 0x006F, 0x0306}, {0x0150, 0x004F, 0x030B}, {0x0151, 0x006F, 0x030B},
+    {0x0154, 0x0052, 0x0301}, {0x0155, 0x0072, 0x0301}, {0x0156, 0x0052, 0x0327}, {0x0157, 0x0072, 0x0327},
+    {0x0158, 0x0052, 0x030C}, {0x0159, 0x0072, 0x030C}, {0x015A, 0x0053, 0x0301}, {0x015B, 0x0073, 0x0301},
+    {0x015C, 0x0053, 0x0302}, {0x015D, 0x0073, 0x0302}, {0x015E, 0x0053, 0x0327}, {0x015F, 0x0073, 0x0327},
+    {0x0160, 0x0053, 0x030C}, {0x0161, 0x0073, 0x030C}, {0x0162, 0x0054, 0x0327}, {0x0163, 0x0074, 0x0327},
+    {0x0164, 0x0054, 0x030C}, {0x0165, 0x0074, 0x030C}, {0x0168, 0x0055, 0x0303}, {0x0169, 0x0075, 0x0303},
+    {0x016A, 0x0055, 0x0304}, {0x016B, 0x0075, 0x0304}, {0x016C, 0x0055, 0x0306}, {0x016D, 0x0075, 0x0306},
+    {0x016E, 0x0055, 0x030A}, {0x016F, 0x0075, 0x030A}, {0x0170, 0x0055, 0x030B}, {0x0171, 0x0075, 0x030B},
+    {0x0172, 0x0055, 0x0328}, {0x0173, 0x0075, 0x0328}, {0x0174, 0x0057, 0x0302}, {0x0175, 0x0077, 0x0302},
+    {0x0176, 0x0059, 0x0302}, {0x0177, 0x0079, 0x0302}, {0x0178, 0x0059, 0x0308}, {0x0179, 0x005A, 0x0301},
+    {0x017A, 0x007A, 0x0301}, {0x017B, 0x005A, 0x0307}, {0x017C, 0x007A, 0x0307}, {0x017D, 0x005A, 0x030C},
+    {0x017E, 0x007A, 0x030C}, {0x0386, 0x0391, 0x0301}, {0x0388, 0x0395, 0x0301}, {0x0389, 0x0397, 0x0301},
+    {0x038A, 0x0399, 0x0301}, {0x038C, 0x039F, 0x0301}, {0x038E, 0x03A5, 0x0301}, {0x038F, 0x03A9, 0x0301},
+    {0x0390, 0x03CA, 0x0301}, {0x03AA, 0x0399, 0x0308}, {0x03AB, 0x03A5, 0x0308}, {0x03AC, 0x03B1, 0x0301},
+    {0x03AD, 0x03B5, 0x0301}, {0x03AE, 0x03B7, 0x0301}, {0x03AF, 0x03B9, 0x0301}, {0x03B0, 0x03CB, 0x0301},
+    {0x03CA, 0x03B9, 0x0308}, {0x03CB, 0x03C5, 0x0308}, {0x03CC, 0x03BF, 0x0301}, {0x03CD, 0x03C5, 0x0301},
+    {0x03CE, 0x03C9, 0x0301},
+};
+
+const size_t kDecompositionCount = sizeof(kDecompositions) / sizeof(kDecompositions[0]);
+
+const Decomposition* findDecomposition(char32_t cp) {
+    const Decomposition* end = kDecompositions + kDecompositionCount;
+    const Decomposition* it = std::lower_bound(kDecompositions, end, cp,
+                                               [](const Decomposition& d, char32_t value) {
+                                                   return d.composed < value;
+                                               });
+    if (it != end && it->composed == cp) {
+        return it;
+    }
+    return nullptr;
+}
+
+char32_t findComposition(char32_t base, char32_t mark) {
+    static const std::unordered_map<unsigned long long, char32_t> compositions = [] {
+        std::unordered_map<unsigned long long, char32_t> table;
+        for (size_t i = 0; i < kDecompositionCount; i++) {
+            const Decomposition& d = kDecompositions[i];
+            table[(static_cast<unsigned long long>(d.base) << 32) | d.mark] = d.composed;
+        }
+        return table;
+    }();
+    
+    auto it = compositions.find((static_cast<unsigned long long>(base) << 32) | mark);
+    return it != compositions.end() ? it->second : 0;
+}
+
+bool isCombiningMark(char32_t cp) {
+    return (cp >= 0x0300 && cp <= 0x036F) || (cp >= 0x1AB0 && cp <= 0x1AFF) ||
+           (cp >= 0x1DC0 && cp <= 0x1DFF) || (cp >= 0x20D0 && cp <= 0x20FF) ||
+           (cp >= 0xFE20 && cp <= 0xFE2F);
+}
+
+bool isSpace(char32_t cp) {
+    return cp == ' ' || cp == '\t' || cp == '\n' || cp == '\r' || cp == '\v' || cp == '\f';
+}
+
+// Simple case folding for the scripts we decompose. Precomposed letters are
+// decomposed before this runs, so only base letters need mapping here.
+char32_t foldCodePoint(char32_t cp) {
+    if (cp >= 'A' && cp <= 'Z') return cp + 32;
+    if (cp < 0x80) return cp;
+    if (cp >= 0x00C0 && cp <= 0x00DE && cp != 0x00D7) return cp + 32;
+    if (cp == 0x00B5) return 0x03BC;
+    if (cp >= 0x0100 && cp <= 0x017F) {
+        if (cp == 0x0178) return 0x00FF;
+        if (cp == 0x017F) return 's';
+        if ((cp >= 0x0139 && cp <= 0x0148) || (cp >= 0x0179 && cp <= 0x017E)) {
+            return (cp % 2 == 1) ? cp + 1 : cp;
+        }
+        if (cp == 0x0130 || cp == 0x0131 || cp == 0x0138 || cp == 0x0149) return cp;
+        return (cp % 2 == 0) ? cp + 1 : cp;
+    }
+    if (cp >= 0x0391 && cp <= 0x03AB && cp != 0x03A2) return cp + 32;
+    if (cp == 0x03C2) return 0x03C3;
+    if (cp >= 0x0400 && cp <= 0x040F) return cp + 80;
+    if (cp >= 0x0410 && cp <= 0x042F) return cp + 32;
+    if ((cp >= 0x0460 && cp <= 0x0481) || (cp >= 0x048A && cp <= 0x04BF) ||
+        (cp >= 0x04D0 && cp <= 0x052F)) {
+        return (cp % 2 == 0) ? cp + 1 : cp;
+    }
+    if (cp == 0x04C0) return 0x04CF;
+    if (cp >= 0x04C1 && cp <= 0x04CE) return (cp % 2 == 1) ? cp + 1 : cp;
+    return cp;
+}
+
+// Latin spellings for Devanagari letters. Vowel length is not distinguished
+// ("ही" -> "hi"), which matches how Hindi titles are usually romanized.
+const char* devanagariConsonant(char32_t cp) {
+    static const char* const consonants[] = {
+        "k", "kh", "g", "gh", "n",           // 0915-0919
+        "ch", "chh", "j", "jh", "n",         // 091A-091E
+        "t", "th", "d", "dh", "n",           // 091F-0923
+        "t", "th", "d", "dh", "n", "n",      // 0924-0929
+        "p", "ph", "b", "bh", "m",           // 092A-092E
+        "y", "r", "r", "l", "l", "l", "v",   // 092F-0935
+        "sh", "sh", "s", "h"                 // 0936-0939
+    };
+    if (cp >= 0x0915 && cp <= 0x0939) return consonants[cp - 0x0915];
+    return nullptr;
+}
+
+const char* devanagariNuktaConsonant(char32_t base) {
+    switch (base) {
+        case 0x0915: return "q";
+        case 0x0916: return "kh";
+        case 0x0917: return "gh";
+        case 0x091C: return "z";
+        case 0x0921: return "r";
+        case 0x0922: return "rh";
+        case 0x092B: return "f";
+        case 0x092F: return "y";
+        default: return nullptr;
+    }
+}
+
+const char* devanagariVowel(char32_t cp) {
+    switch (cp) {
+        // Independent vowels
+        case 0x0904: case 0x0905: case 0x0906: return "a";
+        case 0x0907: case 0x0908: return "i";
+        case 0x0909: case 0x090A: return "u";
+        case 0x090B: return "ri";
+        case 0x090D: case 0x090E: case 0x090F: return "e";
+        case 0x0910: return "ai";
+        case 0x0911: case 0x0912: case 0x0913: return "o";
+        case 0x0914: return "au";
+        // Dependent vowel signs
+        case 0x093E: return "a";
+        case 0x093F: case 0x0940: return "i";
+        case 0x0941: case 0x0942: return "u";
+        case 0x0943: return "ri";
+        case 0x0945: case 0x0946: case 0x0947: return "e";
+        case 0x0948: return "ai";
+        case 0x0949: case 0x094A: case 0x094B: return "o";
+        case 0x094C: return "au";
+        default: return nullptr;
+    }
+}
+
+bool isDevanagari(char32_t cp) {
+    return cp >= 0x0900 && cp <= 0x097F;
+}
+
+void appendAscii(std::vector<char32_t>& out, const char* text) {
+    while (*text) {
+        out.push_back(static_cast<char32_t>(*text++));
+    }
+}
+
+std::vector<char32_t> decodeUtf8(const std::string& text) {
+    std::vector<char32_t> codePoints;
+    codePoints.reserve(text.size());
+    
+    size_t i = 0;
+    while (i < text.size()) {
+        unsigned char lead = static_cast<unsigned char>(text[i]);
+        int length = 0;
+        char32_t cp = 0;
+        
+        if (lead < 0x80) { cp = lead; length = 1; }
+        else if ((lead & 0xE0) == 0xC0) { cp = lead & 0x1F; length = 2; }
+        else if ((lead & 0xF0) == 0xE0) { cp = lead & 0x0F; length = 3; }
+        else if ((lead & 0xF8) == 0xF0) { cp = lead & 0x07; length = 4; }
+        
+        bool valid = length > 0 && i + length <= text.size();
+        for (int k = 1; valid && k < length; k++) {
+            unsigned char cont = static_cast<unsigned char>(text[i + k]);
+            if ((cont & 0xC0) != 0x80) {
+                valid = false;
+            } else {
+                cp = (cp << 6) | (cont & 0x3F);
+            }
+        }
+        
+        if (valid) {
+            codePoints.push_back(cp);
+            i += length;
+        } else {
+            // Malformed input: substitute and resynchronize on the next byte
+            codePoints.push_back(0xFFFD);
+            i++;
+        }
+    }
+    return codePoints;
+}
+
+std::string encodeUtf8(const std::vector<char32_t>& codePoints) {
+    std::string text;
+    text.reserve(codePoints.size());
+    
+    for (char32_t cp : codePoints) {
+        if (cp < 0x80) {
+            text += static_cast<char>(cp);
+        } else if (cp < 0x800) {
+            text += static_cast<char>(0xC0 | (cp >> 6));
+            text += static_cast<char>(0x80 | (cp & 0x3F));
+        } else if (cp < 0x10000) {
+            text += static_cast<char>(0xE0 | (cp >> 12));
+            text += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (cp & 0x3F));
+        } else {
+            text += static_cast<char>(0xF0 | (cp >> 18));
+            text += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            text += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+    return text;
+}
+
+} // namespace
+
+TextNormalizer::TextNormalizer(const NormalizationOptions& options) : options(options) {
+}
+
+std::string TextNormalizer::normalize(const std::string& text) const {
+    // Most catalog titles are plain ASCII, where only case folding and
+    // whitespace collapsing can change anything: do both in a single pass
+    bool isAscii = std::all_of(text.begin(), text.end(),
+                               [](char c) { return static_cast<unsigned char>(c) < 0x80; });
+    if (isAscii) {
+        return normalizeAscii(text);
+    }
+    
+    std::vector<char32_t> codePoints = decodeUtf8(text);
+    
+    if (options.compatibilityFold) {
+        applyCompatibilityMappings(codePoints);
+    }
+    
+    decompose(codePoints);
+    
+    if (options.caseFold) {
+        foldCase(codePoints);
+    }
+    
+    if (options.stripDiacritics) {
+        removeCombiningMarks(codePoints);
+    } else {
+        compose(codePoints);
+    }
+    
+    if (options.transliterateDevanagari) {
+        transliterate(codePoints);
+    }
+    
+    if (options.collapseWhitespace) {
+        collapseSpaces(codePoints);
+    }
+    
+    return encodeUtf8(codePoints);
+}
+
+std::string TextNormalizer::normalizeAscii(const std::string& text) const {
+    std::string result;
+    result.reserve(text.size());
+    
+    bool inSpace = false;
+    for (char c : text) {
+        if (options.collapseWhitespace && isSpace(static_cast<unsigned char>(c))) {
+            inSpace = !result.empty();
+            continue;
+        }
+        if (inSpace) result += ' ';
+        inSpace = false;
+        result += (options.caseFold && c >= 'A' && c <= 'Z') ? static_cast<char>(c + 32) : c;
+    }
+    return result;
+}
+
+void TextNormalizer::applyCompatibilityMappings(std::vector<char32_t>& codePoints) const {
+    std::vector<char32_t> result;
+    result.reserve(codePoints.size());
+    
+    for (char32_t cp : codePoints) {
+        if (cp >= 0xFF01 && cp <= 0xFF5E) {
+            // Full-width ASCII variants
+            result.push_back(cp - 0xFEE0);
+        } else if (cp == 0x00A0 || cp == 0x3000 || (cp >= 0x2000 && cp <= 0x200A) ||
+                   cp == 0x202F || cp == 0x205F) {
+            result.push_back(' ');
+        } else if (cp == 0x00B2 || cp == 0x00B3) {
+            result.push_back('2' + (cp - 0x00B2));
+        } else if (cp == 0x00B9) {
+            result.push_back('1');
+        } else if (cp >= 0xFB00 && cp <= 0xFB06) {
+            static const char* const ligatures[] = {"ff", "fi", "fl", "ffi", "ffl", "st", "st"};
+            appendAscii(result, ligatures[cp - 0xFB00]);
+        } else if (cp >= 0x0958 && cp <= 0x095F) {
+            // Devanagari nukta letters are composition exclusions: NFKC keeps
+            // them as consonant + U+093C NUKTA
+            static const char32_t bases[] = {0x0915, 0x0916, 0x0917, 0x091C,
+                                             0x0921, 0x0922, 0x092B, 0x092F};
+            result.push_back(bases[cp - 0x0958]);
+            result.push_back(0x093C);
+        } else {
+            result.push_back(cp);
+        }
+    }
+    codePoints.swap(result);
+}
+
+void TextNormalizer::decompose(std::vector<char32_t>& codePoints) const {
+    std::vector<char32_t> result;
+    result.reserve(codePoints.size() + codePoints.size() / 4);
+    
+    for (char32_t cp : codePoints) {
+        // Decompositions can nest (e.g. Greek dialytika with tonos), so peel
+        // marks off until the base no longer decomposes
+        char32_t marks[4];
+        int markCount = 0;
+        const Decomposition* d = findDecomposition(cp);
+        while (d && markCount < 4) {
+            marks[markCount++] = d->mark;
+            cp = d->base;
+            d = findDecomposition(cp);
+        }
+        
+        result.push_back(cp);
+        for (int i = markCount - 1; i >= 0; i--) {
+            result.push_back(marks[i]);
+        }
+    }
+    codePoints.swap(result);
+}
+
+void TextNormalizer::foldCase(std::vector<char32_t>& codePoints) const {
+    std::vector<char32_t> result;
+    result.reserve(codePoints.size());
+    
+    for (char32_t cp : codePoints) {
+        if (cp == 0x00DF || cp == 0x1E9E) {
+            // Full case folding expands sharp s
+            result.push_back('s');
+            result.push_back('s');
+        } else {
+            result.push_back(foldCodePoint(cp));
+        }
+    }
+    codePoints.swap(result);
+}
+
+void TextNormalizer::removeCombiningMarks(std::vector<char32_t>& codePoints) const {
+    codePoints.erase(std::remove_if(codePoints.begin(), codePoints.end(), isCombiningMark),
+                     codePoints.end());
+}
+
+void TextNormalizer::compose(std::vector<char32_t>& codePoints) const {
+    std::vector<char32_t> result;
+    result.reserve(codePoints.size());
+    
+    for (char32_t cp : codePoints) {
+        if (!result.empty() && isCombiningMark(cp)) {
+            char32_t composed = findComposition(result.back(), cp);
+            if (composed != 0) {
+                result.back() = composed;
+                continue;
+            }
+        }
+        result.push_back(cp);
+    }
+    codePoints.swap(result);
+}
+
+void TextNormalizer::transliterate(std::vector<char32_t>& codePoints) const {
+    std::vector<char32_t> result;
+    result.reserve(codePoints.size() * 2);
+    
+    // Hindi drops the inherent vowel at the end of a word ("कल" -> "kal"), so
+    // it is only emitted once we know more of the word follows
+    bool pendingVowel = false;
+    size_t lastConsonantStart = 0;
+    char32_t lastConsonant = 0;
+    
+    for (char32_t cp : codePoints) {
+        // A nukta only modifies the consonant immediately before it
+        char32_t previousConsonant = lastConsonant;
+        lastConsonant = 0;
+        
+        if (!isDevanagari(cp)) {
+            pendingVowel = false;
+            result.push_back(cp);
+            continue;
+        }
+        
+        if (cp >= 0x0958 && cp <= 0x095F) {
+            // Precomposed nukta letter (only seen with compatibilityFold off)
+            static const char32_t bases[] = {0x0915, 0x0916, 0x0917, 0x091C,
+                                             0x0921, 0x0922, 0x092B, 0x092F};
+            if (pendingVowel) result.push_back('a');
+            appendAscii(result, devanagariNuktaConsonant(bases[cp - 0x0958]));
+            pendingVowel = true;
+        } else if (const char* consonant = devanagariConsonant(cp)) {
+            if (pendingVowel) result.push_back('a');
+            lastConsonantStart = result.size();
+            lastConsonant = cp;
+            appendAscii(result, consonant);
+            pendingVowel = true;
+        } else if (cp == 0x093C) {
+            // Nukta changes the sound of the preceding consonant
+            const char* replacement = devanagariNuktaConsonant(previousConsonant);
+            if (replacement) {
+                result.resize(lastConsonantStart);
+                appendAscii(result, replacement);
+            }
+        } else if (cp == 0x094D) {
+            // Virama suppresses the inherent vowel
+            pendingVowel = false;
+        } else if (const char* vowel = devanagariVowel(cp)) {
+            bool isSign = cp >= 0x093E;
+            if (pendingVowel && !isSign) result.push_back('a');
+            appendAscii(result, vowel);
+            pendingVowel = false;
+        } else if (cp == 0x0901 || cp == 0x0902) {
+            if (pendingVowel) result.push_back('a');
+            result.push_back('n');
+            pendingVowel = false;
+        } else if (cp == 0x0903) {
+            if (pendingVowel) result.push_back('a');
+            result.push_back('h');
+            pendingVowel = false;
+        } else if (cp >= 0x0966 && cp <= 0x096F) {
+            pendingVowel = false;
+            result.push_back('0' + (cp - 0x0966));
+        } else if (cp == 0x0950) {
+            pendingVowel = false;
+            appendAscii(result, "om");
+        } else if (cp == 0x0964 || cp == 0x0965) {
+            pendingVowel = false;
+            result.push_back(' ');
+        }
+        // Anything else in the block (e.g. stress marks) has no Latin spelling
+    }
+    codePoints.swap(result);
+}
+
+void TextNormalizer::collapseSpaces(std::vector<char32_t>& codePoints) const {
+    std::vector<char32_t> result;
+    result.reserve(codePoints.size());
+    
+    bool inSpace = false;
+    for (char32_t cp : codePoints) {
+        if (isSpace(cp)) {
+            inSpace = !result.empty();
+        } else {
+            if (inSpace) result.push_back(' ');
+            inSpace = false;
+            result.push_back(cp);
+        }
+    }
+    codePoints.swap(result);
+}
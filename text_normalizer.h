@@ -0,0 +1,52 @@
+#ifndef TEXT_NORMALIZER_H
+#define TEXT_NORMALIZER_H
+
+#include <string>
+#include <vector>
+
+// Options controlling which normalization stages run
+struct NormalizationOptions {
+    bool caseFold = true;                  // "Imagine" -> "imagine", "ß" -> "ss"
+    bool compatibilityFold = true;         // NFKC-style: full-width forms, ligatures, odd spaces
+    bool stripDiacritics = true;           // "Beyoncé" -> "beyonce"
+    bool collapseWhitespace = true;        // trim and squeeze runs of whitespace
+    bool transliterateDevanagari = false;  // "तुम ही हो" -> "tum hi ho"
+};
+
+// Builds comparison keys for song titles and artists. Keys are plain UTF-8
+// strings, so they can be hashed and compared like any other std::string.
+//
+// The Unicode tables cover the scripts in our catalog (Latin-1, Latin
+// Extended-A, Greek, Cyrillic and Devanagari); code points outside those
+// ranges pass through unchanged.
+class TextNormalizer {
+private:
+    NormalizationOptions options;
+
+    // Single-pass path for pure ASCII input
+    std::string normalizeAscii(const std::string& text) const;
+    
+    // Pipeline stages, applied in this order on decoded code points
+    void applyCompatibilityMappings(std::vector<char32_t>& codePoints) const;
+    void decompose(std::vector<char32_t>& codePoints) const;
+    void foldCase(std::vector<char32_t>& codePoints) const;
+    void removeCombiningMarks(std::vector<char32_t>& codePoints) const;
+    void compose(std::vector<char32_t>& codePoints) const;
+    void transliterate(std::vector<char32_t>& codePoints) const;
+    void collapseSpaces(std::vector<char32_t>& codePoints) const;
+
+public:
+    // Constructor
+    explicit TextNormalizer(const NormalizationOptions& options = NormalizationOptions());
+
+    // Core operation
+    std::string normalize(const std::string& text) const;
+
+    // Utility methods
+    const NormalizationOptions& getOptions() const { return options; }
+
+    // Time complexity annotations:
+    // normalize: O(L log T) - L code points, T entries in the decomposition table
+};
+
+#endif // TEXT_NORMALIZER_H
@@ -0,0 +1,546 @@
+#include "write_ahead_log.h"
+#include "mapped_file.h"
+#include "playlist_engine.h"
+#include "playback_history.h"
+#include "song_rating_tree.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+const char* const kDefaultLogPath = "playwise.wal";
+
+namespace {
+
+// Frame layout: [u32 length][u32 crc32] then `length` bytes of
+// [u64 sequence][u8 type][payload]; the crc covers those bytes
+const size_t kFrameHeaderSize = 8;
+const size_t kRecordPrefixSize = 9;
+
+uint32_t crc32(const char* data, size_t size) {
+    static const std::vector<uint32_t> table = [] {
+        std::vector<uint32_t> entries(256);
+        for (uint32_t i = 0; i < 256; i++) {
+            uint32_t value = i;
+            for (int bit = 0; bit < 8; bit++) {
+                value = (value & 1) ? 0xEDB88320u ^ (value >> 1) : value >> 1;
+            }
+            entries[i] = value;
+        }
+        return entries;
+    }();
+    
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; i++) {
+        crc = table[(crc ^ static_cast<unsigned char>(data[i])) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// Bounds-checked reader over one record's payload
+class RecordReader {
+private:
+    const char* cursor;
+    const char* end;
+    bool valid;
+    
+public:
+    RecordReader(const char* data, size_t size) : cursor(data), end(data + size), valid(true) {}
+    
+    template <typename T>
+    T get() {
+        T value = T();
+        if (static_cast<size_t>(end - cursor) < sizeof(T)) {
+            valid = false;
+            return value;
+        }
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return value;
+    }
+    
+    std::string getString() {
+        uint32_t length = get<uint32_t>();
+        if (!valid || static_cast<size_t>(end - cursor) < length) {
+            valid = false;
+            return std::string();
+        }
+        std::string value(cursor, length);
+        cursor += length;
+        return value;
+    }
+    
+    Song getSong() {
+        Song song;
+        song.id = get<int32_t>();
+        song.duration = get<int32_t>();
+        song.addedTime = fromEpochMicros(get<int64_t>());
+        song.title = getString();
+        song.artist = getString();
+        return song;
+    }
+    
+    bool isValid() const { return valid; }
+};
+
+bool syncToDisk(FILE* file) {
+#if defined(_WIN32)
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+} // namespace
+
+WriteAheadLog::WriteAheadLog()
+    : file(nullptr), lastSequence(0), durableSequence(0), syncWaiters(0), stopping(false), failed(false) {
+}
+
+WriteAheadLog::~WriteAheadLog() {
+    close();
+}
+
+size_t WriteAheadLog::scanValidLength(const char* data, size_t size, unsigned long long& sequence) {
+    size_t offset = 0;
+    while (size - offset >= kFrameHeaderSize) {
+        uint32_t length;
+        uint32_t checksum;
+        std::memcpy(&length, data + offset, sizeof(length));
+        std::memcpy(&checksum, data + offset + 4, sizeof(checksum));
+        
+        const char* body = data + offset + kFrameHeaderSize;
+        if (length < kRecordPrefixSize || length > size - offset - kFrameHeaderSize ||
+            crc32(body, length) != checksum) {
+            break;
+        }
+        std::memcpy(&sequence, body, sizeof(sequence));
+        offset += kFrameHeaderSize + length;
+    }
+    return offset;
+}
+
+bool WriteAheadLog::open(const std::string& logPath, const WalOptions& walOptions,
+                         unsigned long long firstSequence) {
+    close();
+    path = logPath;
+    options = walOptions;
+    
+    // Find the end of the last complete record and drop anything after it,
+    // otherwise new records would be appended behind unreadable bytes
+    unsigned long long existingSequence = 0;
+    size_t validLength = 0;
+    bool truncate = false;
+    {
+        MappedFile existing;
+        if (existing.open(path)) {
+            validLength = scanValidLength(existing.data(), existing.size(), existingSequence);
+            truncate = validLength < existing.size();
+        }
+    }
+    if (truncate) {
+        std::error_code error;
+        std::filesystem::resize_file(path, validLength, error);
+        if (error) {
+            return false;
+        }
+    }
+    
+    file = std::fopen(path.c_str(), "ab");
+    if (!file) {
+        return false;
+    }
+    
+    lastSequence = std::max(existingSequence, firstSequence);
+    durableSequence = lastSequence;
+    stopping = false;
+    failed = false;
+    flusher = std::thread(&WriteAheadLog::flusherLoop, this);
+    return true;
+}
+
+void WriteAheadLog::close() {
+    // The flusher runs from open() until here, even after a write failed
+    {
+        std::lock_guard<std::mutex> lock(bufferMutex);
+        stopping = true;
+    }
+    flushRequested.notify_one();
+    if (flusher.joinable()) {
+        flusher.join();
+    }
+    
+    if (file) std::fclose(file);
+    file = nullptr;
+}
+
+void WriteAheadLog::flusherLoop() {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    while (true) {
+        flushRequested.wait_for(lock, std::chrono::milliseconds(options.flushIntervalMs), [this] {
+            // Only wake for waiters when there is something to write, otherwise
+            // this thread would hold the lock and starve the waiter it just released
+            return stopping || (!pending.empty() &&
+                                (syncWaiters > 0 || pending.size() >= options.maxBufferBytes));
+        });
+        
+        if (!pending.empty()) {
+            // Take the whole batch; appenders keep filling the other buffer
+            writing.clear();
+            writing.swap(pending);
+            unsigned long long batchSequence = lastSequence;
+            lock.unlock();
+            
+            bool written;
+            {
+                std::lock_guard<std::mutex> io(ioMutex);
+                written = std::fwrite(writing.data(), 1, writing.size(), file) == writing.size() &&
+                          std::fflush(file) == 0;
+                if (written && options.syncPolicy != WalSyncPolicy::NONE) {
+                    written = syncToDisk(file);
+                }
+            }
+            
+            // A batch that did not reach the disk is never reported durable;
+            // the log stops taking records and sync() returns false
+            lock.lock();
+            if (written) {
+                durableSequence = std::max(durableSequence, batchSequence);
+            } else {
+                failed = true;
+                pending.clear();
+            }
+            flushCompleted.notify_all();
+        }
+        
+        if (stopping && pending.empty()) {
+            break;
+        }
+    }
+}
+
+unsigned long long WriteAheadLog::beginRecord(WalRecordType type, size_t& start) {
+    start = pending.size();
+    unsigned long long sequence = ++lastSequence;
+    
+    char prefix[kFrameHeaderSize + kRecordPrefixSize] = {0};
+    std::memcpy(prefix + kFrameHeaderSize, &sequence, sizeof(sequence));
+    prefix[kFrameHeaderSize + 8] = static_cast<char>(type);
+    pending.append(prefix, sizeof(prefix));
+    return sequence;
+}
+
+void WriteAheadLog::endRecord(size_t start, unsigned long long sequence, std::unique_lock<std::mutex>& lock) {
+    uint32_t length = static_cast<uint32_t>(pending.size() - start - kFrameHeaderSize);
+    uint32_t checksum = crc32(&pending[start + kFrameHeaderSize], length);
+    std::memcpy(&pending[start], &length, sizeof(length));
+    std::memcpy(&pending[start + 4], &checksum, sizeof(checksum));
+    
+    if (options.syncPolicy == WalSyncPolicy::PER_COMMIT) {
+        waitForSequence(sequence, lock);
+    } else if (pending.size() >= options.maxBufferBytes) {
+        flushRequested.notify_one();
+    }
+}
+
+void WriteAheadLog::waitForSequence(unsigned long long sequence, std::unique_lock<std::mutex>& lock) {
+    // Every thread waiting here shares the next write + fsync (group commit)
+    syncWaiters++;
+    flushRequested.notify_one();
+    flushCompleted.wait(lock, [&] { return durableSequence >= sequence || stopping || failed; });
+    syncWaiters--;
+}
+
+void WriteAheadLog::putInt32(int32_t value) {
+    pending.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void WriteAheadLog::putInt64(int64_t value) {
+    pending.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void WriteAheadLog::putString(const std::string& value) {
+    putInt32(static_cast<int32_t>(value.size()));
+    pending.append(value);
+}
+
+void WriteAheadLog::putSong(const Song& song) {
+    putInt32(song.id);
+    putInt32(song.duration);
+    putInt64(toEpochMicros(song.addedTime));
+    putString(song.title);
+    putString(song.artist);
+}
+
+void WriteAheadLog::logPlaylistAdd(const Song& song) {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return;
+    size_t start;
+    unsigned long long sequence = beginRecord(WalRecordType::PLAYLIST_ADD, start);
+    putSong(song);
+    endRecord(start, sequence, lock);
+}
+
+void WriteAheadLog::logPlaylistAppend(const std::vector<Song>& songs) {
+    if (songs.empty()) return;
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return;
+    size_t start;
+    unsigned long long sequence = beginRecord(WalRecordType::PLAYLIST_APPEND, start);
+    putInt32(static_cast<int32_t>(songs.size()));
+    for (const auto& song : songs) {
+        putSong(song);
+    }
+    endRecord(start, sequence, lock);
+}
+
+void WriteAheadLog::logPlaylistDelete(int index) {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return;
+    size_t start;
+    unsigned long long sequence = beginRecord(WalRecordType::PLAYLIST_DELETE, start);
+    putInt32(index);
+    endRecord(start, sequence, lock);
+}
+
+void WriteAheadLog::logPlaylistMove(int fromIndex, int toIndex) {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return;
+    size_t start;
+    unsigned long long sequence = beginRecord(WalRecordType::PLAYLIST_MOVE, start);
+    putInt32(fromIndex);
+    putInt32(toIndex);
+    endRecord(start, sequence, lock);
+}
+
+void WriteAheadLog::logPlaylistReverse() {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return;
+    size_t start;
+    unsigned long long sequence = beginRecord(WalRecordType::PLAYLIST_REVERSE, start);
+    endRecord(start, sequence, lock);
+}
+
+void WriteAheadLog::logPlaylistShuffle(unsigned int seed) {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return;
+    size_t start;
+    unsigned long long sequence = beginRecord(WalRecordType::PLAYLIST_SHUFFLE, start);
+    putInt32(static_cast<int32_t>(seed));
+    endRecord(start, sequence, lock);
+}
+
+void WriteAheadLog::logPlaylistUndo(int count) {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return;
+    size_t start;
+    unsigned long long sequence = beginRecord(WalRecordType::PLAYLIST_UNDO, start);
+    putInt32(count);
+    endRecord(start, sequence, lock);
+}
+
+void WriteAheadLog::logHistoryPlay(const Song& song, std::chrono::system_clock::time_point playedAt) {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return;
+    size_t start;
+    unsigned long long sequence = beginRecord(WalRecordType::HISTORY_PLAY_AT, start);
+    putSong(song);
+    putInt64(toEpochMicros(playedAt));
+    endRecord(start, sequence, lock);
+}
+
+void WriteAheadLog::logHistoryUndo() {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return;
+    size_t start;
+    unsigned long long sequence = beginRecord(WalRecordType::HISTORY_UNDO, start);
+    endRecord(start, sequence, lock);
+}
+
+void WriteAheadLog::logRatingInsert(const Song& song, int rating) {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return;
+    size_t start;
+    unsigned long long sequence = beginRecord(WalRecordType::RATING_INSERT, start);
+    putSong(song);
+    putInt32(rating);
+    endRecord(start, sequence, lock);
+}
+
+void WriteAheadLog::logRatingDelete(const std::string& title) {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return;
+    size_t start;
+    unsigned long long sequence = beginRecord(WalRecordType::RATING_DELETE, start);
+    putString(title);
+    endRecord(start, sequence, lock);
+}
+
+void WriteAheadLog::logRatingDeleteById(int songId) {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return;
+    size_t start;
+    unsigned long long sequence = beginRecord(WalRecordType::RATING_DELETE_ID, start);
+    putInt32(songId);
+    endRecord(start, sequence, lock);
+}
+
+bool WriteAheadLog::sync() {
+    std::unique_lock<std::mutex> lock(bufferMutex);
+    if (!accepting()) return false;
+    waitForSequence(lastSequence, lock);
+    return !failed;
+}
+
+bool WriteAheadLog::checkpoint() {
+    // Lock order is always bufferMutex, then ioMutex
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    std::lock_guard<std::mutex> io(ioMutex);
+    if (!file) return false;
+    
+    // Reopening truncates. If that fails the old handle is kept; the records
+    // it holds are in the snapshot and are skipped on replay by sequence
+    FILE* emptied = std::fopen(path.c_str(), "wb");
+    if (!emptied) return false;
+    std::fclose(file);
+    file = emptied;
+    
+    // Everything up to lastSequence is in the snapshot; sequence numbers keep
+    // increasing so a stale log can never be replayed twice
+    pending.clear();
+    durableSequence = lastSequence;
+    failed = false;
+    flushCompleted.notify_all();
+    return true;
+}
+
+bool WriteAheadLog::hasFailed() {
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    return failed;
+}
+
+unsigned long long WriteAheadLog::getLastSequence() {
+    std::lock_guard<std::mutex> lock(bufferMutex);
+    return lastSequence;
+}
+
+WalReplayResult WriteAheadLog::replay(const std::string& logPath, unsigned long long afterSequence,
+                                      PlaylistEngine& engine, PlaybackHistory& history,
+                                      SongRatingTree& ratingTree) {
+    WalReplayResult result;
+    result.success = true;
+    result.lastSequence = afterSequence;
+    
+    MappedFile log;
+    if (!log.open(logPath)) {
+        return result; // no log yet: nothing to replay
+    }
+    
+    unsigned long long ignored = 0;
+    size_t validLength = scanValidLength(log.data(), log.size(), ignored);
+    result.tornTail = validLength < log.size();
+    
+    int maxId = 0;
+    size_t offset = 0;
+    while (offset < validLength) {
+        uint32_t length;
+        std::memcpy(&length, log.data() + offset, sizeof(length));
+        RecordReader reader(log.data() + offset + kFrameHeaderSize, length);
+        offset += kFrameHeaderSize + length;
+        
+        unsigned long long sequence = reader.get<uint64_t>();
+        WalRecordType type = static_cast<WalRecordType>(reader.get<uint8_t>());
+        if (sequence <= afterSequence) {
+            result.recordsSkipped++;
+            continue;
+        }
+        
+        switch (type) {
+            case WalRecordType::PLAYLIST_ADD: {
+                Song song = reader.getSong();
+                maxId = std::max(maxId, song.id);
+                if (reader.isValid()) engine.addSong(song);
+                break;
+            }
+            case WalRecordType::PLAYLIST_APPEND: {
+                int32_t count = reader.get<int32_t>();
+                std::vector<Song> songs;
+                for (int32_t i = 0; i < count && reader.isValid(); i++) {
+                    songs.push_back(reader.getSong());
+                    maxId = std::max(maxId, songs.back().id);
+                }
+                if (reader.isValid()) engine.addSongs(songs);
+                break;
+            }
+            case WalRecordType::PLAYLIST_DELETE: {
+                int32_t index = reader.get<int32_t>();
+                if (reader.isValid()) engine.deleteSong(index);
+                break;
+            }
+            case WalRecordType::PLAYLIST_MOVE: {
+                int32_t from = reader.get<int32_t>();
+                int32_t to = reader.get<int32_t>();
+                if (reader.isValid()) engine.moveSong(from, to);
+                break;
+            }
+            case WalRecordType::PLAYLIST_REVERSE:
+                engine.reversePlaylist();
+                break;
+            case WalRecordType::PLAYLIST_SHUFFLE: {
+                uint32_t seed = reader.get<uint32_t>();
+                if (reader.isValid()) engine.shuffleWithConstraints(seed);
+                break;
+            }
+            case WalRecordType::PLAYLIST_UNDO: {
+                int32_t count = reader.get<int32_t>();
+                if (reader.isValid()) engine.undoLastNEdits(count);
+                break;
+            }
+            case WalRecordType::HISTORY_PLAY: {
+                Song song = reader.getSong();
+                maxId = std::max(maxId, song.id);
+                if (reader.isValid()) history.addPlayedSong(song);
+                break;
+            }
+            case WalRecordType::HISTORY_PLAY_AT: {
+                Song song = reader.getSong();
+                int64_t playedMicros = reader.get<int64_t>();
+                maxId = std::max(maxId, song.id);
+                if (reader.isValid()) history.addPlayedSong(song, fromEpochMicros(playedMicros));
+                break;
+            }
+            case WalRecordType::HISTORY_UNDO:
+                history.undoLastPlay();
+                break;
+            case WalRecordType::RATING_INSERT: {
+                Song song = reader.getSong();
+                int32_t rating = reader.get<int32_t>();
+                maxId = std::max(maxId, song.id);
+                if (reader.isValid()) ratingTree.insertSong(song, rating);
+                break;
+            }
+            case WalRecordType::RATING_DELETE: {
+                std::string title = reader.getString();
+                if (reader.isValid()) ratingTree.deleteSong(title);
+                break;
+            }
+            case WalRecordType::RATING_DELETE_ID: {
+                int32_t songId = reader.get<int32_t>();
+                if (reader.isValid()) ratingTree.deleteSongById(songId);
+                break;
+            }
+        }
+        
+        result.recordsApplied++;
+        result.lastSequence = sequence;
+    }
+    
+    Song::reserveIdsThrough(maxId);
+    return result;
+}
@@ -0,0 +1,150 @@
+#ifndef WRITE_AHEAD_LOG_H
+#define WRITE_AHEAD_LOG_H
+
+#include "song.h"
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class PlaylistEngine;
+class PlaybackHistory;
+class SongRatingTree;
+
+// Default location of the log, next to kDefaultLibraryPath
+extern const char* const kDefaultLogPath;
+
+// Mutation record types
+enum class WalRecordType : uint8_t {
+    PLAYLIST_ADD = 1,      // song (recorded for undo)
+    PLAYLIST_APPEND,       // song (bulk load, not recorded for undo)
+    PLAYLIST_DELETE,       // index
+    PLAYLIST_MOVE,         // from, to
+    PLAYLIST_REVERSE,
+    PLAYLIST_SHUFFLE,      // seed
+    PLAYLIST_UNDO,         // count
+    HISTORY_PLAY,          // song
+    HISTORY_UNDO,
+    RATING_INSERT,         // song, rating
+    RATING_DELETE,         // title
+    RATING_DELETE_ID,      // song id
+    HISTORY_PLAY_AT        // song, played-at microseconds (HISTORY_PLAY records predate play times)
+};
+
+// When appended records reach the disk
+enum class WalSyncPolicy {
+    PER_COMMIT,  // every mutation waits for the fsync of its group commit
+    INTERVAL,    // a background thread writes and fsyncs every flushIntervalMs
+    NONE         // written every flushIntervalMs, syncing left to the OS
+};
+
+struct WalOptions {
+    WalSyncPolicy syncPolicy = WalSyncPolicy::INTERVAL;
+    int flushIntervalMs = 20;
+    size_t maxBufferBytes = 1 << 20;  // flush early once this much is pending
+};
+
+// Outcome of replaying a log onto restored engines
+struct WalReplayResult {
+    bool success = false;
+    size_t recordsApplied = 0;
+    size_t recordsSkipped = 0;          // already contained in the snapshot
+    unsigned long long lastSequence = 0;
+    bool tornTail = false;              // a partial record was found at the end
+};
+
+// Append-only write-ahead log of engine mutations.
+//
+// Engines with an attached log append a compact binary record for every
+// mutation: [u32 length][u32 crc32][u64 sequence][u8 type][payload]. Appends
+// only encode into an in-memory buffer; a background thread writes batches
+// (group commit) and syncs them according to the policy.
+//
+// Recovery loads the last LibraryStore snapshot and replays every record
+// with a sequence number above the one stored in the snapshot.
+class WriteAheadLog {
+private:
+    std::string path;
+    FILE* file;
+    WalOptions options;
+    
+    // Appenders only ever take bufferMutex
+    std::mutex bufferMutex;
+    std::condition_variable flushRequested;
+    std::condition_variable flushCompleted;
+    std::string pending;
+    unsigned long long lastSequence;
+    unsigned long long durableSequence;
+    int syncWaiters;
+    bool stopping;
+    bool failed;  // a batch could not be written or synced; no more records are taken
+    
+    // File writes and truncation are serialized by ioMutex
+    std::mutex ioMutex;
+    std::string writing;
+    std::thread flusher;
+    
+    // Helper methods
+    bool accepting() const { return file && !failed; }  // caller holds bufferMutex
+    void flusherLoop();
+    unsigned long long beginRecord(WalRecordType type, size_t& start);
+    void endRecord(size_t start, unsigned long long sequence, std::unique_lock<std::mutex>& lock);
+    void waitForSequence(unsigned long long sequence, std::unique_lock<std::mutex>& lock);
+    void putInt32(int32_t value);
+    void putInt64(int64_t value);
+    void putString(const std::string& value);
+    void putSong(const Song& song);
+    static size_t scanValidLength(const char* data, size_t size, unsigned long long& lastSequence);
+    
+public:
+    // Constructor and destructor
+    WriteAheadLog();
+    ~WriteAheadLog();
+    
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog& operator=(const WriteAheadLog&) = delete;
+    
+    // Opens (or creates) the log for appending; a torn tail left by a crash is
+    // cut off. Sequence numbers continue after max(existing, firstSequence).
+    bool open(const std::string& path, const WalOptions& options = WalOptions(),
+              unsigned long long firstSequence = 0);
+    void close();
+    
+    // Mutation records (hot path)
+    void logPlaylistAdd(const Song& song);
+    void logPlaylistAppend(const std::vector<Song>& songs);
+    void logPlaylistDelete(int index);
+    void logPlaylistMove(int fromIndex, int toIndex);
+    void logPlaylistReverse();
+    void logPlaylistShuffle(unsigned int seed);
+    void logPlaylistUndo(int count);
+    void logHistoryPlay(const Song& song, std::chrono::system_clock::time_point playedAt);
+    void logHistoryUndo();
+    void logRatingInsert(const Song& song, int rating);
+    void logRatingDelete(const std::string& title);
+    void logRatingDeleteById(int songId);
+    
+    // Durability
+    bool sync();        // returns once everything logged so far is on disk; false after a write error
+    bool checkpoint();  // empties the log after a snapshot has been saved
+    
+    // Recovery: applies records newer than afterSequence to the engines
+    static WalReplayResult replay(const std::string& path, unsigned long long afterSequence,
+                                  PlaylistEngine& engine, PlaybackHistory& history,
+                                  SongRatingTree& ratingTree);
+    
+    // Utility methods
+    bool isOpen() const { return file != nullptr; }
+    bool hasFailed();   // a write or sync failed; checkpoint() or open() starts over
+    unsigned long long getLastSequence();
+    
+    // Time complexity annotations:
+    // log*: O(record size) - encodes into the pending buffer under a short lock
+    // sync: O(pending bytes) - waits for the next group commit
+    // replay: O(log size) - sequential decode and apply
+};
+
+#endif // WRITE_AHEAD_LOG_H